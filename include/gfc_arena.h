@@ -0,0 +1,53 @@
+#ifndef __GFC_ARENA_H__
+#define __GFC_ARENA_H__
+
+#include "gfc_types.h"
+
+/**
+ * @purpose the GFC Arena is a bump allocator for data that all goes away at the same time,
+ * like everything loaded for a level.  Individual allocations are never freed, the whole arena is reset or freed instead.
+ */
+
+typedef struct GFC_ArenaBlock_S
+{
+    struct GFC_ArenaBlock_S *next;
+    size_t size;                    /**<how many bytes of data follow the block header*/
+    size_t used;                    /**<how many of those have been handed out*/
+}GFC_ArenaBlock;
+
+typedef struct
+{
+    GFC_ArenaBlock *first;          /**<all blocks the arena owns*/
+    GFC_ArenaBlock *current;        /**<the block allocations are being made from*/
+    size_t blockSize;               /**<the default size of a new block*/
+}GFC_Arena;
+
+/**
+ * @brief make a new empty arena
+ * @param blockSize how much memory to reserve at a time.  Allocations larger than this get a block of their own
+ * @return NULL on error, the arena otherwise.  Free with gfc_arena_free()
+ */
+GFC_Arena *gfc_arena_new(size_t blockSize);
+
+/**
+ * @brief free an arena and everything allocated from it
+ * @param arena the arena to free
+ */
+void gfc_arena_free(GFC_Arena *arena);
+
+/**
+ * @brief get memory from an arena
+ * @param arena the arena to allocate from
+ * @param size how many bytes are needed
+ * @return NULL on error, a pointer to the memory otherwise.  It is aligned for any type, but not zeroed
+ */
+void *gfc_arena_alloc(GFC_Arena *arena,size_t size);
+
+/**
+ * @brief release everything allocated from an arena at once, keeping its memory for reuse
+ * @param arena the arena to reset
+ * @note any pointers previously returned from the arena are no longer valid
+ */
+void gfc_arena_reset(GFC_Arena *arena);
+
+#endif
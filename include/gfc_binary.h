@@ -0,0 +1,138 @@
+#ifndef __GFC_BINARY_H__
+#define __GFC_BINARY_H__
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_color.h"
+#include "gfc_shape.h"
+#include "gfc_matrix.h"
+#include "gfc_primitives.h"
+
+/**
+ * @purpose a compact binary encoding for the common gfc value types, for save games and network snapshots
+ * that hold too many values to build json for.
+ * A stream starts with a header giving the format version and a version number chosen by the caller for its own layout.
+ * Values are written back to back with no type tags, so they must be read in the order they were written.
+ * Everything is little endian: floats take 4 bytes, the doubles of Shape and Rect take 8, and arrays are a count followed by the items.
+ * Example:
+ *  writer = gfc_binary_writer_new(SAVE_VERSION);
+ *  gfc_binary_write_vector3d(writer,player->position);
+ *  gfc_binary_write_vector3d_array(writer,path,pathCount);
+ *  data = gfc_binary_writer_get_data(writer,&size);
+ *  ...
+ *  if (gfc_binary_reader_open(&reader,data,size))
+ *  {
+ *      gfc_binary_read_vector3d(&reader,&player->position);
+ *      pathCount = gfc_binary_read_vector3d_array(&reader,path,MAX_PATH);
+ *  }
+ */
+
+#define GFC_BINARY_MAGIC    0x4E494247  /**<"GBIN"*/
+#define GFC_BINARY_VERSION  1
+#define GFC_BINARY_HEADER_SIZE 8        /**<magic, format version and user version*/
+
+typedef struct
+{
+    Uint8 *data;
+    size_t size;            /**<how much has been allocated*/
+    size_t used;            /**<how much has been written*/
+    Uint8 failed;           /**<set if an allocation failed or an array had no values, everything written after that is dropped*/
+}GFC_BinaryWriter;
+
+typedef struct
+{
+    const Uint8 *data;
+    size_t size;
+    size_t position;        /**<where the next value is read from*/
+    Uint16 version;         /**<the user version from the header*/
+    Uint8 failed;           /**<set once a read runs past the end or finds bad data, every read after that fails*/
+}GFC_BinaryReader;
+
+/**
+ * @brief make a new writer and write the stream header
+ * @param version the version of the caller's own data layout, so readers can handle old data
+ * @return NULL on error, the writer otherwise.  Free with gfc_binary_writer_free()
+ */
+GFC_BinaryWriter *gfc_binary_writer_new(Uint16 version);
+
+/**
+ * @brief free a writer and its data
+ * @param writer the writer to free
+ */
+void gfc_binary_writer_free(GFC_BinaryWriter *writer);
+
+/**
+ * @brief get everything written so far
+ * @param writer the writer
+ * @param size [output] how many bytes there are
+ * @return NULL if writing failed, the data otherwise.  It belongs to the writer and moves as more is written
+ */
+const void *gfc_binary_writer_get_data(GFC_BinaryWriter *writer,size_t *size);
+
+/**
+ * @brief start reading a stream, checking its header
+ * @param reader [output] the reader to set up
+ * @param data the stream data.  It is not copied and must remain valid while reading
+ * @param size how big the data is
+ * @return false if the data is not a stream this version can read, true otherwise.  See reader->version for the user version
+ */
+Bool gfc_binary_reader_open(GFC_BinaryReader *reader,const void *data,size_t size);
+
+void gfc_binary_write_uint8(GFC_BinaryWriter *writer,Uint8 value);
+void gfc_binary_write_uint32(GFC_BinaryWriter *writer,Uint32 value);
+void gfc_binary_write_float(GFC_BinaryWriter *writer,float value);
+void gfc_binary_write_double(GFC_BinaryWriter *writer,double value);
+void gfc_binary_write_vector2d(GFC_BinaryWriter *writer,Vector2D v);
+void gfc_binary_write_vector3d(GFC_BinaryWriter *writer,Vector3D v);
+void gfc_binary_write_vector4d(GFC_BinaryWriter *writer,Vector4D v);
+void gfc_binary_write_color(GFC_BinaryWriter *writer,Color color);
+void gfc_binary_write_rect(GFC_BinaryWriter *writer,Rect rect);
+void gfc_binary_write_shape(GFC_BinaryWriter *writer,Shape shape);
+void gfc_binary_write_box(GFC_BinaryWriter *writer,Box box);
+void gfc_binary_write_matrix4(GFC_BinaryWriter *writer,Matrix4 matrix);
+
+/**
+ * @brief write a count and then that many values
+ * @param writer the writer
+ * @param values the values to write
+ * @param count how many there are
+ */
+void gfc_binary_write_float_array(GFC_BinaryWriter *writer,const float *values,Uint32 count);
+void gfc_binary_write_vector2d_array(GFC_BinaryWriter *writer,const Vector2D *values,Uint32 count);
+void gfc_binary_write_vector3d_array(GFC_BinaryWriter *writer,const Vector3D *values,Uint32 count);
+void gfc_binary_write_vector4d_array(GFC_BinaryWriter *writer,const Vector4D *values,Uint32 count);
+void gfc_binary_write_color_array(GFC_BinaryWriter *writer,const Color *values,Uint32 count);
+
+/**
+ * @brief the readers each read the next value
+ * @param reader the reader
+ * @param output [output] where to put the value, it is untouched if the read fails
+ * @return false if there was not enough data or it was invalid, true otherwise
+ */
+Bool gfc_binary_read_uint8(GFC_BinaryReader *reader,Uint8 *output);
+Bool gfc_binary_read_uint32(GFC_BinaryReader *reader,Uint32 *output);
+Bool gfc_binary_read_float(GFC_BinaryReader *reader,float *output);
+Bool gfc_binary_read_double(GFC_BinaryReader *reader,double *output);
+Bool gfc_binary_read_vector2d(GFC_BinaryReader *reader,Vector2D *output);
+Bool gfc_binary_read_vector3d(GFC_BinaryReader *reader,Vector3D *output);
+Bool gfc_binary_read_vector4d(GFC_BinaryReader *reader,Vector4D *output);
+Bool gfc_binary_read_color(GFC_BinaryReader *reader,Color *output);
+Bool gfc_binary_read_rect(GFC_BinaryReader *reader,Rect *output);
+Bool gfc_binary_read_shape(GFC_BinaryReader *reader,Shape *output);
+Bool gfc_binary_read_box(GFC_BinaryReader *reader,Box *output);
+Bool gfc_binary_read_matrix4(GFC_BinaryReader *reader,Matrix4 output);
+
+/**
+ * @brief read an array written by the matching array writer
+ * @param reader the reader
+ * @param output [output] where to put the values
+ * @param maxCount how many values output can hold.  Any more stored than that are skipped
+ * @return how many values were put in output
+ */
+Uint32 gfc_binary_read_float_array(GFC_BinaryReader *reader,float *output,Uint32 maxCount);
+Uint32 gfc_binary_read_vector2d_array(GFC_BinaryReader *reader,Vector2D *output,Uint32 maxCount);
+Uint32 gfc_binary_read_vector3d_array(GFC_BinaryReader *reader,Vector3D *output,Uint32 maxCount);
+Uint32 gfc_binary_read_vector4d_array(GFC_BinaryReader *reader,Vector4D *output,Uint32 maxCount);
+Uint32 gfc_binary_read_color_array(GFC_BinaryReader *reader,Color *output,Uint32 maxCount);
+
+#endif
@@ -7,12 +7,49 @@
 #include "gfc_color.h"
 
 /**
- * @brief extract a vector from json
+ * @brief parse a float from text without going through the C library (no locale, no allocation)
+ * @param text the text to parse, leading whitespace is skipped
+ * @param output [output] the value parsed
+ * @return NULL if there was no number, otherwise a pointer to the text just past it
+ */
+const char *gfc_config_parse_float(const char *text,float *output);
+
+/**
+ * @brief parse a comma separated list of floats, like "1.5, 2, -3e2"
+ * @param text the text to parse
+ * @param output [output] where to store the values, must hold at least count floats
+ * @param count how many values to read
+ * @return how many values were parsed
+ */
+int gfc_config_parse_floats(const char *text,float *output,int count);
+
+/**
+ * @brief get a float from a json number or a string holding one
+ * @return 0 if it was not a number, 1 otherwise
+ */
+int sj_value_as_float(SJson *json,float *output);
+
+/**
+ * @brief extract a vector from json, either an array of numbers or a "x,y,z,w" string
+ * @return 0 if it is not a vector or has too few numbers (output is not changed), 1 otherwise
  */
 int sj_value_as_vector2d(SJson *json,Vector2D *output);
 int sj_value_as_vector3d(SJson *json,Vector3D *output);
 int sj_value_as_vector4d(SJson *json,Vector4D *output);
 
+/**
+ * @brief decode a json array into a caller provided buffer
+ * @param json the array to decode.  For vectors and colors each element is an array or string as above
+ * @param output [output] where to store the values
+ * @param maxCount how many values the output can hold
+ * @return how many values were decoded.  Decoding stops at the first element that is not valid
+ */
+int sj_value_as_float_array(SJson *json,float *output,int maxCount);
+int sj_value_as_vector2d_array(SJson *json,Vector2D *output,int maxCount);
+int sj_value_as_vector3d_array(SJson *json,Vector3D *output,int maxCount);
+int sj_value_as_vector4d_array(SJson *json,Vector4D *output,int maxCount);
+int sj_value_as_color_array(SJson *json,Color *output,int maxCount);
+
 /**
  * @brief convert a vector to json
  */
@@ -1,8 +1,14 @@
 #ifndef __CONFIG_DEF_H__
 #define __CONFIG_DEF_H__
 
+#include <stddef.h>
+
 #include "simple_json.h"
 #include "gfc_types.h"
+#include "gfc_text.h"
+#include "gfc_vector.h"
+#include "gfc_color.h"
+#include "gfc_shape.h"
 
 /**
  * @purpose This will be used to quickly and easily pull config data from json files.
@@ -19,26 +25,196 @@
  * }
  * You can load multiple files that all follow this format and the system will keep track of them and search them all.
  * As long as the list names never repeat, this will work
+ * Each list is indexed by "name" when it is loaded, so lookups by name do not search the list.
+ * Other keys can be indexed the same way with gfc_config_def_register_parameter().
+ */
+
+/**
+ * @brief a def handle refers to one def by number, for save files and code that looks a def up every frame.
+ * The high 32 bits are a hash of the def's name.  Of the low 32 bits, the top bits are an id given to the resource list
+ * when it is first loaded and the rest the def's place in the list.
+ * Resources get their ids in load order and keep them through reloads, so handles are the same from run to run
+ * as long as the same files are loaded in the same order.
+ * If the def at that place no longer has the name the handle was made for, because defs were inserted, removed or
+ * reordered, the def with that name is searched for instead.  A handle to a def without a name only resolves while
+ * the def at its place has no name either.
+ */
+typedef Uint64 GFC_ConfigDefHandle;
+
+#define GFC_CONFIG_DEF_INVALID_HANDLE       0
+#define GFC_CONFIG_DEF_HANDLE_NAME_SHIFT    32
+#define GFC_CONFIG_DEF_HANDLE_ENTRY_BITS    20
+#define GFC_CONFIG_DEF_MAX_ENTRIES          (1 << GFC_CONFIG_DEF_HANDLE_ENTRY_BITS)    /**<defs past this in a list have no handle*/
+#define GFC_CONFIG_DEF_MAX_RESOURCES        ((1 << (32 - GFC_CONFIG_DEF_HANDLE_ENTRY_BITS)) - 1)
+
+typedef void gfc_config_def_change_func(const char *resource,void *data);/**<prototype for a reload subscriber*/
+
+typedef enum
+{
+    CDFT_Int,           /**<int*/
+    CDFT_Uint32,        /**<Uint32*/
+    CDFT_Float,         /**<float*/
+    CDFT_Bool,          /**<Bool*/
+    CDFT_Vector2D,      /**<Vector2D, from an array or "x,y" string*/
+    CDFT_Vector3D,      /**<Vector3D*/
+    CDFT_Vector4D,      /**<Vector4D*/
+    CDFT_Color,         /**<Color, from a 0-255 rgba vector*/
+    CDFT_Rect,          /**<Rect, from an x,y,w,h vector*/
+    CDFT_Shape,         /**<Shape, from an object as read by gfc_shape_from_json()*/
+    CDFT_TextLine       /**<TextLine, from a string*/
+}GFC_ConfigDefFieldType;
+
+/**
+ * @brief describes how one key of a def is stored in a struct
+ */
+typedef struct
+{
+    const char *key;                /**<the def key to read*/
+    size_t offset;                  /**<where the field is in the struct*/
+    GFC_ConfigDefFieldType type;    /**<what the field is*/
+}GFC_ConfigDefField;
+
+/**
+ * @brief fill in a GFC_ConfigDefField for a member of a struct
+ */
+#define gfc_config_def_field(structType,member,key,type) {key,offsetof(structType,member),type}
+
+/**
+ * @brief describes a struct defs can be decoded into
+ * Example:
+ *  typedef struct {TextLine name; int health; Vector2D speed; Color color;}MonsterDef;
+ *  static const GFC_ConfigDefField monster_fields[] = {
+ *      gfc_config_def_field(MonsterDef,name,"name",CDFT_TextLine),
+ *      gfc_config_def_field(MonsterDef,health,"health",CDFT_Int),
+ *      gfc_config_def_field(MonsterDef,speed,"speed",CDFT_Vector2D),
+ *      gfc_config_def_field(MonsterDef,color,"color",CDFT_Color)};
+ *  static const GFC_ConfigDefSchema monster_schema = {"monster",sizeof(MonsterDef),monster_fields,4,NULL};
+ *  const MonsterDef *def = gfc_config_def_get_bound("monsters","orc",&monster_schema);
  */
+typedef struct
+{
+    const char *name;                   /**<for error messages*/
+    size_t size;                        /**<sizeof the struct*/
+    const GFC_ConfigDefField *fields;   /**<the fields to decode*/
+    Uint32 fieldCount;                  /**<how many fields there are*/
+    const void *defaults;               /**<if not NULL, a struct of values for keys a def leaves out, otherwise they are zero*/
+}GFC_ConfigDefSchema;
 
 /**
  * @brief initialize the internals of the config def system
  */
 void gfc_config_def_init();
 
+/**
+ * @brief free every def, resource and bound struct.  Called automatically at exit
+ * @note gfc_config_def_init() must be called again before loading more defs
+ */
+void gfc_config_def_close();
+
+/**
+ * @brief keep compiled copies of def files in a directory so later loads can skip parsing the json.
+ * Defs and name lookups are then served from the memory mapped copies
+ * @param dir the directory to use, it must already exist.  NULL to stop using a cache
+ * @note a compiled copy is used while its size matches the def file and either the crc32 a pak stores for it
+ * or the modification time of a loose file does.  If only the time moved the file is read once to check its crc32,
+ * otherwise the json is parsed and the compiled copy rewritten
+ */
+void gfc_config_def_set_cache_dir(const char *dir);
+
+/**
+ * @brief compile a def file into the cache directory without loading it, for build steps
+ * @param filename the json file to compile, named the same way the game will load it
+ * @return false on error or if no cache directory is set, true otherwise
+ */
+Bool gfc_config_def_compile(const char *filename);
+
 /**
  * @brief load config definition lists for a game resource
  * @param filename the json file containing the info
  */
 void gfc_config_def_load(const char *filename);
 
+/**
+ * @brief load several def files at once, extracting and parsing them on worker threads.
+ * The results are installed in the order given, so it behaves like calling gfc_config_def_load() on each in turn
+ * @param filenames the json files to load
+ * @param count how many files there are
+ */
+void gfc_config_def_load_many(const char **filenames,Uint32 count);
+
+/**
+ * @brief load a file of changes on top of the defs already loaded, such as a mod or a patch.
+ * The file uses the same format.  Each entry is matched to a loaded def by "name" and its keys replace the def's keys,
+ * a key set to null removes it.  Entries with a new name are added to the end of the list and new lists are added whole.
+ * Overlays are applied in the order they are loaded, so later ones win.
+ * @param filename the json file containing the changes
+ * @note the base json is not changed.  A patched def is merged into a copy the first time it is asked for,
+ * so json or bound structs fetched before the overlay may be out of date; fetch them again.
+ */
+void gfc_config_def_load_overlay(const char *filename);
+
+/**
+ * @brief load a def file again after it has changed on disk or in a pak.
+ * The new file is parsed in full first, if it fails to load the old defs are kept.
+ * Only resource lists that changed are rebuilt, with their indices and overlays, and are swapped in together.
+ * Subscribers are then told the name of each resource that changed.
+ * @param filename the file to reload, as it was passed to gfc_config_def_load() or gfc_config_def_load_overlay()
+ * @return false if the file was never loaded or failed to load, true otherwise
+ * @note json and bound structs fetched from a changed resource stay valid but out of date, fetch them again when notified.
+ * The old copies are kept until gfc_config_def_collect() is called
+ */
+Bool gfc_config_def_reload(const char *filename);
+
+/**
+ * @brief free everything reloads and overlays have replaced: old resource lists, merged defs, outgrown bound structs,
+ * and loaded files nothing reads from any more.  Until this is called they are kept, so memory grows with every reload
+ * @note call it at a point where nothing holds json or structs fetched before the last reload or overlay,
+ * such as between levels or after subscribers have fetched their defs again.  Def handles stay valid
+ */
+void gfc_config_def_collect();
+
+/**
+ * @brief reload def files automatically when the pak manager sees them change.  Changes are picked up in gfc_pak_manager_update()
+ * @param enable true to watch, false to stop
+ */
+void gfc_config_def_watch(Bool enable);
+
+/**
+ * @brief be told when a resource list changes in a reload
+ * @param func called with the name of each resource that changed, was added or was removed
+ * @param data passed to func
+ * @note subscribing and unsubscribing are safe from any thread, func is called on the thread doing the reload
+ */
+void gfc_config_def_subscribe(gfc_config_def_change_func *func,void *data);
+
+/**
+ * @brief stop being told about reloaded resources
+ * @param func the function that was subscribed
+ * @param data the data it was subscribed with
+ */
+void gfc_config_def_unsubscribe(gfc_config_def_change_func *func,void *data);
+
+/**
+ * @brief get how many times a resource has been changed by reloads, to check cheaply whether cached data is out of date
+ * @param resource the name of the resource list
+ * @return 0 if not loaded, 1 when first loaded, and one more for each reload that changed it
+ */
+Uint32 gfc_config_def_get_version(const char *resource);
+
+/**
+ * @brief index every def list by another key, so gfc_config_def_get_by_parameter() with that key is a hash lookup
+ * @param parameter the key to index by.  Lists already loaded are indexed right away
+ * @note "name" is always indexed.  Parameters that are not registered still work, but are found by searching the list
+ */
+void gfc_config_def_register_parameter(const char *parameter);
+
 /**
  * @brief get definition information for a given resource by its place in the list
  * @param resource the name of the resource list
  * @param index the search item
  * @return NULL if not found or error, the JSON otherwise.  DO NOT FREE IT, you do not own it.
  */
-SJson *gfc_config_def_get_by_index(const char *resource,Uint8 index);
+SJson *gfc_config_def_get_by_index(const char *resource,Uint32 index);
 
 /**
  * @brief get definition information for a given resource by the "name" key
@@ -54,7 +230,7 @@ SJson *gfc_config_def_get_by_name(const char *resource,const char *name);
  * @param index the search item
  * @return NULL if not found or error, the name of the resource.  DO NOT FREE IT, you do not own it.
  */
-const char *gfc_config_def_get_name_by_index(const char *resource,Uint8 index);
+const char *gfc_config_def_get_name_by_index(const char *resource,Uint32 index);
 
 /**
  * @brief get definition information for a given resource by the parameter key and name value
@@ -81,4 +257,79 @@ SJson *gfc_config_def_get_value(const char *resource, const char *name, const ch
  */
 Uint32 gfc_config_def_get_resource_count(const char *resource);
 
+/**
+ * @brief get the whole list of defs for a resource, with overlays applied
+ * @param resource the name of the resource list
+ * @return NULL if not found or error, the json array otherwise.  DO NOT FREE IT, you do not own it.
+ * @note if overlays have patched or added defs this is a merged copy, made the first time it is asked for.
+ * A later overlay replaces it, so fetch it again after loading one.
+ */
+SJson *gfc_config_def_get_resource_by_name(const char *resource);
+
+/**
+ * @brief decode a def into a struct
+ * @param def the def json
+ * @param schema describes the struct
+ * @param output the struct to fill in, it must be schema->size bytes
+ * @return false on bad parameters, true otherwise.  Keys the def does not have get their default
+ */
+Bool gfc_config_def_bind(SJson *def,const GFC_ConfigDefSchema *schema,void *output);
+
+/**
+ * @brief get a def decoded into a struct, by the "name" key
+ * @param resource the name of the resource list
+ * @param name the def to get
+ * @param schema describes the struct.  It must stay valid while defs are loaded, its address identifies it
+ * @return NULL if not found or error, the decoded struct otherwise.  DO NOT FREE IT, you do not own it.
+ * @note each def is only decoded the first time it is asked for with a schema, later calls return the same struct
+ */
+const void *gfc_config_def_get_bound(const char *resource,const char *name,const GFC_ConfigDefSchema *schema);
+
+/**
+ * @brief get a def decoded into a struct, by its place in the list
+ * @param resource the name of the resource list
+ * @param index the def to get
+ * @param schema describes the struct.  It must stay valid while defs are loaded, its address identifies it
+ * @return NULL if not found or error, the decoded struct otherwise.  DO NOT FREE IT, you do not own it.
+ */
+const void *gfc_config_def_get_bound_by_index(const char *resource,Uint32 index,const GFC_ConfigDefSchema *schema);
+
+/**
+ * @brief get the handle of a def by its "name" key
+ * @param resource the name of the resource list
+ * @param name the name of the def
+ * @return GFC_CONFIG_DEF_INVALID_HANDLE if not found, the handle otherwise
+ */
+GFC_ConfigDefHandle gfc_config_def_get_handle(const char *resource,const char *name);
+
+/**
+ * @brief get the handle of a def by its place in the list
+ * @param resource the name of the resource list
+ * @param index the def's place in the list
+ * @return GFC_CONFIG_DEF_INVALID_HANDLE if not found, the handle otherwise
+ */
+GFC_ConfigDefHandle gfc_config_def_get_handle_by_index(const char *resource,Uint32 index);
+
+/**
+ * @brief get a def by its handle.  While the def has not moved this only checks a hash of its name, with no index lookups
+ * @param handle the handle of the def
+ * @return NULL if the handle does not refer to a loaded def, or the def it named is gone, the JSON otherwise.  DO NOT FREE IT, you do not own it.
+ */
+SJson *gfc_config_def_get_by_handle(GFC_ConfigDefHandle handle);
+
+/**
+ * @brief get the "name" of a def by its handle
+ * @param handle the handle of the def
+ * @return NULL if not found or it has no name, the name otherwise.  DO NOT FREE IT, you do not own it.
+ */
+const char *gfc_config_def_get_name_by_handle(GFC_ConfigDefHandle handle);
+
+/**
+ * @brief get a def decoded into a struct, by its handle
+ * @param handle the handle of the def
+ * @param schema describes the struct
+ * @return NULL if not found or error, the decoded struct otherwise.  DO NOT FREE IT, you do not own it.
+ */
+const void *gfc_config_def_get_bound_by_handle(GFC_ConfigDefHandle handle,const GFC_ConfigDefSchema *schema);
+
 #endif
@@ -0,0 +1,203 @@
+#ifndef __GFC_CONFIG_DEF_CACHE_H__
+#define __GFC_CONFIG_DEF_CACHE_H__
+
+#include "simple_json.h"
+#include "gfc_types.h"
+#include "gfc_json_doc.h"
+
+/**
+ * @purpose the config def cache is a compiled form of a def json file that defs can be read from without parsing text.
+ * The layout of the cache data is:
+ *  GFC_ConfigDefCacheHeader
+ *  GFC_ConfigDefCacheValue[valueCount]        value 0 is the root, the children of an array or object are stored next to each other
+ *  GFC_ConfigDefCacheResource[resourceCount]  every array in the root object, in file order
+ *  GFC_ConfigDefCacheSlot[slotCount]          a hash table of def names for each resource
+ *  char[stringPoolSize]                       null terminated strings and object keys
+ * Values are stored in the native byte order of the machine that compiled the cache and refer to each other by index,
+ * so the data is used straight from a memory mapped file.  The magic doubles as a byte order mark: a cache compiled
+ * with the other byte order reads as GFC_CONFIG_DEF_CACHE_MAGIC_SWAPPED and is rejected, so the json is compiled again.
+ */
+
+#define GFC_CONFIG_DEF_CACHE_MAGIC      0x46454447  /**<"GDEF"*/
+#define GFC_CONFIG_DEF_CACHE_MAGIC_SWAPPED  0x47444546  /**<the magic as read from a cache of the other byte order*/
+#define GFC_CONFIG_DEF_CACHE_VERSION    2
+#define GFC_CONFIG_DEF_CACHE_NO_KEY     0xFFFFFFFF
+
+typedef enum
+{
+    CDCV_Null = 0,
+    CDCV_Bool,          /**<count holds the value*/
+    CDCV_String,        /**<start is the offset in the string pool, count the length*/
+    CDCV_Number,        /**<a string that holds a number*/
+    CDCV_Array,         /**<start is the index of the first child, count how many*/
+    CDCV_Object         /**<like an array, but every child has a key*/
+}GFC_ConfigDefCacheValueType;
+
+typedef struct
+{
+    Uint32 magic;           /**<GFC_CONFIG_DEF_CACHE_MAGIC*/
+    Uint32 version;         /**<GFC_CONFIG_DEF_CACHE_VERSION*/
+    Uint32 sourceCrc;       /**<crc32 of the json text the cache was compiled from*/
+    Uint32 valueCount;      /**<how many values follow the header*/
+    Uint32 resourceCount;   /**<how many resources follow the values*/
+    Uint32 slotCount;       /**<how many name slots follow the resources*/
+    Uint32 stringPoolSize;  /**<how many bytes of strings follow the slots*/
+    Uint32 reserved;
+    Uint64 sourceSize;      /**<size of the json text the cache was compiled from*/
+    Uint64 sourceTime;      /**<modification time in nanoseconds of the json file if it was loose on disk, 0 if it was in a pak*/
+}GFC_ConfigDefCacheHeader;
+
+typedef struct
+{
+    Uint8  type;            /**<GFC_ConfigDefCacheValueType*/
+    Uint8  reserved[3];
+    Uint32 key;             /**<string pool offset of the key if this is a member of an object, GFC_CONFIG_DEF_CACHE_NO_KEY otherwise*/
+    Uint32 start;
+    Uint32 count;
+}GFC_ConfigDefCacheValue;
+
+typedef struct
+{
+    Uint32 list;            /**<index of the array value holding the defs, its key is the resource name*/
+    Uint32 slotStart;       /**<the first slot of this resource's name table*/
+    Uint32 slotCount;       /**<how many slots the table has, a power of two.  0 if no def has a name*/
+    Uint32 reserved;
+}GFC_ConfigDefCacheResource;
+
+typedef struct
+{
+    Uint32 hash;            /**<gfc_config_def_cache_hash() of the name*/
+    Uint32 name;            /**<string pool offset of the name*/
+    Uint32 position;        /**<the place of the def in the list + 1, 0 for an empty slot*/
+}GFC_ConfigDefCacheSlot;
+
+/**
+ * @brief a cache in memory.  All pointers refer into the single data block
+ */
+typedef struct
+{
+    GFC_ConfigDefCacheHeader   *header;
+    GFC_ConfigDefCacheValue    *values;
+    GFC_ConfigDefCacheResource *resources;
+    GFC_ConfigDefCacheSlot     *slots;
+    char                       *strings;
+    void                       *data;     /**<the block that holds the whole cache*/
+    size_t                      size;     /**<size of the block*/
+    Uint8                       mapped;   /**<set if data is a read only memory map of the cache file*/
+}GFC_ConfigDefCache;
+
+/**
+ * @brief hash a def name the way the name tables do
+ * @param name the name to hash
+ * @return the hash
+ */
+Uint32 gfc_config_def_cache_hash(const char *name);
+
+/**
+ * @brief compile a parsed def document into a cache
+ * @param json the root of the document to compile
+ * @param sourceCrc crc32 of the text the json was parsed from
+ * @param sourceSize size of the text the json was parsed from
+ * @param sourceTime modification time in nanoseconds of the file the text came from, 0 if it came from a pak
+ * @return NULL on error, the cache otherwise.  Free with gfc_config_def_cache_free()
+ */
+GFC_ConfigDefCache *gfc_config_def_cache_compile(GFC_JsonValue *json,Uint32 sourceCrc,Uint64 sourceSize,Uint64 sourceTime);
+
+/**
+ * @brief wrap a block of previously saved cache data
+ * @param data the cache data.  On success the cache takes ownership of it, it must have been allocated with malloc
+ * @param size the size of the data
+ * @return NULL if the data is not a valid cache, the cache otherwise
+ */
+GFC_ConfigDefCache *gfc_config_def_cache_from_data(void *data,size_t size);
+
+/**
+ * @brief memory map a cache file
+ * @param filename the cache file
+ * @return NULL if missing or invalid, the cache otherwise
+ */
+GFC_ConfigDefCache *gfc_config_def_cache_load(const char *filename);
+
+/**
+ * @brief write a cache to disk.  It is written beside the file and renamed over it, so caches already mapped are not disturbed
+ * @param cache the cache to save
+ * @param filename where to save it
+ * @return false on error, true otherwise
+ */
+Bool gfc_config_def_cache_save(GFC_ConfigDefCache *cache,const char *filename);
+
+/**
+ * @brief update the source time stored in a cache file, for a json file that was touched but not changed.
+ * The file is replaced like gfc_config_def_cache_save() does, so caches already mapped from it are not changed under them
+ * @param filename the cache file
+ * @param sourceTime the new modification time of the json file
+ * @return false on error, true otherwise
+ */
+Bool gfc_config_def_cache_set_source_time(const char *filename,Uint64 sourceTime);
+
+/**
+ * @brief find a member of an object value by key
+ * @param cache the cache to search
+ * @param object the index of the object value
+ * @param key the key to find
+ * @return 0 if not found or not an object (the root is never a member), the index of the value otherwise
+ */
+Uint32 gfc_config_def_cache_object_get(GFC_ConfigDefCache *cache,Uint32 object,const char *key);
+
+/**
+ * @brief get the text of a string or number value
+ * @param cache the cache to read
+ * @param value the index of the value
+ * @return NULL if not a string or number, the text otherwise.  It lives as long as the cache
+ */
+const char *gfc_config_def_cache_get_string(GFC_ConfigDefCache *cache,Uint32 value);
+
+/**
+ * @brief find one of a cache's resources by name
+ * @param cache the cache to search
+ * @param name the key of the resource in the root object
+ * @return -1 if not found, the index of the resource otherwise
+ */
+Sint32 gfc_config_def_cache_get_resource(GFC_ConfigDefCache *cache,const char *name);
+
+/**
+ * @brief find a def by name in a resource's name table
+ * @param cache the cache to search
+ * @param resource which of the cache's resources to search
+ * @param name the name of the def
+ * @return -1 if not found, the place of the first def with that name in the list otherwise
+ */
+Sint32 gfc_config_def_cache_find(GFC_ConfigDefCache *cache,Uint32 resource,const char *name);
+
+/**
+ * @brief check if two values hold the same json, in the same or different caches
+ * @param a the cache of the first value
+ * @param valueA the index of the first value
+ * @param b the cache of the second value
+ * @param valueB the index of the second value
+ * @return true if they match, object keys may be in any order
+ */
+Bool gfc_config_def_cache_equal(GFC_ConfigDefCache *a,Uint32 valueA,GFC_ConfigDefCache *b,Uint32 valueB);
+
+/**
+ * @brief build json for one value of a cache
+ * @param cache the cache to read
+ * @param value the index of the value
+ * @return NULL on error, the json otherwise.  Free with sj_free()
+ */
+SJson *gfc_config_def_cache_get_json(GFC_ConfigDefCache *cache,Uint32 value);
+
+/**
+ * @brief build the json a cache was compiled from
+ * @param cache the cache to convert
+ * @return NULL on error, the json otherwise.  Free with sj_free()
+ */
+SJson *gfc_config_def_cache_to_json(GFC_ConfigDefCache *cache);
+
+/**
+ * @brief free a cache and its data
+ * @param cache the cache to free
+ */
+void gfc_config_def_cache_free(GFC_ConfigDefCache *cache);
+
+#endif
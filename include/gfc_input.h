@@ -22,11 +22,18 @@ typedef enum
     IET_Release = 3
 }InputEventType;
 
+#define GFC_INPUT_KEY_BITS  (SDL_NUM_SCANCODES + 4)     /**<a bit for every scancode, then one each for shift, alt, ctrl and super*/
+#define GFC_INPUT_KEY_WORDS ((GFC_INPUT_KEY_BITS + 63) / 64)
+#define GFC_INPUT_MAX_BUTTONS 63                        /**<controller buttons past this cannot be bound to commands*/
+#define GFC_INPUT_BUTTON_NEVER GFC_INPUT_MAX_BUTTONS    /**<a button bit that is never set, for commands bound to a button past the limit*/
+
 typedef struct
 {
     Uint32 num_buttons;
     Uint8 *buttons;
     Uint8 *old_buttons;
+    Uint64 button_bits;                 /**<the first GFC_INPUT_MAX_BUTTONS buttons, a bit each*/
+    Uint64 old_button_bits;
     Uint32 num_axis;
     Sint16 *axis_maxes;
     Sint16 *axis;
@@ -35,6 +42,14 @@ typedef struct
     SDL_Joystick *controller;
 }GFC_InputController;
 
+/**
+ * @brief refers to a command by number, so it can be polled without looking its name up.
+ * Handles stay valid as more commands are loaded, and stop resolving once commands are purged
+ */
+typedef Uint32 GFC_InputCommandHandle;
+
+#define GFC_INPUT_COMMAND_INVALID_HANDLE 0
+
 /**
  * @brief Inputs abstract user input collection.  They can be setup to trigger callbacks and/or polled for current state
  */
@@ -45,6 +60,8 @@ typedef struct
     Uint8 controller;                   /**<Index of the controller to use to update this input*/
     List *buttons;                      /**<list of buttons that must be pressed together to count as a single input*/
     List *axes;                         /**<list of axes that must be pressed together to count as a single input*/
+    Uint64 keyMask[GFC_INPUT_KEY_WORDS];/**<keyCodes as a bitset, built when the command is loaded*/
+    Uint64 buttonMask;                  /**<buttons as a bitset, built when the command is loaded*/
     int downCount;
     Uint32 pressTime;                   /**<clock ticks when button was pressed*/
     InputEventType state;               /**<updated each frame*/
@@ -89,6 +106,25 @@ Uint8 gfc_input_command_down(const char *command);
 
 InputEventType gfc_input_command_get_state(const char *command);
 
+/**
+ * @brief get a handle for a command, to look it up once instead of by name every frame
+ * @param command the name of the command
+ * @return GFC_INPUT_COMMAND_INVALID_HANDLE if there is no such command, the handle otherwise
+ */
+GFC_InputCommandHandle gfc_input_command_handle(const char *command);
+
+/**
+ * @brief the same checks as the named versions above, by handle
+ * @param handle the handle of the command to check
+ * @return true if the command is in that state, false otherwise or if the handle is no longer valid
+ */
+Uint8 gfc_input_command_pressed_by_handle(GFC_InputCommandHandle handle);
+Uint8 gfc_input_command_held_by_handle(GFC_InputCommandHandle handle);
+Uint8 gfc_input_command_released_by_handle(GFC_InputCommandHandle handle);
+Uint8 gfc_input_command_down_by_handle(GFC_InputCommandHandle handle);
+
+InputEventType gfc_input_command_get_state_by_handle(GFC_InputCommandHandle handle);
+
 /**
  * @brief report if the key provided has been pressed this frame
  * @param key the name of the key to check
@@ -153,6 +189,21 @@ void gfc_input_set_callbacks(
     void *data
 );
 
+/**
+ * @brief get how many commands use a key
+ * @param keysym the scancode of the key
+ * @return the number of commands bound to the key
+ */
+Uint32 gfc_input_get_count_by_scancode(SDL_Scancode keysym);
+
+/**
+ * @brief get one of the commands that use a key, without allocating anything
+ * @param keysym the scancode of the key
+ * @param n which of the commands to get, in the order they were loaded
+ * @return NULL if n is out of range, the command otherwise
+ */
+Input *gfc_input_get_nth_by_scancode(SDL_Scancode keysym,Uint32 n);
+
 /**
  * @brief check the state of a named axis of a controller
  * @param controllerId the id of the controller to poll
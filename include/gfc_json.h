@@ -0,0 +1,113 @@
+#ifndef __GFC_JSON_H__
+#define __GFC_JSON_H__
+
+#include "gfc_types.h"
+#include "gfc_text.h"
+
+/**
+ * @purpose an event based json parser for files too large to load as a whole json tree.
+ * Text is fed in pieces of any size and the parser calls back for each key and value as it is read,
+ * so a file can be decoded straight into game structures while only a small piece of it is in memory.
+ * Example, for {"monsters":[{"name":"orc","health":12}]} the callbacks are:
+ *  begin_object, key "monsters", begin_array, begin_object, key "name", string "orc", key "health", number "12",
+ *  end_object, end_array, end_object
+ */
+
+/**
+ * @brief what to call as the parser reads json.  Any of them can be NULL to ignore that kind of event.
+ * Each returns true to keep parsing, or false to stop.
+ * Strings and keys are null terminated with escapes decoded, and are only valid during the call.
+ * Numbers are given as their text, so no precision is lost; see gfc_config_parse_float() to read them.
+ */
+typedef struct
+{
+    Bool (*begin_object)(void *data);
+    Bool (*end_object)(void *data);
+    Bool (*begin_array)(void *data);
+    Bool (*end_array)(void *data);
+    Bool (*key)(const char *key,size_t length,void *data);
+    Bool (*string)(const char *str,size_t length,void *data);
+    Bool (*number)(const char *text,size_t length,void *data);
+    Bool (*boolean)(Bool value,void *data);
+    Bool (*null)(void *data);
+}GFC_JsonCallbacks;
+
+typedef struct
+{
+    const GFC_JsonCallbacks *callbacks;
+    void *data;             /**<passed to every callback*/
+    Uint8 *stack;           /**<'{' or '[' for every object and array that is open*/
+    Uint32 depth;           /**<how many are open*/
+    Uint32 stackSize;
+    Uint8 state;            /**<what is expected next*/
+    Uint8 token;            /**<the string, number or literal being read, if any*/
+    Uint8 tokenIsKey;       /**<set if the string being read is an object key*/
+    Uint8 escape;           /**<0 outside an escape, 1 after a backslash, 2-5 while reading \u digits*/
+    Uint32 codePoint;       /**<the \u escape being read*/
+    Uint32 highSurrogate;   /**<first half of a surrogate pair waiting for the second, 0 if none*/
+    char *text;             /**<the token read so far*/
+    size_t textLength;
+    size_t textSize;
+    Uint32 line;            /**<the line being read, for errors*/
+    Uint8 bomRead;          /**<how much of a leading utf-8 byte order mark has been skipped, 0xFF once past the start*/
+    Uint8 failed;
+    TextLine error;         /**<why parsing failed*/
+}GFC_JsonParser;
+
+/**
+ * @brief make a new parser
+ * @param callbacks what to call for each event.  It is not copied and must remain valid while parsing
+ * @param data passed to each callback
+ * @return NULL on error, the parser otherwise.  Free with gfc_json_parser_free()
+ */
+GFC_JsonParser *gfc_json_parser_new(const GFC_JsonCallbacks *callbacks,void *data);
+
+/**
+ * @brief free a parser
+ * @param parser the parser to free
+ */
+void gfc_json_parser_free(GFC_JsonParser *parser);
+
+/**
+ * @brief parse the next piece of json text.  Pieces can split the text anywhere, even in the middle of a string
+ * @param parser the parser to use
+ * @param text the next piece of text
+ * @param length how long the piece is
+ * @return false if the json is invalid or a callback stopped the parse, true otherwise
+ */
+Bool gfc_json_parser_feed(GFC_JsonParser *parser,const char *text,size_t length);
+
+/**
+ * @brief tell the parser there is no more text
+ * @param parser the parser to finish
+ * @return false if the json was invalid or incomplete, true if it held exactly one complete value
+ */
+Bool gfc_json_parser_finish(GFC_JsonParser *parser);
+
+/**
+ * @brief get why a parse failed
+ * @param parser the parser to check
+ * @return the error message, an empty string if there was no error
+ */
+const char *gfc_json_parser_get_error(GFC_JsonParser *parser);
+
+/**
+ * @brief parse json that is already in memory
+ * @param text the json text
+ * @param length how long the text is
+ * @param callbacks what to call for each event
+ * @param data passed to each callback
+ * @return false on error, true otherwise
+ */
+Bool gfc_json_parse_buffer(const char *text,size_t length,const GFC_JsonCallbacks *callbacks,void *data);
+
+/**
+ * @brief parse a json file a piece at a time, read through the pak manager with gfc_pak_stream_open()
+ * @param filename the file to parse
+ * @param callbacks what to call for each event
+ * @param data passed to each callback
+ * @return false on error, true otherwise
+ */
+Bool gfc_json_parse_file(const char *filename,const GFC_JsonCallbacks *callbacks,void *data);
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef __GFC_JSON_DOC_H__
+#define __GFC_JSON_DOC_H__
+
+#include "gfc_types.h"
+#include "gfc_arena.h"
+
+/**
+ * @purpose a read only json tree where every node, key and string of a document comes from one arena.
+ * Parsing is mostly bump allocation, the children of an array or object sit next to each other in memory,
+ * and freeing the document is a single arena release instead of a free per node.
+ * Example:
+ *  doc = gfc_json_doc_load("config/monsters.json");
+ *  health = gfc_json_get_int(gfc_json_object_get(gfc_json_array_get_nth(doc->root,0),"health"),100);
+ *  gfc_json_doc_free(doc);
+ */
+
+typedef enum
+{
+    GJT_Null = 0,
+    GJT_Bool,
+    GJT_Number,         /**<kept as text, like simple_json does*/
+    GJT_String,
+    GJT_Array,
+    GJT_Object
+}GFC_JsonType;
+
+typedef struct GFC_JsonValue_S
+{
+    Uint8 type;                         /**<GFC_JsonType*/
+    Uint8 boolean;                      /**<the value of a GJT_Bool*/
+    Uint32 count;                       /**<how many children an array or object has, or the length of a string or number*/
+    const char *key;                    /**<the key if this is a member of an object, NULL otherwise*/
+    union
+    {
+        const char *text;               /**<a string or number, null terminated*/
+        struct GFC_JsonValue_S *children;/**<the members of an array or object, in order*/
+    }v;
+}GFC_JsonValue;
+
+typedef struct
+{
+    GFC_Arena *arena;                   /**<owns everything in the document*/
+    GFC_JsonValue *root;
+}GFC_JsonDoc;
+
+/**
+ * @brief parse json that is already in memory into a document
+ * @param text the json text
+ * @param length how long the text is
+ * @return NULL on error, the document otherwise.  Free with gfc_json_doc_free()
+ */
+GFC_JsonDoc *gfc_json_doc_parse(const char *text,size_t length);
+
+/**
+ * @brief parse a json file into a document, streamed through the pak manager so the text is never in memory all at once
+ * @param filename the file to load
+ * @return NULL on error, the document otherwise.  Free with gfc_json_doc_free()
+ */
+GFC_JsonDoc *gfc_json_doc_load(const char *filename);
+
+/**
+ * @brief free a document and every value in it
+ * @param doc the document to free
+ */
+void gfc_json_doc_free(GFC_JsonDoc *doc);
+
+/**
+ * @brief get a member of an object by key
+ * @param object the object to search
+ * @param key the key to find
+ * @return NULL if not an object or the key is not found, the value otherwise
+ */
+GFC_JsonValue *gfc_json_object_get(GFC_JsonValue *object,const char *key);
+
+/**
+ * @brief get an item of an array, or a member of an object by position
+ * @param array the array or object
+ * @param n the position of the item
+ * @return NULL if out of range or not an array or object, the value otherwise
+ */
+GFC_JsonValue *gfc_json_array_get_nth(GFC_JsonValue *array,Uint32 n);
+
+/**
+ * @brief get how many items an array or object has
+ * @param value the array or object
+ * @return 0 if empty or not an array or object, the count otherwise
+ */
+Uint32 gfc_json_get_count(GFC_JsonValue *value);
+
+/**
+ * @brief get the text of a string or number
+ * @param value the value to read
+ * @return NULL if not a string or number, the text otherwise.  It lives as long as the document
+ */
+const char *gfc_json_get_string(GFC_JsonValue *value);
+
+/**
+ * @brief read a number as a float.  A string that holds only a number, such as "3", is read as that number
+ * @param value the value to read
+ * @param defaultValue returned if the value is missing or not a number
+ * @return the number
+ */
+float gfc_json_get_float(GFC_JsonValue *value,float defaultValue);
+
+/**
+ * @brief read a number as an int, any fraction is dropped and numbers out of range are clamped to INT_MIN or INT_MAX.
+ * A string that holds only a number, such as "3", is read as that number
+ * @param value the value to read
+ * @param defaultValue returned if the value is missing or not a number
+ * @return the number
+ */
+int gfc_json_get_int(GFC_JsonValue *value,int defaultValue);
+
+/**
+ * @brief read a boolean
+ * @param value the value to read
+ * @param defaultValue returned if the value is missing or not a boolean
+ * @return the value
+ */
+Bool gfc_json_get_bool(GFC_JsonValue *value,Bool defaultValue);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef __GFC_LZ4_H__
+#define __GFC_LZ4_H__
+
+#include "gfc_types.h"
+
+/**
+ * @purpose a small implementation of the LZ4 block format.
+ * It compresses worse than deflate, but decompresses several times faster, which makes it a good fit for
+ * pak entries that are loaded often.  Only raw blocks are supported, not the LZ4 frame format.
+ */
+
+/**
+ * @brief get the largest size compressing a block of data could produce
+ * @param size the size of the data to compress
+ * @return the worst case compressed size
+ */
+size_t gfc_lz4_compress_bound(size_t size);
+
+/**
+ * @brief compress a block of data
+ * @param src the data to compress
+ * @param srcSize how many bytes to compress
+ * @param dst where to write the compressed block
+ * @param dstCapacity how much room there is in dst.  gfc_lz4_compress_bound() is always enough
+ * @return 0 on error or if dst is too small, the size of the compressed block otherwise
+ */
+size_t gfc_lz4_compress(const void *src,size_t srcSize,void *dst,size_t dstCapacity);
+
+/**
+ * @brief decompress a block of data
+ * @param src the compressed block
+ * @param srcSize the size of the compressed block
+ * @param dst where to write the decompressed data
+ * @param dstCapacity how much room there is in dst
+ * @return 0 on error or corrupt data, the number of bytes written to dst otherwise
+ */
+size_t gfc_lz4_decompress(const void *src,size_t srcSize,void *dst,size_t dstCapacity);
+
+#endif
@@ -3,13 +3,45 @@
 
 #include "simple_json.h"
 #include "gfc_types.h"
+#include "gfc_list.h"
+#include "gfc_arena.h"
 
 /**
  * @purpose The Pak manager is meant to obscure game content / assets through zip compression.
  * Pak files (just rename the .zip extenstion to .pak or anything for that matter) are added to the manager.
  * Files can be loaded through the manager where it will first check to see if a file is on disk, and then iterate through all of the registered pak files looking for the file in question before giving up.
+ * How loose files on disk interact with pak contents is controlled by the override policy.
+ * Once initialized, files can be extracted from any thread.  Each extract reads through its own file handle and inflates without holding a lock.
+ * An arena passed to gfc_pak_file_extract_arena() is not thread safe, so give each thread its own.
  */
 
+typedef enum
+{
+    POP_DiskFirst = 0,  /**<loose files on disk override pak contents (default, for development)*/
+    POP_PakFirst,       /**<pak contents win, loose files are only used for files not found in any pak*/
+    POP_PakOnly         /**<the disk is never checked, for shipping builds*/
+}GFC_PakOverridePolicy;
+
+typedef void gfc_pak_change_func(const char *filename,void *data);/**<prototype for a pak change subscriber*/
+
+/**
+ * @brief counters for pak file access, see gfc_pak_stats_get()
+ */
+typedef struct
+{
+    Uint32 extracts;        /**<how many files were requested*/
+    Uint32 failures;        /**<how many of those were not found or failed to load*/
+    Uint32 overrideHits;    /**<how many were served by a loose file overriding a pak entry*/
+    Uint32 diskLoads;       /**<how many were loose files that are in no pak*/
+    Uint32 indexCacheHits;  /**<how many paks were mounted using a cached index*/
+    Uint64 bytesRead;       /**<bytes read from paks and disk*/
+    Uint64 bytesInflated;   /**<bytes produced by decompressing pak entries*/
+    Uint64 lookupTime;      /**<microseconds spent finding files*/
+    Uint64 readTime;        /**<microseconds spent reading files*/
+    Uint64 inflateTime;     /**<microseconds spent decompressing files*/
+    Uint64 totalTime;       /**<microseconds spent in extraction overall*/
+}GFC_PakStats;
+
 /**
  * @brief initialize the internal pak manager, queueing up its cleanup on program exit
  */
@@ -22,6 +54,89 @@ void gfc_pak_manager_init();
  */
 void gfc_pak_manager_add(const char *filename);
 
+/**
+ * @brief register several pak files at once, opening them in parallel
+ * @param filenames the pak files to load.  NULL entries are skipped
+ * @param count how many filenames there are
+ * @note the paks are registered (and so searched) in the order given, same as calling gfc_pak_manager_add() for each
+ */
+void gfc_pak_manager_add_many(const char **filenames,Uint32 count);
+
+/**
+ * @brief set a directory to cache pak indices in
+ * Paks built with gfcpak carry their own index.  For other paks the zip central directory is parsed to build one,
+ * and if a cache directory is set it is saved there so later runs can skip the parse while the pak is unchanged (same size and modification time).
+ * @param dir the directory to use (it must exist), or NULL to disable caching
+ */
+void gfc_pak_manager_set_index_cache_dir(const char *dir);
+
+/**
+ * @brief set how loose files on disk are used relative to the pak files
+ * @param policy the new override policy
+ * @note for POP_DiskFirst, which pak entries have a loose override is snapshot when a pak is added (or when switching to this policy)
+ * Overrides for pak entries created after that will not be seen until the snapshot is refreshed.
+ */
+void gfc_pak_manager_set_override_policy(GFC_PakOverridePolicy policy);
+
+/**
+ * @brief get the current override policy
+ * @return the override policy in use
+ */
+GFC_PakOverridePolicy gfc_pak_manager_get_override_policy();
+
+/**
+ * @brief re-scan the disk for loose files that override entries in the registered pak files
+ * @note only meaningful for POP_DiskFirst.  This probes the disk once for every pak entry.
+ */
+void gfc_pak_manager_refresh_overrides();
+
+/**
+ * @brief start or stop watching the mounted paks and the directories of their entries for changes (linux only, uses inotify)
+ * Paks mounted while watching are watched as well.
+ * @param enable true to start watching, false to stop
+ * @return false if watching is not available, true otherwise
+ */
+Bool gfc_pak_manager_watch(Bool enable);
+
+/**
+ * @brief also watch a directory that was not known when the paks were mounted, such as a newly made override directory
+ * @param dir the directory, relative to the working directory as pak entry names are (no trailing slash)
+ */
+void gfc_pak_manager_watch_dir(const char *dir);
+
+/**
+ * @brief handle any file changes seen since the last call.  Call this once a frame from the main thread while watching
+ * A changed pak has its index re-read and is swapped in, subscribers hear about each entry that was added, changed or removed.
+ * A changed loose file updates the override snapshot for that one file, and subscribers hear about it.
+ * If the system dropped events, every mounted pak whose size or time moved is reloaded and the override snapshots are rescanned.
+ * Extracts keep reading the exact file a pak's index was built from.  If one finds the pak was rewritten in place it fails,
+ * and the next call reloads the pak even when not watching.
+ */
+void gfc_pak_manager_update();
+
+/**
+ * @brief re-read a mounted pak now, the same way gfc_pak_manager_update() does when the watcher sees it change
+ * @param filename the pak, as it was passed to gfc_pak_manager_add()
+ * @return false if no such pak is mounted, true otherwise
+ * @note extracts already running on other threads finish reading the old pak
+ */
+Bool gfc_pak_manager_reload(const char *filename);
+
+/**
+ * @brief be told when a file changes, so it can be reloaded
+ * @param func called from gfc_pak_manager_update() with the name of the changed file
+ * @param data passed to func
+ * @note subscribing and unsubscribing are safe from any thread, even from inside a subscriber
+ */
+void gfc_pak_manager_subscribe(gfc_pak_change_func *func,void *data);
+
+/**
+ * @brief stop being told about file changes
+ * @param func the function that was subscribed
+ * @param data the data it was subscribed with
+ */
+void gfc_pak_manager_unsubscribe(gfc_pak_change_func *func,void *data);
+
 /**
  * @brief extract a file from disk or an archive.
  * @param filename the name of the file to extract
@@ -31,6 +146,195 @@ void gfc_pak_manager_add(const char *filename);
  */
 void *gfc_pak_file_extract(const char *filename,size_t *fileSize);
 
+/**
+ * @brief extract a file into a buffer you provide, so a scratch buffer can be reused between files
+ * @param filename the file to extract
+ * @param buffer where to extract the file to
+ * @param capacity how much room there is in buffer
+ * @return 0 on error, if the file was not found or the buffer is too small, the size of the file otherwise
+ */
+size_t gfc_pak_file_extract_into(const char *filename,void *buffer,size_t capacity);
+
+/**
+ * @brief extract a file into memory allocated from an arena
+ * @param filename the file to extract
+ * @param arena the arena to allocate from.  The data lives until the arena is reset or freed
+ * @param fileSize if provided, this will be populated with the size of the file
+ * @return NULL on error or not found, the file data otherwise (do not free it).  It is followed by a null terminator
+ */
+void *gfc_pak_file_extract_arena(const char *filename,GFC_Arena *arena,size_t *fileSize);
+
+/**
+ * @brief a file being read a piece at a time, see gfc_pak_stream_open()
+ */
+typedef struct GFC_PakStream_S GFC_PakStream;
+
+/**
+ * @brief open a file to read it in pieces instead of extracting it whole, so large files never need to fit in memory at once
+ * Stored and deflated pak entries and loose files are read and decoded as they are consumed.
+ * Lz4 entries and prefetched files are held in memory whole.
+ * @param filename the file to open
+ * @return NULL on error or not found, the stream otherwise.  Close it with gfc_pak_stream_close()
+ */
+GFC_PakStream *gfc_pak_stream_open(const char *filename);
+
+/**
+ * @brief read the next piece of a stream
+ * @param stream the stream to read from
+ * @param buffer where to put the data
+ * @param size how many bytes to read
+ * @return how many bytes were read, 0 at the end of the file or on error.  Less than size only at the end of the file
+ * @note the crc of pak entries is checked once the last byte is read, check gfc_pak_stream_failed() before trusting the data
+ */
+size_t gfc_pak_stream_read(GFC_PakStream *stream,void *buffer,size_t size);
+
+/**
+ * @brief get the extracted size of the file a stream is reading
+ * @param stream the stream to check
+ * @return the size of the whole file
+ */
+size_t gfc_pak_stream_get_size(GFC_PakStream *stream);
+
+/**
+ * @brief check if a stream has hit a read, decode or crc error
+ * @param stream the stream to check
+ * @return true if anything went wrong, false otherwise
+ */
+Bool gfc_pak_stream_failed(GFC_PakStream *stream);
+
+/**
+ * @brief close a stream and free everything it uses
+ * @param stream the stream to close
+ */
+void gfc_pak_stream_close(GFC_PakStream *stream);
+
+/**
+ * @brief start loading files that will be needed soon, such as everything a level is about to load
+ * The operating system is asked to start reading the pak data right away and a background thread extracts the files in order.
+ * A later extract of a prefetched file takes the ready data instead of reading it again.
+ * @param filenames a list of const char * file names, in the order they will be used.  The list and names are copied from, not kept
+ * @note prefetched files that are never extracted stay in memory until gfc_pak_prefetch_clear() is called.
+ * Once the ready files reach the memory limit the background thread waits for some to be taken before loading more
+ */
+void gfc_pak_prefetch(List *filenames);
+
+/**
+ * @brief set how much extracted data prefetching may hold before it waits for files to be taken
+ * @param bytes the limit, 0 for the default of 64MB.  A single file bigger than the limit is still prefetched
+ */
+void gfc_pak_prefetch_set_memory_limit(size_t bytes);
+
+/**
+ * @brief prefetch every file listed in a manifest saved with gfc_pak_access_log_save()
+ * @param filename the manifest file, loaded through the pak manager
+ */
+void gfc_pak_prefetch_manifest(const char *filename);
+
+/**
+ * @brief free any prefetched files that were not used
+ */
+void gfc_pak_prefetch_clear();
+
+/**
+ * @brief start recording the order files are extracted in, for example at the start of a level load
+ */
+void gfc_pak_access_log_begin();
+
+/**
+ * @brief stop recording and save the files extracted since gfc_pak_access_log_begin() as a prefetch manifest
+ * The manifest is json: {"files":["first/file","second/file"]}, each file listed once in the order it was first used.
+ * @param filename where to save the manifest
+ * @return false on error, true otherwise
+ */
+Bool gfc_pak_access_log_save(const char *filename);
+
+/**
+ * @brief check if a file can be extracted, without extracting it
+ * @param filename the file to check for
+ * @return true if gfc_pak_file_extract() would find the file, false otherwise
+ */
+Bool gfc_pak_file_exists(const char *filename);
+
+/**
+ * @brief get the extracted size of a file, without extracting it.  Useful for sizing a buffer for gfc_pak_file_extract_into()
+ * @param filename the file to check
+ * @return 0 if not found, the size of the file otherwise
+ */
+size_t gfc_pak_file_size(const char *filename);
+
+/**
+ * @brief what can be known about a file without extracting it, to tell whether it has changed since it was last read
+ */
+typedef struct
+{
+    size_t size;            /**<the extracted size of the file*/
+    Uint32 crc;             /**<crc32 of the file data if it is in a pak, 0 for a loose file*/
+    Uint64 mtime;           /**<modification time in nanoseconds of a loose file, 0 for a pak entry*/
+    Bool inPak;             /**<set if the file would be extracted from a pak*/
+}GFC_PakFileInfo;
+
+/**
+ * @brief find a file the same way extracting it would, and describe it without reading its data
+ * @param filename the file to check
+ * @param info [output] filled in with what was found
+ * @return false if not found, true otherwise
+ */
+Bool gfc_pak_file_get_info(const char *filename,GFC_PakFileInfo *info);
+
+/**
+ * @brief list the files in the mounted paks that start with a prefix, such as "images/"
+ * Files in subdirectories are included, as the match is on the start of the name only.  Loose files on disk are not listed.
+ * @param prefix the start of the names to list (case insensitive).  An empty string lists everything
+ * @return NULL on error, a list of char * file names otherwise.  The list owns copies of the names, so they stay valid across reloads.
+ * Free it with gfc_list_foreach(list,free) then gfc_list_delete(list)
+ */
+List *gfc_pak_list_dir(const char *prefix);
+
+/**
+ * @brief turn the collection of pak access statistics on or off.  It is off by default
+ * @param enable if true every extract is timed and recorded until it is turned off
+ * @note each recorded extract is kept for gfc_pak_stats_save_trace(), call gfc_pak_stats_reset() between profiling runs
+ */
+void gfc_pak_stats_enable(Bool enable);
+
+/**
+ * @brief clear all collected statistics and recorded extracts
+ */
+void gfc_pak_stats_reset();
+
+/**
+ * @brief get the statistics totalled over every extract since the last reset
+ * @param stats [output] the totals are written here
+ */
+void gfc_pak_stats_get(GFC_PakStats *stats);
+
+/**
+ * @brief get the statistics for one file since the last reset
+ * @param filename the file in question
+ * @param stats [output] the totals for that file are written here
+ * @return false if the file was not extracted while collecting, true otherwise
+ */
+Bool gfc_pak_stats_get_file(const char *filename,GFC_PakStats *stats);
+
+/**
+ * @brief write every recorded extract as a Chrome trace event file (open it in chrome://tracing or Perfetto)
+ * Each extract is shown on the timeline of the thread that made it, broken down into lookup, read and inflate.
+ * @param filename the file to write to
+ * @return false on error, true otherwise
+ */
+Bool gfc_pak_stats_save_trace(const char *filename);
+
+/**
+ * @brief decode the raw data of a pak entry
+ * @param method the zip compression method of the entry (stored, deflate or GFC_PAK_METHOD_LZ4)
+ * @param src the raw entry data
+ * @param srcSize the size of the raw data
+ * @param dst where to write the decoded data
+ * @param dstSize how much room there is in dst
+ * @return 0 on error or unsupported method, the number of bytes written otherwise
+ */
+size_t gfc_pak_decode_data(Uint16 method,const void *src,size_t srcSize,void *dst,size_t dstSize);
+
 /**
  * @brief parse json data from the pak files
  */
@@ -0,0 +1,165 @@
+#ifndef __GFC_PAK_INDEX_H__
+#define __GFC_PAK_INDEX_H__
+
+#include "gfc_types.h"
+
+/**
+ * @purpose the pak index is a compact lookup table describing every entry in a pak file.
+ * Paks built with gfcpak store it as the first (uncompressed) zip entry so it can be read without parsing the central directory.
+ * The layout of the index data is:
+ *  GFC_PakIndexHeader
+ *  GFC_PakIndexRecord[entryCount]  sorted by name (case insensitive)
+ *  Uint32[tableSize]               open addressed hash table of record index + 1, 0 for an empty slot
+ *  char[namePoolSize]              null terminated entry names
+ * Values are stored in the native byte order of the machine that built the index, so it can be used straight from disk.
+ * The magic doubles as a byte order mark: an index built with the other byte order reads as GFC_PAK_INDEX_MAGIC_SWAPPED,
+ * and is rejected so the pak's zip central directory is used instead.
+ */
+
+#define GFC_PAK_INDEX_NAME      "__gfc_index"
+#define GFC_PAK_INDEX_MAGIC     0x58444947  /**<"GIDX"*/
+#define GFC_PAK_INDEX_MAGIC_SWAPPED 0x47494458  /**<the magic as read from an index of the other byte order*/
+#define GFC_PAK_INDEX_VERSION   1
+
+/**
+ * zip compression method id used for entries compressed with gfc_lz4.
+ * Other zip tools will list these entries but cannot extract them.
+ */
+#define GFC_PAK_METHOD_LZ4      0x4C34
+
+typedef struct
+{
+    Uint32 magic;           /**<GFC_PAK_INDEX_MAGIC*/
+    Uint32 version;         /**<GFC_PAK_INDEX_VERSION*/
+    Uint32 entryCount;      /**<how many records follow the header*/
+    Uint32 tableSize;       /**<how many hash slots follow the records, always a power of two*/
+    Uint32 namePoolSize;    /**<how many bytes of names follow the hash table*/
+    Uint32 sourceCrc;       /**<crc32 of the zip central directory of the pak file this index describes, 0 if embedded in the pak*/
+    Uint64 sourceSize;      /**<size of the pak file this index describes, 0 if embedded in the pak*/
+    Uint64 sourceTime;      /**<modification time in nanoseconds of the pak file this index describes, 0 if embedded in the pak*/
+}GFC_PakIndexHeader;
+
+typedef struct
+{
+    Uint32 hash;            /**<gfc_pak_index_hash() of the entry name*/
+    Uint32 nameOffset;      /**<where the name starts in the name pool*/
+    Uint16 nameLength;      /**<length of the name, not counting the terminator*/
+    Uint16 method;          /**<zip compression method of the entry*/
+    Uint32 crc32;           /**<crc32 of the uncompressed data*/
+    Uint32 group;           /**<load order group the entry was packed in*/
+    Uint32 fileIndex;       /**<index of the entry in the zip central directory*/
+    Uint64 dataOffset;      /**<offset from the start of the pak to the entry data, 0 if unknown*/
+    Uint64 compSize;        /**<size of the entry data in the pak*/
+    Uint64 uncompSize;      /**<size of the entry once extracted*/
+}GFC_PakIndexRecord;
+
+/**
+ * @brief an index in memory.  All pointers refer into the single data block
+ */
+typedef struct
+{
+    GFC_PakIndexHeader *header;
+    GFC_PakIndexRecord *records;
+    Uint32             *table;
+    char               *names;
+    void               *data;       /**<the block that holds the whole index*/
+    size_t              size;       /**<size of the block*/
+    Uint32              count;      /**<how many records have been added while building*/
+    Uint32              nameUsed;   /**<how much of the name pool has been used while building*/
+}GFC_PakIndex;
+
+/**
+ * @brief hash an entry name the same way the index does (case insensitive)
+ * @param name the name to hash
+ * @return the hash value
+ */
+Uint32 gfc_pak_index_hash(const char *name);
+
+/**
+ * @brief compare two entry names the way the index sorts them (case insensitive)
+ * @return <0, 0, or >0 like strcmp
+ */
+int gfc_pak_index_name_cmp(const char *a,const char *b);
+
+/**
+ * @brief get the size in bytes of an index holding the given entries
+ * @param entryCount how many entries the index will hold
+ * @param namePoolSize the total length of all names including terminators
+ * @return the size of the index data
+ */
+size_t gfc_pak_index_get_data_size(Uint32 entryCount,Uint32 namePoolSize);
+
+/**
+ * @brief allocate an empty index to be filled in with gfc_pak_index_add()
+ * @param entryCount how many entries will be added
+ * @param namePoolSize the total length of all names including terminators
+ * @return NULL on error, the empty index otherwise.  Free with gfc_pak_index_free()
+ */
+GFC_PakIndex *gfc_pak_index_new(Uint32 entryCount,Uint32 namePoolSize);
+
+/**
+ * @brief add an entry to an index that is being built
+ * @param index the index to add to
+ * @param name the name of the entry
+ * @param record the entry information.  hash, nameOffset and nameLength are filled in for you
+ * @return NULL if the index is full, the added record otherwise
+ * @note call gfc_pak_index_finalize() when all entries have been added
+ */
+GFC_PakIndexRecord *gfc_pak_index_add(GFC_PakIndex *index,const char *name,GFC_PakIndexRecord *record);
+
+/**
+ * @brief sort the records and build the hash table of an index once all entries are added
+ * @param index the index to finish
+ * @note if fewer entries or names were added than the index was made for, it is shrunk to fit
+ */
+void gfc_pak_index_finalize(GFC_PakIndex *index);
+
+/**
+ * @brief wrap a block of previously saved index data
+ * @param data the index data.  On success the index takes ownership of it, it must have been allocated with malloc
+ * @param size the size of the data
+ * @return NULL if the data is not a valid index, the index otherwise
+ * @note every hash slot and name is checked here, so lookups never need to bounds check them again
+ */
+GFC_PakIndex *gfc_pak_index_from_data(void *data,size_t size);
+
+/**
+ * @brief check every record of an index points at data inside the pak it describes
+ * @param index the index to check
+ * @param pakSize the size in bytes of the pak file
+ * @return false if any record reaches past the end of the pak, true otherwise
+ */
+Bool gfc_pak_index_check_bounds(GFC_PakIndex *index,Uint64 pakSize);
+
+/**
+ * @brief free an index and its data
+ * @param index the index to free
+ */
+void gfc_pak_index_free(GFC_PakIndex *index);
+
+/**
+ * @brief find an entry by name
+ * @param index the index to search
+ * @param name the entry to find
+ * @return NULL if not found, the record otherwise
+ */
+GFC_PakIndexRecord *gfc_pak_index_find(GFC_PakIndex *index,const char *name);
+
+/**
+ * @brief find all entries whose name starts with a prefix (case insensitive)
+ * @param index the index to search
+ * @param prefix the start of the names to find
+ * @param count set to how many entries were found
+ * @return NULL if none were found, the first matching record otherwise.  The rest follow it
+ */
+GFC_PakIndexRecord *gfc_pak_index_find_prefix(GFC_PakIndex *index,const char *prefix,Uint32 *count);
+
+/**
+ * @brief get the name of an entry
+ * @param index the index the record is from
+ * @param record the record in question
+ * @return the name of the entry
+ */
+const char *gfc_pak_index_get_name(GFC_PakIndex *index,GFC_PakIndexRecord *record);
+
+#endif
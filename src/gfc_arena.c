@@ -0,0 +1,102 @@
+#include "simple_logger.h"
+
+#include "gfc_arena.h"
+
+#define GFC_ARENA_ALIGN 16
+
+size_t gfc_arena_align(size_t size)
+{
+    return (size + (GFC_ARENA_ALIGN - 1)) & ~(size_t)(GFC_ARENA_ALIGN - 1);
+}
+
+Uint8 *gfc_arena_block_get_data(GFC_ArenaBlock *block)
+{
+    return (Uint8 *)block + gfc_arena_align(sizeof(GFC_ArenaBlock));
+}
+
+GFC_ArenaBlock *gfc_arena_block_new(size_t size)
+{
+    GFC_ArenaBlock *block;
+    block = malloc(gfc_arena_align(sizeof(GFC_ArenaBlock)) + size);
+    if (!block)
+    {
+        slog("failed to allocate arena block of size %lu",(unsigned long)size);
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+GFC_Arena *gfc_arena_new(size_t blockSize)
+{
+    GFC_Arena *arena;
+    if (!blockSize)
+    {
+        slog("cannot make an arena with a block size of zero");
+        return NULL;
+    }
+    arena = gfc_allocate_array(sizeof(GFC_Arena),1);
+    if (!arena)return NULL;
+    arena->blockSize = gfc_arena_align(blockSize);
+    return arena;
+}
+
+void gfc_arena_free(GFC_Arena *arena)
+{
+    GFC_ArenaBlock *block,*next;
+    if (!arena)return;
+    for (block = arena->first; block != NULL; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+    free(arena);
+}
+
+void *gfc_arena_alloc(GFC_Arena *arena,size_t size)
+{
+    GFC_ArenaBlock *block;
+    void *data;
+    if (!arena)return NULL;
+    size = gfc_arena_align(size ? size : 1);
+    //blocks after current are left over from before a reset, use them if they fit
+    for (block = arena->current; block != NULL; block = block->next)
+    {
+        if (block->used + size <= block->size)break;
+    }
+    if (!block)
+    {
+        block = gfc_arena_block_new(MAX(size,arena->blockSize));
+        if (!block)return NULL;
+        if (arena->current)
+        {
+            block->next = arena->current->next;
+            arena->current->next = block;
+        }
+        else
+        {
+            block->next = arena->first;
+            arena->first = block;
+        }
+    }
+    //an allocation bigger than a block gets one to itself, the room left in the current block is still used after it
+    if ((size <= arena->blockSize)||(!arena->current))arena->current = block;
+    data = gfc_arena_block_get_data(block) + block->used;
+    block->used += size;
+    return data;
+}
+
+void gfc_arena_reset(GFC_Arena *arena)
+{
+    GFC_ArenaBlock *block;
+    if (!arena)return;
+    for (block = arena->first; block != NULL; block = block->next)
+    {
+        block->used = 0;
+    }
+    arena->current = arena->first;
+}
+
+/*eol@eof*/
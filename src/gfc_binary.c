@@ -0,0 +1,630 @@
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_binary.h"
+
+#define GFC_BINARY_COLOR_SIZE   17  /**<color type byte and four floats*/
+
+void gfc_binary_put32(Uint8 *out,Uint32 value)
+{
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+Uint32 gfc_binary_get32(const Uint8 *in)
+{
+    return (Uint32)in[0] | ((Uint32)in[1] << 8) | ((Uint32)in[2] << 16) | ((Uint32)in[3] << 24);
+}
+
+void gfc_binary_put_float(Uint8 *out,float value)
+{
+    Uint32 bits;
+    memcpy(&bits,&value,sizeof(Uint32));
+    gfc_binary_put32(out,bits);
+}
+
+float gfc_binary_get_float(const Uint8 *in)
+{
+    Uint32 bits;
+    float value;
+    bits = gfc_binary_get32(in);
+    memcpy(&value,&bits,sizeof(float));
+    return value;
+}
+
+void gfc_binary_put_double(Uint8 *out,double value)
+{
+    Uint64 bits;
+    memcpy(&bits,&value,sizeof(Uint64));
+    gfc_binary_put32(out,(Uint32)(bits & 0xFFFFFFFF));
+    gfc_binary_put32(out + 4,(Uint32)(bits >> 32));
+}
+
+double gfc_binary_get_double(const Uint8 *in)
+{
+    Uint64 bits;
+    double value;
+    bits = (Uint64)gfc_binary_get32(in) | ((Uint64)gfc_binary_get32(in + 4) << 32);
+    memcpy(&value,&bits,sizeof(double));
+    return value;
+}
+
+Uint8 *gfc_binary_writer_reserve(GFC_BinaryWriter *writer,size_t size)
+{
+    Uint8 *data;
+    size_t newSize;
+    if ((!writer)||(writer->failed))return NULL;
+    if (writer->used + size > writer->size)
+    {
+        newSize = writer->size ? writer->size * 2 : 256;
+        while (newSize < writer->used + size)newSize *= 2;
+        data = realloc(writer->data,newSize);
+        if (!data)
+        {
+            slog("failed to grow binary writer to %lu bytes",(unsigned long)newSize);
+            writer->failed = 1;
+            return NULL;
+        }
+        writer->data = data;
+        writer->size = newSize;
+    }
+    data = writer->data + writer->used;
+    writer->used += size;
+    return data;
+}
+
+const Uint8 *gfc_binary_reader_take(GFC_BinaryReader *reader,size_t size)
+{
+    const Uint8 *data;
+    if ((!reader)||(reader->failed))return NULL;
+    if (size > reader->size - reader->position)
+    {
+        reader->failed = 1;
+        return NULL;
+    }
+    data = reader->data + reader->position;
+    reader->position += size;
+    return data;
+}
+
+GFC_BinaryWriter *gfc_binary_writer_new(Uint16 version)
+{
+    GFC_BinaryWriter *writer;
+    Uint8 *out;
+    writer = gfc_allocate_array(sizeof(GFC_BinaryWriter),1);
+    if (!writer)return NULL;
+    out = gfc_binary_writer_reserve(writer,GFC_BINARY_HEADER_SIZE);
+    if (!out)
+    {
+        gfc_binary_writer_free(writer);
+        return NULL;
+    }
+    gfc_binary_put32(out,GFC_BINARY_MAGIC);
+    gfc_binary_put32(out + 4,GFC_BINARY_VERSION | ((Uint32)version << 16));
+    return writer;
+}
+
+void gfc_binary_writer_free(GFC_BinaryWriter *writer)
+{
+    if (!writer)return;
+    if (writer->data)free(writer->data);
+    free(writer);
+}
+
+const void *gfc_binary_writer_get_data(GFC_BinaryWriter *writer,size_t *size)
+{
+    if ((!writer)||(writer->failed))return NULL;
+    if (size)*size = writer->used;
+    return writer->data;
+}
+
+Bool gfc_binary_reader_open(GFC_BinaryReader *reader,const void *data,size_t size)
+{
+    const Uint8 *header;
+    Uint32 versions;
+    if (!reader)return 0;
+    memset(reader,0,sizeof(GFC_BinaryReader));
+    reader->data = data;
+    reader->size = data ? size : 0;
+    header = gfc_binary_reader_take(reader,GFC_BINARY_HEADER_SIZE);
+    if ((!header)||(gfc_binary_get32(header) != GFC_BINARY_MAGIC))
+    {
+        slog("binary data has no gfc header");
+        reader->failed = 1;
+        return 0;
+    }
+    versions = gfc_binary_get32(header + 4);
+    if ((versions & 0xFFFF) != GFC_BINARY_VERSION)
+    {
+        slog("binary data is format version %i, expected %i",versions & 0xFFFF,GFC_BINARY_VERSION);
+        reader->failed = 1;
+        return 0;
+    }
+    reader->version = versions >> 16;
+    return 1;
+}
+
+void gfc_binary_write_uint8(GFC_BinaryWriter *writer,Uint8 value)
+{
+    Uint8 *out;
+    out = gfc_binary_writer_reserve(writer,1);
+    if (out)*out = value;
+}
+
+void gfc_binary_write_uint32(GFC_BinaryWriter *writer,Uint32 value)
+{
+    Uint8 *out;
+    out = gfc_binary_writer_reserve(writer,4);
+    if (out)gfc_binary_put32(out,value);
+}
+
+void gfc_binary_write_float(GFC_BinaryWriter *writer,float value)
+{
+    Uint8 *out;
+    out = gfc_binary_writer_reserve(writer,4);
+    if (out)gfc_binary_put_float(out,value);
+}
+
+void gfc_binary_write_double(GFC_BinaryWriter *writer,double value)
+{
+    Uint8 *out;
+    out = gfc_binary_writer_reserve(writer,8);
+    if (out)gfc_binary_put_double(out,value);
+}
+
+/**
+ * @brief fail the writer if it is given no values to write, rather than quietly leaving the array out of the data
+ */
+Bool gfc_binary_writer_check_array(GFC_BinaryWriter *writer,const void *values,Uint32 count)
+{
+    if ((values)||(!count))return 1;
+    slog("no values given for a binary array of %u items",count);
+    if (writer)writer->failed = 1;
+    return 0;
+}
+
+void gfc_binary_write_floats(GFC_BinaryWriter *writer,const float *values,Uint32 count)
+{
+    Uint8 *out;
+    Uint32 i;
+    if (!gfc_binary_writer_check_array(writer,values,count))return;
+    out = gfc_binary_writer_reserve(writer,(size_t)count * 4);
+    if (!out)return;
+    for (i = 0; i < count; i++)
+    {
+        gfc_binary_put_float(out + (i * 4),values[i]);
+    }
+}
+
+void gfc_binary_write_vector2d(GFC_BinaryWriter *writer,Vector2D v)
+{
+    float values[2] = {v.x,v.y};
+    gfc_binary_write_floats(writer,values,2);
+}
+
+void gfc_binary_write_vector3d(GFC_BinaryWriter *writer,Vector3D v)
+{
+    float values[3] = {v.x,v.y,v.z};
+    gfc_binary_write_floats(writer,values,3);
+}
+
+void gfc_binary_write_vector4d(GFC_BinaryWriter *writer,Vector4D v)
+{
+    float values[4] = {v.x,v.y,v.z,v.w};
+    gfc_binary_write_floats(writer,values,4);
+}
+
+void gfc_binary_put_color(Uint8 *out,const Color *color)
+{
+    out[0] = (Uint8)color->ct;
+    gfc_binary_put_float(out + 1,color->r);
+    gfc_binary_put_float(out + 5,color->g);
+    gfc_binary_put_float(out + 9,color->b);
+    gfc_binary_put_float(out + 13,color->a);
+}
+
+void gfc_binary_write_color(GFC_BinaryWriter *writer,Color color)
+{
+    Uint8 *out;
+    out = gfc_binary_writer_reserve(writer,GFC_BINARY_COLOR_SIZE);
+    if (out)gfc_binary_put_color(out,&color);
+}
+
+void gfc_binary_write_rect(GFC_BinaryWriter *writer,Rect rect)
+{
+    gfc_binary_write_double(writer,rect.x);
+    gfc_binary_write_double(writer,rect.y);
+    gfc_binary_write_double(writer,rect.w);
+    gfc_binary_write_double(writer,rect.h);
+}
+
+void gfc_binary_write_shape(GFC_BinaryWriter *writer,Shape shape)
+{
+    gfc_binary_write_uint8(writer,(Uint8)shape.type);
+    switch (shape.type)
+    {
+        case ST_RECT:
+            gfc_binary_write_rect(writer,shape.s.r);
+            break;
+        case ST_CIRCLE:
+            gfc_binary_write_double(writer,shape.s.c.x);
+            gfc_binary_write_double(writer,shape.s.c.y);
+            gfc_binary_write_double(writer,shape.s.c.r);
+            break;
+        case ST_EDGE:
+            gfc_binary_write_double(writer,shape.s.e.x1);
+            gfc_binary_write_double(writer,shape.s.e.y1);
+            gfc_binary_write_double(writer,shape.s.e.x2);
+            gfc_binary_write_double(writer,shape.s.e.y2);
+            break;
+    }
+}
+
+void gfc_binary_write_box(GFC_BinaryWriter *writer,Box box)
+{
+    float values[6] = {box.x,box.y,box.z,box.w,box.h,box.d};
+    gfc_binary_write_floats(writer,values,6);
+}
+
+void gfc_binary_write_matrix4(GFC_BinaryWriter *writer,Matrix4 matrix)
+{
+    gfc_binary_write_floats(writer,&matrix[0][0],16);
+}
+
+void gfc_binary_write_float_array(GFC_BinaryWriter *writer,const float *values,Uint32 count)
+{
+    if (!gfc_binary_writer_check_array(writer,values,count))return;
+    gfc_binary_write_uint32(writer,count);
+    gfc_binary_write_floats(writer,values,count);
+}
+
+void gfc_binary_write_vector2d_array(GFC_BinaryWriter *writer,const Vector2D *values,Uint32 count)
+{
+    Uint8 *out;
+    Uint32 i;
+    if (!gfc_binary_writer_check_array(writer,values,count))return;
+    gfc_binary_write_uint32(writer,count);
+    out = gfc_binary_writer_reserve(writer,(size_t)count * 8);
+    if (!out)return;
+    for (i = 0; i < count; i++,out += 8)
+    {
+        gfc_binary_put_float(out,values[i].x);
+        gfc_binary_put_float(out + 4,values[i].y);
+    }
+}
+
+void gfc_binary_write_vector3d_array(GFC_BinaryWriter *writer,const Vector3D *values,Uint32 count)
+{
+    Uint8 *out;
+    Uint32 i;
+    if (!gfc_binary_writer_check_array(writer,values,count))return;
+    gfc_binary_write_uint32(writer,count);
+    out = gfc_binary_writer_reserve(writer,(size_t)count * 12);
+    if (!out)return;
+    for (i = 0; i < count; i++,out += 12)
+    {
+        gfc_binary_put_float(out,values[i].x);
+        gfc_binary_put_float(out + 4,values[i].y);
+        gfc_binary_put_float(out + 8,values[i].z);
+    }
+}
+
+void gfc_binary_write_vector4d_array(GFC_BinaryWriter *writer,const Vector4D *values,Uint32 count)
+{
+    Uint8 *out;
+    Uint32 i;
+    if (!gfc_binary_writer_check_array(writer,values,count))return;
+    gfc_binary_write_uint32(writer,count);
+    out = gfc_binary_writer_reserve(writer,(size_t)count * 16);
+    if (!out)return;
+    for (i = 0; i < count; i++,out += 16)
+    {
+        gfc_binary_put_float(out,values[i].x);
+        gfc_binary_put_float(out + 4,values[i].y);
+        gfc_binary_put_float(out + 8,values[i].z);
+        gfc_binary_put_float(out + 12,values[i].w);
+    }
+}
+
+void gfc_binary_write_color_array(GFC_BinaryWriter *writer,const Color *values,Uint32 count)
+{
+    Uint8 *out;
+    Uint32 i;
+    if (!gfc_binary_writer_check_array(writer,values,count))return;
+    gfc_binary_write_uint32(writer,count);
+    out = gfc_binary_writer_reserve(writer,(size_t)count * GFC_BINARY_COLOR_SIZE);
+    if (!out)return;
+    for (i = 0; i < count; i++,out += GFC_BINARY_COLOR_SIZE)
+    {
+        gfc_binary_put_color(out,&values[i]);
+    }
+}
+
+Bool gfc_binary_read_uint8(GFC_BinaryReader *reader,Uint8 *output)
+{
+    const Uint8 *in;
+    in = gfc_binary_reader_take(reader,1);
+    if (!in)return 0;
+    if (output)*output = *in;
+    return 1;
+}
+
+Bool gfc_binary_read_uint32(GFC_BinaryReader *reader,Uint32 *output)
+{
+    const Uint8 *in;
+    in = gfc_binary_reader_take(reader,4);
+    if (!in)return 0;
+    if (output)*output = gfc_binary_get32(in);
+    return 1;
+}
+
+Bool gfc_binary_read_float(GFC_BinaryReader *reader,float *output)
+{
+    const Uint8 *in;
+    in = gfc_binary_reader_take(reader,4);
+    if (!in)return 0;
+    if (output)*output = gfc_binary_get_float(in);
+    return 1;
+}
+
+Bool gfc_binary_read_double(GFC_BinaryReader *reader,double *output)
+{
+    const Uint8 *in;
+    in = gfc_binary_reader_take(reader,8);
+    if (!in)return 0;
+    if (output)*output = gfc_binary_get_double(in);
+    return 1;
+}
+
+Bool gfc_binary_read_floats(GFC_BinaryReader *reader,float *output,Uint32 count)
+{
+    const Uint8 *in;
+    Uint32 i;
+    in = gfc_binary_reader_take(reader,(size_t)count * 4);
+    if (!in)return 0;
+    for (i = 0; i < count; i++)
+    {
+        output[i] = gfc_binary_get_float(in + (i * 4));
+    }
+    return 1;
+}
+
+Bool gfc_binary_read_vector2d(GFC_BinaryReader *reader,Vector2D *output)
+{
+    float values[2];
+    if (!gfc_binary_read_floats(reader,values,2))return 0;
+    if (output)vector2d_set((*output),values[0],values[1]);
+    return 1;
+}
+
+Bool gfc_binary_read_vector3d(GFC_BinaryReader *reader,Vector3D *output)
+{
+    float values[3];
+    if (!gfc_binary_read_floats(reader,values,3))return 0;
+    if (output)vector3d_set((*output),values[0],values[1],values[2]);
+    return 1;
+}
+
+Bool gfc_binary_read_vector4d(GFC_BinaryReader *reader,Vector4D *output)
+{
+    float values[4];
+    if (!gfc_binary_read_floats(reader,values,4))return 0;
+    if (output)vector4d_set((*output),values[0],values[1],values[2],values[3]);
+    return 1;
+}
+
+Bool gfc_binary_get_color(GFC_BinaryReader *reader,const Uint8 *in,Color *output)
+{
+    if (in[0] > CT_HEX)
+    {
+        reader->failed = 1;
+        return 0;
+    }
+    output->ct = (ColorType)in[0];
+    output->r = gfc_binary_get_float(in + 1);
+    output->g = gfc_binary_get_float(in + 5);
+    output->b = gfc_binary_get_float(in + 9);
+    output->a = gfc_binary_get_float(in + 13);
+    return 1;
+}
+
+Bool gfc_binary_read_color(GFC_BinaryReader *reader,Color *output)
+{
+    const Uint8 *in;
+    Color color;
+    in = gfc_binary_reader_take(reader,GFC_BINARY_COLOR_SIZE);
+    if (!in)return 0;
+    if (!gfc_binary_get_color(reader,in,&color))return 0;
+    if (output)*output = color;
+    return 1;
+}
+
+Bool gfc_binary_read_rect(GFC_BinaryReader *reader,Rect *output)
+{
+    const Uint8 *in;
+    in = gfc_binary_reader_take(reader,32);
+    if (!in)return 0;
+    if (!output)return 1;
+    output->x = gfc_binary_get_double(in);
+    output->y = gfc_binary_get_double(in + 8);
+    output->w = gfc_binary_get_double(in + 16);
+    output->h = gfc_binary_get_double(in + 24);
+    return 1;
+}
+
+Bool gfc_binary_read_shape(GFC_BinaryReader *reader,Shape *output)
+{
+    const Uint8 *in;
+    Shape shape = {0};
+    Uint8 type;
+    size_t position;
+    if (!reader)return 0;
+    position = reader->position;
+    if (!gfc_binary_read_uint8(reader,&type))return 0;
+    switch (type)
+    {
+        case ST_RECT:
+            if (!gfc_binary_read_rect(reader,&shape.s.r))return 0;
+            break;
+        case ST_CIRCLE:
+            in = gfc_binary_reader_take(reader,24);
+            if (!in)return 0;
+            shape.s.c.x = gfc_binary_get_double(in);
+            shape.s.c.y = gfc_binary_get_double(in + 8);
+            shape.s.c.r = gfc_binary_get_double(in + 16);
+            break;
+        case ST_EDGE:
+            in = gfc_binary_reader_take(reader,32);
+            if (!in)return 0;
+            shape.s.e.x1 = gfc_binary_get_double(in);
+            shape.s.e.y1 = gfc_binary_get_double(in + 8);
+            shape.s.e.x2 = gfc_binary_get_double(in + 16);
+            shape.s.e.y2 = gfc_binary_get_double(in + 24);
+            break;
+        default:
+            slog("binary data has an unknown shape type %i at %lu",type,(unsigned long)position);
+            reader->failed = 1;
+            return 0;
+    }
+    shape.type = (ShapeTypes)type;
+    if (output)*output = shape;
+    return 1;
+}
+
+Bool gfc_binary_read_box(GFC_BinaryReader *reader,Box *output)
+{
+    float values[6];
+    if (!gfc_binary_read_floats(reader,values,6))return 0;
+    if (!output)return 1;
+    output->x = values[0];
+    output->y = values[1];
+    output->z = values[2];
+    output->w = values[3];
+    output->h = values[4];
+    output->d = values[5];
+    return 1;
+}
+
+Bool gfc_binary_read_matrix4(GFC_BinaryReader *reader,Matrix4 output)
+{
+    float values[16];
+    if (!gfc_binary_read_floats(reader,values,16))return 0;
+    if (output)memcpy(&output[0][0],values,sizeof(values));
+    return 1;
+}
+
+const Uint8 *gfc_binary_reader_take_array(GFC_BinaryReader *reader,size_t itemSize,Uint32 *count)
+{
+    //the whole array is taken at once, so a short one fails before any output is written
+    Uint32 stored;
+    size_t position;
+    const Uint8 *in;
+    if (!reader)return NULL;
+    position = reader->position;
+    if (!gfc_binary_read_uint32(reader,&stored))return NULL;
+    if ((Uint64)stored * itemSize > reader->size - reader->position)
+    {
+        slog("binary data array of %u items at %lu runs past the end",stored,(unsigned long)position);
+        reader->failed = 1;
+        return NULL;
+    }
+    in = gfc_binary_reader_take(reader,(size_t)stored * itemSize);
+    *count = stored;
+    return in;
+}
+
+Uint32 gfc_binary_read_float_array(GFC_BinaryReader *reader,float *output,Uint32 maxCount)
+{
+    const Uint8 *in;
+    Uint32 i,count = 0;
+    in = gfc_binary_reader_take_array(reader,4,&count);
+    if (!in)return 0;
+    if (!output)return 0;
+    count = MIN(count,maxCount);
+    for (i = 0; i < count; i++)
+    {
+        output[i] = gfc_binary_get_float(in + (i * 4));
+    }
+    return count;
+}
+
+Uint32 gfc_binary_read_vector2d_array(GFC_BinaryReader *reader,Vector2D *output,Uint32 maxCount)
+{
+    const Uint8 *in;
+    Uint32 i,count = 0;
+    in = gfc_binary_reader_take_array(reader,8,&count);
+    if (!in)return 0;
+    if (!output)return 0;
+    count = MIN(count,maxCount);
+    for (i = 0; i < count; i++,in += 8)
+    {
+        output[i].x = gfc_binary_get_float(in);
+        output[i].y = gfc_binary_get_float(in + 4);
+    }
+    return count;
+}
+
+Uint32 gfc_binary_read_vector3d_array(GFC_BinaryReader *reader,Vector3D *output,Uint32 maxCount)
+{
+    const Uint8 *in;
+    Uint32 i,count = 0;
+    in = gfc_binary_reader_take_array(reader,12,&count);
+    if (!in)return 0;
+    if (!output)return 0;
+    count = MIN(count,maxCount);
+    for (i = 0; i < count; i++,in += 12)
+    {
+        output[i].x = gfc_binary_get_float(in);
+        output[i].y = gfc_binary_get_float(in + 4);
+        output[i].z = gfc_binary_get_float(in + 8);
+    }
+    return count;
+}
+
+Uint32 gfc_binary_read_vector4d_array(GFC_BinaryReader *reader,Vector4D *output,Uint32 maxCount)
+{
+    const Uint8 *in;
+    Uint32 i,count = 0;
+    in = gfc_binary_reader_take_array(reader,16,&count);
+    if (!in)return 0;
+    if (!output)return 0;
+    count = MIN(count,maxCount);
+    for (i = 0; i < count; i++,in += 16)
+    {
+        output[i].x = gfc_binary_get_float(in);
+        output[i].y = gfc_binary_get_float(in + 4);
+        output[i].z = gfc_binary_get_float(in + 8);
+        output[i].w = gfc_binary_get_float(in + 12);
+    }
+    return count;
+}
+
+Uint32 gfc_binary_read_color_array(GFC_BinaryReader *reader,Color *output,Uint32 maxCount)
+{
+    const Uint8 *in;
+    Uint32 i,count = 0;
+    in = gfc_binary_reader_take_array(reader,GFC_BINARY_COLOR_SIZE,&count);
+    if (!in)return 0;
+    //check every color type first, so bad data leaves the output untouched
+    for (i = 0; i < count; i++)
+    {
+        if (in[i * GFC_BINARY_COLOR_SIZE] > CT_HEX)
+        {
+            slog("binary data color array has a bad color type");
+            reader->failed = 1;
+            return 0;
+        }
+    }
+    if (!output)return 0;
+    count = MIN(count,maxCount);
+    for (i = 0; i < count; i++,in += GFC_BINARY_COLOR_SIZE)
+    {
+        gfc_binary_get_color(reader,in,&output[i]);
+    }
+    return count;
+}
+
+/*eol@eof*/
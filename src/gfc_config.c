@@ -1,3 +1,6 @@
+#include <math.h>
+#include <string.h>
+
 #include "simple_logger.h"
 #include "gfc_config.h"
 
@@ -68,142 +71,231 @@ int sj_object_get_vector4d(SJson *json,const char *key,Vector4D *output)
     return sj_value_as_vector4d(sj_object_get_value(json,key),output);
 }
 
-int sj_value_as_vector2d(SJson *json,Vector2D *output)
+static const double gfc_config_powers_of_ten[] =
 {
-    const char *text = NULL;
-    float numbers[4];
-    int i,count;
-    SJson *value;
-    if (!json)return 0;
-    if (sj_is_array(json))
+    1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+    1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22
+};
+
+double gfc_config_power_of_ten(int exponent)
+{
+    if ((exponent >= 0)&&(exponent <= 22))return gfc_config_powers_of_ten[exponent];
+    return pow(10,exponent);
+}
+
+const char *gfc_config_parse_float(const char *text,float *output)
+{
+    const char *c,*e;
+    Uint64 mantissa = 0;
+    int exponent = 0,explicitExponent = 0;
+    int digits = 0;
+    Bool negative = 0,negativeExponent = 0;
+    double value;
+    if (!text)return NULL;
+    for (c = text;(*c == ' ')||(*c == '\t')||(*c == '\n')||(*c == '\r');c++);
+    if (*c == '-')
     {
-        count = sj_array_get_count(json);
-        if (count < 2)return 0;
-        if (count > 2)count = 2;
-        for (i = 0; i < count;i++)
-        {
-            value = sj_array_get_nth(json,i);
-            sj_get_float_value(value,&numbers[i]);
-        }
-        if (output)
+        negative = 1;
+        c++;
+    }
+    else if (*c == '+')c++;
+    //digits past what fits in the mantissa only change the exponent
+    for (;(*c >= '0')&&(*c <= '9');c++,digits++)
+    {
+        if (mantissa < 100000000000000000ULL)mantissa = mantissa * 10 + (*c - '0');
+        else exponent++;
+    }
+    if (*c == '.')
+    {
+        for (c++;(*c >= '0')&&(*c <= '9');c++,digits++)
         {
-            output->x = numbers[0];
-            output->y = numbers[1];
+            if (mantissa >= 100000000000000000ULL)continue;
+            mantissa = mantissa * 10 + (*c - '0');
+            exponent--;
         }
-        return 1;
     }
-    if (sj_is_string(json))
+    if (!digits)return NULL;
+    if ((*c == 'e')||(*c == 'E'))
     {
-        text = sj_get_string_value(json);
-        if(sscanf(text,"%f,%f",&numbers[0],&numbers[1]) != 2)
+        e = c + 1;
+        if (*e == '-')
         {
-            return 0;
+            negativeExponent = 1;
+            e++;
         }
-        if (output)
+        else if (*e == '+')e++;
+        if ((*e >= '0')&&(*e <= '9'))
         {
-            output->x = numbers[0];
-            output->y = numbers[1];
+            for (;(*e >= '0')&&(*e <= '9');e++)
+            {
+                if (explicitExponent < 1000)explicitExponent = explicitExponent * 10 + (*e - '0');
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            c = e;
         }
-        return 1;
     }
-    return 0;
+    value = (double)mantissa;
+    if (exponent < 0)value /= gfc_config_power_of_ten(-exponent);
+    else if (exponent > 0)value *= gfc_config_power_of_ten(exponent);
+    if (output)*output = (float)(negative ? -value : value);
+    return c;
 }
 
-int sj_value_as_vector3d(SJson *json,Vector3D *output)
+int gfc_config_parse_floats(const char *text,float *output,int count)
 {
-    const char *text = NULL;
+    const char *c;
+    int i;
+    if ((!text)||(!output))return 0;
+    c = text;
+    for (i = 0;i < count;i++)
+    {
+        if (i)
+        {
+            while ((*c == ' ')||(*c == '\t'))c++;
+            if (*c != ',')return i;
+            c++;
+        }
+        c = gfc_config_parse_float(c,&output[i]);
+        if (!c)return i;
+    }
+    return count;
+}
+
+int sj_value_as_float(SJson *json,float *output)
+{
+    const char *text;
+    text = sj_get_string_value(json);
+    if (!text)return sj_get_float_value(json,output);
+    return gfc_config_parse_float(text,output) != NULL;
+}
+
+/**
+ * @brief read count (up to 4) floats from a json array of numbers or a "x,y,..." string
+ * @return 0 if there were not enough numbers, 1 otherwise.  output is only written on success
+ */
+int sj_value_as_floats(SJson *json,float *output,int count)
+{
+    const char *text;
     float numbers[4];
-    int i,count;
-    SJson *value;
-    if (!json)return 0;
+    int i;
+    if ((!json)||(count > 4))return 0;
     if (sj_is_array(json))
     {
-        count = sj_array_get_count(json);
-        if (count < 3)return 0;
-        if (count > 3)count = 3;
+        if (sj_array_get_count(json) < count)return 0;
         for (i = 0; i < count;i++)
         {
-            value = sj_array_get_nth(json,i);
-            sj_get_float_value(value,&numbers[i]);
+            if (!sj_value_as_float(sj_array_get_nth(json,i),&numbers[i]))return 0;
         }
-        if (output)
-        {
-            output->x = numbers[0];
-            output->y = numbers[1];
-            output->z = numbers[2];
-        }
-        return 1;
     }
-    if (sj_is_string(json))
+    else
     {
         text = sj_get_string_value(json);
-        if(sscanf(text,"%f,%f,%f",&numbers[0],&numbers[1],&numbers[2]) != 3)
-        {
-            return 0;
-        }
-        if (output)
-        {
-            output->x = numbers[0];
-            output->y = numbers[1];
-            output->z = numbers[2];
-        }
-        return 1;
+        if (!text)return 0;
+        if (gfc_config_parse_floats(text,numbers,count) != count)return 0;
+    }
+    if (output)memcpy(output,numbers,sizeof(float)*count);
+    return 1;
+}
+
+int sj_value_as_vector2d(SJson *json,Vector2D *output)
+{
+    float numbers[2];
+    if (!sj_value_as_floats(json,numbers,2))return 0;
+    if (output)
+    {
+        output->x = numbers[0];
+        output->y = numbers[1];
+    }
+    return 1;
+}
+
+int sj_value_as_vector3d(SJson *json,Vector3D *output)
+{
+    float numbers[3];
+    if (!sj_value_as_floats(json,numbers,3))return 0;
+    if (output)
+    {
+        output->x = numbers[0];
+        output->y = numbers[1];
+        output->z = numbers[2];
     }
-    return 0;
+    return 1;
 }
 
 int sj_value_as_vector4d(SJson *json,Vector4D *output)
 {
-    const char *text = NULL;
     float numbers[4];
+    if (!sj_value_as_floats(json,numbers,4))return 0;
+    if (output)
+    {
+        output->x = numbers[0];
+        output->y = numbers[1];
+        output->z = numbers[2];
+        output->w = numbers[3];
+    }
+    return 1;
+}
+
+int sj_value_as_float_array(SJson *json,float *output,int maxCount)
+{
     int i,count;
-    SJson *value;
-    if (!json)
+    if ((!output)||(!sj_is_array(json)))return 0;
+    count = MIN(sj_array_get_count(json),maxCount);
+    for (i = 0; i < count;i++)
     {
-        return 0;
+        if (!sj_value_as_float(sj_array_get_nth(json,i),&output[i]))return i;
     }
-    if (sj_is_array(json))
+    return count;
+}
+
+int sj_value_as_vector2d_array(SJson *json,Vector2D *output,int maxCount)
+{
+    int i,count;
+    if ((!output)||(!sj_is_array(json)))return 0;
+    count = MIN(sj_array_get_count(json),maxCount);
+    for (i = 0; i < count;i++)
     {
-        count = sj_array_get_count(json);
-        if (count < 4)
-        {
-            slog("not enough elements in the array (%i) for a Vector4D",count);
-            return 0;
-        }
-        if (count > 4)count = 4;
-        for (i = 0; i < count;i++)
-        {
-            value = sj_array_get_nth(json,i);
-            sj_get_float_value(value,&numbers[i]);
-        }
-        if (output)
-        {
-            output->x = numbers[0];
-            output->y = numbers[1];
-            output->z = numbers[2];
-            output->w = numbers[3];
-        }
-        return 1;
+        if (!sj_value_as_vector2d(sj_array_get_nth(json,i),&output[i]))return i;
     }
-    if (sj_is_string(json))
+    return count;
+}
+
+int sj_value_as_vector3d_array(SJson *json,Vector3D *output,int maxCount)
+{
+    int i,count;
+    if ((!output)||(!sj_is_array(json)))return 0;
+    count = MIN(sj_array_get_count(json),maxCount);
+    for (i = 0; i < count;i++)
     {
-        text = sj_get_string_value(json);
-        if(sscanf(text,"%f,%f,%f,%f",&numbers[0],&numbers[1],&numbers[2],&numbers[3]) != 4)
-        {
-            return 0;
-        }
-        if (output)
-        {
-            output->x = numbers[0];
-            output->y = numbers[1];
-            output->z = numbers[2];
-            output->w = numbers[3];
-        }
-        return 1;
+        if (!sj_value_as_vector3d(sj_array_get_nth(json,i),&output[i]))return i;
+    }
+    return count;
+}
+
+int sj_value_as_vector4d_array(SJson *json,Vector4D *output,int maxCount)
+{
+    int i,count;
+    if ((!output)||(!sj_is_array(json)))return 0;
+    count = MIN(sj_array_get_count(json),maxCount);
+    for (i = 0; i < count;i++)
+    {
+        if (!sj_value_as_vector4d(sj_array_get_nth(json,i),&output[i]))return i;
+    }
+    return count;
+}
+
+int sj_value_as_color_array(SJson *json,Color *output,int maxCount)
+{
+    int i,count;
+    Vector4D colorv;
+    if ((!output)||(!sj_is_array(json)))return 0;
+    count = MIN(sj_array_get_count(json),maxCount);
+    for (i = 0; i < count;i++)
+    {
+        if (!sj_value_as_vector4d(sj_array_get_nth(json,i),&colorv))return i;
+        output[i] = gfc_color_from_vector4(colorv);
     }
-    slog("json is not an array or string");
-    sj_echo(json);
-    return 0;
+    return count;
 }
 
 /*eol@eof*/
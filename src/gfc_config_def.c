@@ -2,78 +2,1375 @@
 
 #include "gfc_types.h"
 #include "gfc_list.h"
+#include "gfc_hashmap.h"
+#include "gfc_config.h"
 #include "gfc_pak.h"
+#include "gfc_config_def_cache.h"
+#include "miniz.h"
 
 #include "gfc_config_def.h"
 
+#define GFC_CONFIG_DEF_MAX_LOAD_THREADS 8
+
+typedef struct
+{
+    TextLine parameter;     /**<the key of the defs this index is built from*/
+    HashMap *map;           /**<value of the key to the list position + 1 of the first def with that value.  NULL if the cache's name table is used*/
+}ConfigDefIndex;
+
+typedef struct
+{
+    const GFC_ConfigDefSchema *schema;
+    Uint8 *data;            /**<a struct for every def in the list*/
+    Uint8 *decoded;         /**<set for each struct that has been decoded*/
+}ConfigDefBinding;
+
+typedef struct
+{
+    TextLine name;          /**<the name of the resource list*/
+    Uint32 id;              /**<the resource part of its def handles, 0 if there were too many resources to give it one*/
+    Uint32 version;         /**<starts at 1, goes up each time a reload changes the resource*/
+    SJson *list;            /**<the array of defs for the resource, NULL if they are read from a cache*/
+    GFC_ConfigDefCache *cache;  /**<the compiled file the defs are read from, NULL if they come from list*/
+    Uint32 cacheResource;   /**<which of the cache's resources this is*/
+    SJson **defs;           /**<per def in the cache, its json, made the first time it is asked for*/
+    SJson *added;           /**<copies of the defs overlays added after the list, NULL if none*/
+    Uint32 baseCount;       /**<how many defs are in the list*/
+    Uint32 count;           /**<how many defs there are, counting added ones*/
+    List  *indices;         /**<a ConfigDefIndex for each registered parameter*/
+    List  *bindings;        /**<a ConfigDefBinding for each schema defs have been bound with*/
+    List **patches;         /**<per def, the overlay defs that patch it in the order loaded.  NULL until an overlay touches the resource*/
+    SJson **merged;         /**<per def, the def with its patches applied, made the first time it is asked for*/
+    SJson *mergedList;      /**<every def with patches applied and added defs on the end, made the first time the list is asked for*/
+    List  *sources;         /**<the loaded json its list and patches point into, so gfc_config_def_collect() keeps it*/
+}ConfigDefResource;
+
+typedef struct
+{
+    TextBlock filename;
+    SJson *json;            /**<the current contents of the file, NULL if it was loaded from the cache*/
+    GFC_ConfigDefCache *cache;  /**<the current compiled contents of the file, NULL if it was parsed*/
+    Uint8 overlay;          /**<set if loaded with gfc_config_def_load_overlay()*/
+}ConfigDefFile;
+
+typedef struct
+{
+    gfc_config_def_change_func *func;
+    void *data;
+}ConfigDefSubscriber;
+
 typedef struct
 {
-    List *defs;
+    List *defs;             /**<every json loaded.  Reloaded json stays here since old defs may still be in use, until gfc_config_def_collect()*/
+    List *caches;           /**<every compiled file loaded, kept the same way*/
+    List *files;            /**<ConfigDefFile for each file loaded, in load order*/
+    HashMap *resources;     /**<ConfigDefResource by resource name*/
+    List *resourceList;     /**<every ConfigDefResource, for cleanup*/
+    List *resourcesById;    /**<ConfigDefResource by id - 1, NULL for a resource a reload removed*/
+    HashMap *resourceIds;   /**<id by resource name, so a resource keeps its id through reloads*/
+    List *parameters;       /**<TextLine names of the parameters to index*/
+    List *retired;          /**<merged defs replaced by a newer overlay, kept until collected in case they are still referenced*/
+    List *retiredData;      /**<bound struct blocks outgrown by added defs, kept for the same reason*/
+    List *retiredResources; /**<resources replaced by a reload, kept for the same reason*/
+    List *subscribers;      /**<ConfigDefSubscriber to tell about reloaded resources*/
+    SDL_mutex *subscriberLock;  /**<guards subscribers, which may be changed from any thread*/
+    TextBlock cacheDir;     /**<where compiled def files are kept, empty to always parse the json*/
 }ConfigManager;
 
+typedef struct
+{
+    const char **filenames;
+    SJson **json;           /**<the parsed json for each file, NULL if it failed, is a repeat or was compiled*/
+    GFC_ConfigDefCache **caches;    /**<the compiled file for each file if there is a cache directory*/
+    Uint32 count;
+    SDL_atomic_t next;      /**<the next file to be loaded by a worker*/
+}ConfigDefLoadJob;
+
 static ConfigManager config_manager = {0};
 
+void gfc_config_def_index_free(ConfigDefIndex *index)
+{
+    if (!index)return;
+    gfc_hashmap_free(index->map);
+    free(index);
+}
+
+void gfc_config_def_binding_free(ConfigDefBinding *binding)
+{
+    if (!binding)return;
+    if (binding->data)free(binding->data);
+    if (binding->decoded)free(binding->decoded);
+    free(binding);
+}
+
+void gfc_config_def_resource_free(ConfigDefResource *resource)
+{
+    Uint32 i;
+    if (!resource)return;
+    for (i = 0; (resource->patches)&&(i < resource->count); i++)
+    {
+        if (resource->patches[i])gfc_list_delete(resource->patches[i]);
+        if (resource->merged[i])sj_free(resource->merged[i]);
+    }
+    for (i = 0; (resource->defs)&&(i < resource->baseCount); i++)
+    {
+        if (resource->defs[i])sj_free(resource->defs[i]);
+    }
+    if (resource->defs)free(resource->defs);
+    if (resource->patches)free(resource->patches);
+    if (resource->merged)free(resource->merged);
+    if (resource->added)sj_free(resource->added);
+    if (resource->mergedList)sj_free(resource->mergedList);
+    gfc_list_foreach(resource->indices,(void (*)(void *))gfc_config_def_index_free);
+    gfc_list_delete(resource->indices);
+    gfc_list_delete(resource->sources);
+    if (resource->bindings)
+    {
+        gfc_list_foreach(resource->bindings,(void (*)(void *))gfc_config_def_binding_free);
+        gfc_list_delete(resource->bindings);
+    }
+    free(resource);
+}
+
 void gfc_config_def_close()
 {
+    if (config_manager.resourceList)
+    {
+        gfc_list_foreach(config_manager.resourceList,(void (*)(void *))gfc_config_def_resource_free);
+        gfc_list_delete(config_manager.resourceList);
+    }
+    if (config_manager.retiredResources)
+    {
+        gfc_list_foreach(config_manager.retiredResources,(void (*)(void *))gfc_config_def_resource_free);
+        gfc_list_delete(config_manager.retiredResources);
+    }
+    gfc_hashmap_free(config_manager.resources);
+    gfc_list_delete(config_manager.resourcesById);
+    gfc_hashmap_free(config_manager.resourceIds);
+    if (config_manager.retired)
+    {
+        gfc_list_foreach(config_manager.retired,(void (*)(void *))sj_free);
+        gfc_list_delete(config_manager.retired);
+    }
+    if (config_manager.retiredData)
+    {
+        gfc_list_foreach(config_manager.retiredData,free);
+        gfc_list_delete(config_manager.retiredData);
+    }
+    if (config_manager.files)
+    {
+        gfc_list_foreach(config_manager.files,free);
+        gfc_list_delete(config_manager.files);
+    }
+    if (config_manager.subscribers)
+    {
+        gfc_list_foreach(config_manager.subscribers,free);
+        gfc_list_delete(config_manager.subscribers);
+    }
+    if (config_manager.subscriberLock)SDL_DestroyMutex(config_manager.subscriberLock);
+    if (config_manager.parameters)
+    {
+        gfc_list_foreach(config_manager.parameters,free);
+        gfc_list_delete(config_manager.parameters);
+    }
     if (config_manager.defs)
     {
         gfc_list_foreach(config_manager.defs,(void (*)(void *))sj_free);
         gfc_list_delete(config_manager.defs);
         config_manager.defs = NULL;
     }
+    if (config_manager.caches)
+    {
+        gfc_list_foreach(config_manager.caches,(void (*)(void *))gfc_config_def_cache_free);
+        gfc_list_delete(config_manager.caches);
+    }
     memset(&config_manager,0,sizeof(ConfigManager));
 }
 
 void gfc_config_def_init()
 {
     config_manager.defs = gfc_list_new();
+    config_manager.caches = gfc_list_new();
+    config_manager.resources = gfc_hashmap_new();
+    config_manager.resourceList = gfc_list_new();
+    config_manager.resourcesById = gfc_list_new();
+    config_manager.resourceIds = gfc_hashmap_new();
+    config_manager.parameters = gfc_list_new();
+    config_manager.retired = gfc_list_new();
+    config_manager.retiredData = gfc_list_new();
+    config_manager.retiredResources = gfc_list_new();
+    config_manager.files = gfc_list_new();
+    config_manager.subscriberLock = SDL_CreateMutex();
+    gfc_config_def_register_parameter("name");
     atexit(gfc_config_def_close);
 }
 
+Uint32 gfc_config_def_resource_get_cache_value(ConfigDefResource *resource,Uint32 position)
+{
+    GFC_ConfigDefCache *cache = resource->cache;
+    return cache->values[cache->resources[resource->cacheResource].list].start + position;
+}
+
+SJson *gfc_config_def_resource_get_base(ConfigDefResource *resource,Uint32 position)
+{
+    if (position >= resource->baseCount)return sj_array_get_nth(resource->added,position - resource->baseCount);
+    if (!resource->cache)return sj_array_get_nth(resource->list,position);
+    if (!resource->defs[position])
+    {
+        resource->defs[position] = gfc_config_def_cache_get_json(resource->cache,gfc_config_def_resource_get_cache_value(resource,position));
+    }
+    return resource->defs[position];
+}
+
+SJson *gfc_config_def_resource_get_field(ConfigDefResource *resource,Uint32 position,const char *key)
+{
+    SJson *patch,*value;
+    int i;
+    if (position >= resource->count)return NULL;
+    if ((resource->patches)&&(resource->patches[position]))
+    {
+        //the last overlay to set the key wins, this avoids merging the def just to read one field
+        for (i = gfc_list_get_count(resource->patches[position]) - 1; i >= 0; i--)
+        {
+            patch = gfc_list_get_nth(resource->patches[position],i);
+            value = sj_object_get_value(patch,key);
+            if (!value)continue;
+            if (sj_is_null(value))return NULL;
+            return value;
+        }
+    }
+    return sj_object_get_value(gfc_config_def_resource_get_base(resource,position),key);
+}
+
+const char *gfc_config_def_resource_get_string(ConfigDefResource *resource,Uint32 position,const char *key)
+{
+    GFC_ConfigDefCache *cache = resource->cache;
+    if ((cache)&&(position < resource->baseCount)&&((!resource->patches)||(!resource->patches[position])))
+    {
+        //read straight from the cache so indexing and scans do not build json for every def
+        return gfc_config_def_cache_get_string(cache,
+            gfc_config_def_cache_object_get(cache,gfc_config_def_resource_get_cache_value(resource,position),key));
+    }
+    return sj_get_string_value(gfc_config_def_resource_get_field(resource,position,key));
+}
+
+void gfc_config_def_index_add(ConfigDefIndex *index,ConfigDefResource *resource,Uint32 position)
+{
+    const char *str;
+    str = gfc_config_def_resource_get_string(resource,position,index->parameter);
+    if (!str)return;
+    if (strlen(str) >= GFCLINELEN)return;//too long for a hash key, these are found by scanning
+    if (gfc_hashmap_get(index->map,str))return;//the first def with a value wins, like a scan would
+    gfc_hashmap_insert(index->map,str,(void *)(size_t)(position + 1));
+}
+
+void gfc_config_def_index_fill(ConfigDefIndex *index,ConfigDefResource *resource)
+{
+    Uint32 i;
+    gfc_hashmap_free(index->map);
+    index->map = gfc_hashmap_new();
+    for (i = 0; i < resource->count;i++)
+    {
+        gfc_config_def_index_add(index,resource,i);
+    }
+}
+
+ConfigDefIndex *gfc_config_def_index_build(ConfigDefResource *resource,const char *parameter)
+{
+    ConfigDefIndex *index;
+    index = gfc_allocate_array(sizeof(ConfigDefIndex),1);
+    if (!index)return NULL;
+    gfc_line_cpy(index->parameter,parameter);
+    //a compiled file has its names indexed already
+    if ((resource->cache)&&(!resource->patches)&&(!resource->added)&&(strcmp(parameter,"name")==0))return index;
+    gfc_config_def_index_fill(index,resource);
+    return index;
+}
+
+void gfc_config_def_resource_rebuild_indices(ConfigDefResource *resource)
+{
+    ConfigDefIndex *index;
+    int i,c;
+    c = gfc_list_get_count(resource->indices);
+    for (i = 0; i < c; i++)
+    {
+        index = gfc_list_get_nth(resource->indices,i);
+        if (!index)continue;
+        gfc_config_def_index_fill(index,resource);
+    }
+}
+
+SJson *gfc_config_def_resource_resolve(ConfigDefResource *resource,Uint32 position)
+{
+    SJson *merged,*patch,*value;
+    SJList *keys;
+    const char *key;
+    int i,c,j,k;
+    if (position >= resource->count)return NULL;
+    if ((!resource->patches)||(!resource->patches[position]))
+    {
+        return gfc_config_def_resource_get_base(resource,position);
+    }
+    if (resource->merged[position])return resource->merged[position];
+    merged = sj_copy(gfc_config_def_resource_get_base(resource,position));
+    if (!merged)return NULL;
+    c = gfc_list_get_count(resource->patches[position]);
+    for (i = 0; i < c; i++)
+    {
+        patch = gfc_list_get_nth(resource->patches[position],i);
+        keys = sj_object_get_keys_list(patch);
+        k = sj_list_get_count(keys);
+        for (j = 0; j < k; j++)
+        {
+            key = sj_list_get_nth(keys,j);
+            if (!key)continue;
+            value = sj_object_get_value(patch,key);
+            sj_object_delete_key(merged,key);
+            if ((!value)||(sj_is_null(value)))continue;//null removes the key
+            sj_object_insert(merged,key,sj_copy(value));
+        }
+        sj_list_delete(keys);
+    }
+    resource->merged[position] = merged;
+    return merged;
+}
+
+ConfigDefIndex *gfc_config_def_resource_get_index(ConfigDefResource *resource,const char *parameter)
+{
+    int i,c;
+    ConfigDefIndex *index;
+    if ((!resource)||(!parameter))return NULL;
+    c = gfc_list_get_count(resource->indices);
+    for (i = 0; i < c; i++)
+    {
+        index = gfc_list_get_nth(resource->indices,i);
+        if (!index)continue;
+        if (strcmp(index->parameter,parameter)==0)return index;
+    }
+    return NULL;
+}
+
+ConfigDefResource *gfc_config_def_resource_new(const char *name,SJson *list,GFC_ConfigDefCache *cache,Uint32 cacheResource)
+{
+    int i,c;
+    const char *parameter;
+    ConfigDefResource *resource;
+    resource = gfc_allocate_array(sizeof(ConfigDefResource),1);
+    if (!resource)return NULL;
+    gfc_line_cpy(resource->name,name);
+    resource->version = 1;
+    if (cache)
+    {
+        resource->cache = cache;
+        resource->cacheResource = cacheResource;
+        resource->baseCount = cache->values[cache->resources[cacheResource].list].count;
+        resource->defs = gfc_allocate_array(sizeof(SJson *),MAX(resource->baseCount,1));
+        if (!resource->defs)
+        {
+            free(resource);
+            return NULL;
+        }
+    }
+    else
+    {
+        resource->list = list;
+        resource->baseCount = sj_array_get_count(list);
+    }
+    resource->count = resource->baseCount;
+    resource->indices = gfc_list_new();
+    c = gfc_list_get_count(config_manager.parameters);
+    for (i = 0; i < c; i++)
+    {
+        parameter = gfc_list_get_nth(config_manager.parameters,i);
+        if (!parameter)continue;
+        resource->indices = gfc_list_append(resource->indices,gfc_config_def_index_build(resource,parameter));
+    }
+    return resource;
+}
+
+void gfc_config_def_resource_set_id(ConfigDefResource *resource)
+{
+    Uint32 id;
+    id = (Uint32)(size_t)gfc_hashmap_get(config_manager.resourceIds,resource->name);
+    if (!id)
+    {
+        if (gfc_list_get_count(config_manager.resourcesById) >= GFC_CONFIG_DEF_MAX_RESOURCES)
+        {
+            slog("too many config def resources, %s cannot be found by handle",resource->name);
+            return;
+        }
+        config_manager.resourcesById = gfc_list_append(config_manager.resourcesById,NULL);
+        id = gfc_list_get_count(config_manager.resourcesById);
+        gfc_hashmap_insert(config_manager.resourceIds,resource->name,(void *)(size_t)id);
+    }
+    resource->id = id;
+    gfc_list_set_nth(config_manager.resourcesById,id - 1,resource);
+}
+
+Bool gfc_config_def_resource_can_add(const char *name,Bool isArray)
+{
+    if (strlen(name) >= GFCLINELEN)
+    {
+        slog("config def resource name %s is too long, it will not be found",name);
+        return 0;
+    }
+    if (gfc_hashmap_get(config_manager.resources,name))return 0;//an earlier file already provides this resource
+    if (!isArray)
+    {
+        slog("config def key %s is not an array of defs, skipping it",name);
+        return 0;
+    }
+    return 1;
+}
+
+void gfc_config_def_resource_add_source(ConfigDefResource *resource,SJson *json)
+{
+    if (!resource->sources)resource->sources = gfc_list_new();
+    if (gfc_list_get_item_index(resource->sources,json) >= 0)return;
+    resource->sources = gfc_list_append(resource->sources,json);
+}
+
+void gfc_config_def_resource_insert(ConfigDefResource *resource)
+{
+    gfc_config_def_resource_set_id(resource);
+    gfc_hashmap_insert(config_manager.resources,resource->name,resource);
+    config_manager.resourceList = gfc_list_append(config_manager.resourceList,resource);
+}
+
+void gfc_config_def_resource_add(const char *name,SJson *json)
+{
+    ConfigDefResource *resource;
+    SJson *list;
+    if ((!name)||(!json))return;
+    list = sj_object_get_value(json,name);
+    if (!list)return;
+    if (!gfc_config_def_resource_can_add(name,sj_is_array(list)))return;
+    resource = gfc_config_def_resource_new(name,list,NULL,0);
+    if (!resource)return;
+    gfc_config_def_resource_add_source(resource,json);
+    gfc_config_def_resource_insert(resource);
+}
+
+void gfc_config_def_resource_add_cached(GFC_ConfigDefCache *cache,Uint32 value)
+{
+    ConfigDefResource *resource;
+    const char *name;
+    Sint32 cacheResource;
+    name = &cache->strings[cache->values[value].key];
+    if (!gfc_config_def_resource_can_add(name,cache->values[value].type == CDCV_Array))return;
+    cacheResource = gfc_config_def_cache_get_resource(cache,name);
+    if (cacheResource < 0)return;
+    resource = gfc_config_def_resource_new(name,NULL,cache,cacheResource);
+    if (!resource)return;
+    gfc_config_def_resource_insert(resource);
+}
+
+void gfc_config_def_register_parameter(const char *parameter)
+{
+    int i,c;
+    char *copy;
+    ConfigDefResource *resource;
+    if ((!parameter)||(!config_manager.parameters))return;
+    if (strlen(parameter) >= GFCLINELEN)
+    {
+        slog("config def parameter %s is too long to index",parameter);
+        return;
+    }
+    c = gfc_list_get_count(config_manager.parameters);
+    for (i = 0; i < c; i++)
+    {
+        if (strcmp(gfc_list_get_nth(config_manager.parameters,i),parameter)==0)return;
+    }
+    copy = gfc_allocate_array(sizeof(TextLine),1);
+    if (!copy)return;
+    gfc_line_cpy(copy,parameter);
+    config_manager.parameters = gfc_list_append(config_manager.parameters,copy);
+    //index the resources that are already loaded
+    c = gfc_list_get_count(config_manager.resourceList);
+    for (i = 0; i < c; i++)
+    {
+        resource = gfc_list_get_nth(config_manager.resourceList,i);
+        if (!resource)continue;
+        resource->indices = gfc_list_append(resource->indices,gfc_config_def_index_build(resource,copy));
+    }
+}
+
+void gfc_config_def_set_cache_dir(const char *dir)
+{
+    if (!dir)
+    {
+        gfc_block_clear(config_manager.cacheDir);
+        return;
+    }
+    gfc_block_cpy(config_manager.cacheDir,dir);
+}
+
+void gfc_config_def_get_cache_path(const char *filename,TextBlock path)
+{
+    TextBlock name;
+    char *c;
+    gfc_block_cpy(name,filename);
+    for (c = name; *c != 0; c++)
+    {
+        if ((*c == '/')||(*c == '\\')||(*c == ':'))*c = '_';
+    }
+    gfc_block_sprintf(path,"%s/%s.gdef",config_manager.cacheDir,name);
+}
+
+GFC_ConfigDefCache *gfc_config_def_load_cache(const char *filename)
+{
+    GFC_ConfigDefCache *cache;
+    GFC_PakFileInfo info;
+    GFC_JsonDoc *doc;
+    TextBlock path;
+    void *data;
+    size_t size = 0;
+    Uint32 crc;
+    if (!gfc_pak_file_get_info(filename,&info))return NULL;
+    gfc_config_def_get_cache_path(filename,path);
+    cache = gfc_config_def_cache_load(path);
+    //a pak already knows the crc of each file, a loose file is trusted if its size and time have not moved
+    if ((cache)&&(cache->header->sourceSize == info.size))
+    {
+        if ((info.inPak)&&(cache->header->sourceCrc == info.crc))return cache;
+        if ((!info.inPak)&&(info.mtime)&&(cache->header->sourceTime == info.mtime))return cache;
+    }
+    data = gfc_pak_file_extract(filename,&size);
+    if (!data)
+    {
+        gfc_config_def_cache_free(cache);
+        return NULL;
+    }
+    crc = mz_crc32(MZ_CRC32_INIT,data,size);
+    if ((cache)&&(cache->header->sourceCrc == crc)&&(cache->header->sourceSize == size))
+    {
+        //touched but not changed, remember the new time so the next load does not read it again
+        free(data);
+        if (!info.inPak)gfc_config_def_cache_set_source_time(path,info.mtime);
+        return cache;
+    }
+    gfc_config_def_cache_free(cache);
+    //no cache or the def has changed since it was compiled
+    doc = gfc_json_doc_parse(data,size);
+    free(data);
+    if (!doc)return NULL;
+    cache = gfc_config_def_cache_compile(doc->root,crc,size,info.inPak ? 0 : info.mtime);
+    gfc_json_doc_free(doc);
+    gfc_config_def_cache_save(cache,path);
+    return cache;
+}
+
+SJson *gfc_config_def_load_json(const char *filename)
+{
+    GFC_ConfigDefCache *cache;
+    SJson *json;
+    if (!strlen(config_manager.cacheDir))return gfc_pak_load_json(filename);
+    cache = gfc_config_def_load_cache(filename);
+    if (!cache)return NULL;
+    json = gfc_config_def_cache_to_json(cache);
+    gfc_config_def_cache_free(cache);
+    return json;
+}
+
+Bool gfc_config_def_compile(const char *filename)
+{
+    GFC_ConfigDefCache *cache;
+    if (!filename)return 0;
+    if (!strlen(config_manager.cacheDir))
+    {
+        slog("no config def cache directory set, cannot compile %s",filename);
+        return 0;
+    }
+    cache = gfc_config_def_load_cache(filename);
+    if (!cache)
+    {
+        slog("failed to compile config def file %s",filename);
+        return 0;
+    }
+    gfc_config_def_cache_free(cache);
+    return 1;
+}
+
+void gfc_config_def_file_add(const char *filename,SJson *json,GFC_ConfigDefCache *cache,Uint8 overlay)
+{
+    ConfigDefFile *file;
+    if (json)config_manager.defs = gfc_list_append(config_manager.defs,json);
+    if (cache)config_manager.caches = gfc_list_append(config_manager.caches,cache);
+    file = gfc_allocate_array(sizeof(ConfigDefFile),1);
+    if (!file)return;
+    gfc_block_cpy(file->filename,filename);
+    file->json = json;
+    file->cache = cache;
+    file->overlay = overlay;
+    config_manager.files = gfc_list_append(config_manager.files,file);
+}
+
+ConfigDefFile *gfc_config_def_file_get(const char *filename)
+{
+    ConfigDefFile *file;
+    int i,c;
+    c = gfc_list_get_count(config_manager.files);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(config_manager.files,i);
+        if ((file)&&(strcmp(file->filename,filename)==0))return file;
+    }
+    return NULL;
+}
+
+void gfc_config_def_install(const char *filename,SJson *json)
+{
+    int i,c;
+    const char *key;
+    SJList *keys;
+    gfc_config_def_file_add(filename,json,NULL,0);
+    keys = sj_object_get_keys_list(json);
+    if (!keys)return;
+    c = sj_list_get_count(keys);
+    for (i = 0; i < c; i++)
+    {
+        key = sj_list_get_nth(keys,i);
+        if (!key)continue;
+        gfc_config_def_resource_add(key,json);
+    }
+    sj_list_delete(keys);
+}
+
+void gfc_config_def_install_cache(const char *filename,GFC_ConfigDefCache *cache)
+{
+    GFC_ConfigDefCacheValue *root;
+    Uint32 i;
+    gfc_config_def_file_add(filename,NULL,cache,0);
+    root = &cache->values[0];
+    if (root->type != CDCV_Object)return;
+    for (i = 0; i < root->count; i++)
+    {
+        gfc_config_def_resource_add_cached(cache,root->start + i);
+    }
+}
+
 void gfc_config_def_load(const char *filename)
 {
+    GFC_ConfigDefCache *cache;
     SJson *json;
     if (!filename)return;
-    
-
-    json = gfc_pak_load_json(filename);
+    if (!config_manager.defs)
+    {
+        slog("config def system not initialized");
+        return;
+    }
+    if (strlen(config_manager.cacheDir))
+    {
+        //defs are read straight from the compiled file
+        cache = gfc_config_def_load_cache(filename);
+        if (!cache)
+        {
+            slog("failed to load config def file %s",filename);
+            return;
+        }
+        gfc_config_def_install_cache(filename,cache);
+        return;
+    }
+    json = gfc_config_def_load_json(filename);
     if (!json)
     {
         slog("failed to load config def file %s",filename);
         return;
     }
-    gfc_list_append(config_manager.defs,json);
+    gfc_config_def_install(filename,json);
+}
+
+int gfc_config_def_load_worker(void *data)
+{
+    ConfigDefLoadJob *job = (ConfigDefLoadJob *)data;
+    int i,j;
+    while ((i = SDL_AtomicAdd(&job->next,1)) < (int)job->count)
+    {
+        if (!job->filenames[i])continue;
+        //a file listed twice is only loaded once, and two workers never write the same cache file
+        for (j = 0; j < i; j++)
+        {
+            if ((job->filenames[j])&&(strcmp(job->filenames[i],job->filenames[j])==0))break;
+        }
+        if (j < i)continue;
+        if (job->caches)
+        {
+            job->caches[i] = gfc_config_def_load_cache(job->filenames[i]);
+            if (!job->caches[i])slog("failed to load config def file %s",job->filenames[i]);
+            continue;
+        }
+        job->json[i] = gfc_config_def_load_json(job->filenames[i]);
+        if (!job->json[i])slog("failed to load config def file %s",job->filenames[i]);
+    }
+    return 0;
+}
+
+void gfc_config_def_load_many(const char **filenames,Uint32 count)
+{
+    ConfigDefLoadJob job = {0};
+    SDL_Thread *threads[GFC_CONFIG_DEF_MAX_LOAD_THREADS] = {0};
+    int threadCount,i;
+    Uint32 n;
+    if ((!filenames)||(!count))return;
+    if (!config_manager.defs)
+    {
+        slog("config def system not initialized");
+        return;
+    }
+    job.filenames = filenames;
+    job.count = count;
+    job.json = gfc_allocate_array(sizeof(SJson *),count);
+    if (!job.json)return;
+    if (strlen(config_manager.cacheDir))
+    {
+        job.caches = gfc_allocate_array(sizeof(GFC_ConfigDefCache *),count);
+        if (!job.caches)
+        {
+            free(job.json);
+            return;
+        }
+    }
+    threadCount = MIN(SDL_GetCPUCount(),GFC_CONFIG_DEF_MAX_LOAD_THREADS);
+    if (threadCount > (int)count)threadCount = count;
+    //this thread works too, so one fewer is spawned
+    for (i = 0; i < threadCount - 1; i++)
+    {
+        threads[i] = SDL_CreateThread(gfc_config_def_load_worker,"gfc_config_def_load",&job);
+    }
+    gfc_config_def_load_worker(&job);
+    for (i = 0; i < threadCount - 1; i++)
+    {
+        if (threads[i])SDL_WaitThread(threads[i],NULL);
+    }
+    //install in the order given so which file provides a resource does not depend on which parsed first
+    for (n = 0; n < count; n++)
+    {
+        if ((job.caches)&&(job.caches[n]))gfc_config_def_install_cache(filenames[n],job.caches[n]);
+        if (job.json[n])gfc_config_def_install(filenames[n],job.json[n]);
+    }
+    if (job.caches)free(job.caches);
+    free(job.json);
+}
+
+ConfigDefResource *gfc_config_def_get_resource(const char *resource)
+{
+    if ((!resource)||(!config_manager.resources))return NULL;
+    return gfc_hashmap_get(config_manager.resources,resource);
 }
 
 SJson *gfc_config_def_get_resource_by_name(const char *resource)
 {
-    SJson *list,*item;
+    ConfigDefResource *def;
+    SJson *list;
+    Uint32 i;
+    def = gfc_config_def_get_resource(resource);
+    if (!def)return NULL;
+    if ((!def->patches)&&(!def->added)&&(def->list))return def->list;
+    if (def->mergedList)return def->mergedList;
+    if ((!def->patches)&&(!def->added))
+    {
+        def->mergedList = gfc_config_def_cache_get_json(def->cache,def->cache->resources[def->cacheResource].list);
+        return def->mergedList;
+    }
+    list = sj_array_new();
+    if (!list)return NULL;
+    for (i = 0; i < def->count; i++)
+    {
+        sj_array_append(list,sj_copy(gfc_config_def_resource_resolve(def,i)));
+    }
+    def->mergedList = list;
+    return list;
+}
+
+Sint32 gfc_config_def_find_position(ConfigDefResource *def,const char *parameter,const char *name)
+{
+    const char *str;
+    Uint32 i;
+    ConfigDefIndex *index;
+    if ((!def)||(!parameter)||(!name))return -1;
+    index = gfc_config_def_resource_get_index(def,parameter);
+    if ((index)&&(!index->map))
+    {
+        return gfc_config_def_cache_find(def->cache,def->cacheResource,name);
+    }
+    if ((index)&&(strlen(name) < GFCLINELEN))
+    {
+        return (Sint32)(size_t)gfc_hashmap_get(index->map,name) - 1;
+    }
+    //not an indexed parameter, scan for it
+    for (i = 0; i < def->count;i++)
+    {
+        str = gfc_config_def_resource_get_string(def,i,parameter);
+        if (!str)continue;
+        if (strcmp(name,str)==0)return i;
+    }
+    return -1;
+}
+
+void gfc_config_def_resource_retire_list(ConfigDefResource *resource)
+{
+    if (!resource->mergedList)return;
+    config_manager.retired = gfc_list_append(config_manager.retired,resource->mergedList);
+    resource->mergedList = NULL;
+}
+
+Bool gfc_config_def_resource_grow(ConfigDefResource *resource)
+{
+    ConfigDefBinding *binding;
+    List **patches;
+    SJson **merged;
+    Uint8 *data,*decoded;
+    Uint32 count;
     int i,c;
-    if (!resource)return NULL;
-    if (!config_manager.defs)return NULL;
-    c = gfc_list_get_count(config_manager.defs);
-    for (i = 0; i < c;i++)
+    count = resource->count + 1;
+    if (resource->patches)
     {
-        list = gfc_list_get_nth(config_manager.defs,i);
-        if (!list)continue;
-        item = sj_object_get_value(list,resource);
-        if (item)return item;
+        patches = gfc_allocate_array(sizeof(List *),count);
+        merged = gfc_allocate_array(sizeof(SJson *),count);
+        if ((!patches)||(!merged))
+        {
+            if (patches)free(patches);
+            if (merged)free(merged);
+            return 0;
+        }
+        memcpy(patches,resource->patches,sizeof(List *) * resource->count);
+        memcpy(merged,resource->merged,sizeof(SJson *) * resource->count);
+        free(resource->patches);
+        free(resource->merged);
+        resource->patches = patches;
+        resource->merged = merged;
     }
-    return NULL;
+    c = gfc_list_get_count(resource->bindings);
+    for (i = 0; i < c; i++)
+    {
+        binding = gfc_list_get_nth(resource->bindings,i);
+        if (!binding)continue;
+        data = gfc_allocate_array(binding->schema->size,count);
+        decoded = gfc_allocate_array(sizeof(Uint8),count);
+        if ((!data)||(!decoded))
+        {
+            if (data)free(data);
+            if (decoded)free(decoded);
+            return 0;
+        }
+        memcpy(data,binding->data,binding->schema->size * resource->count);
+        memcpy(decoded,binding->decoded,resource->count);
+        //structs already handed out stay readable, they just stop getting updates
+        config_manager.retiredData = gfc_list_append(config_manager.retiredData,binding->data);
+        free(binding->decoded);
+        binding->data = data;
+        binding->decoded = decoded;
+    }
+    resource->count = count;
+    return 1;
 }
 
-SJson *gfc_config_def_get_by_index(const char *resource,Uint8 index)
+void gfc_config_def_resource_patch(ConfigDefResource *resource,Uint32 position,SJson *patch)
 {
+    ConfigDefBinding *binding;
+    int i,c;
+    if (!resource->patches)
+    {
+        resource->patches = gfc_allocate_array(sizeof(List *),resource->count);
+        resource->merged = gfc_allocate_array(sizeof(SJson *),resource->count);
+        if ((!resource->patches)||(!resource->merged))
+        {
+            if (resource->patches)free(resource->patches);
+            if (resource->merged)free(resource->merged);
+            resource->patches = NULL;
+            resource->merged = NULL;
+            return;
+        }
+    }
+    if (!resource->patches[position])resource->patches[position] = gfc_list_new();
+    resource->patches[position] = gfc_list_append(resource->patches[position],patch);
+    if (resource->merged[position])
+    {
+        config_manager.retired = gfc_list_append(config_manager.retired,resource->merged[position]);
+        resource->merged[position] = NULL;
+    }
+    gfc_config_def_resource_retire_list(resource);
+    c = gfc_list_get_count(resource->bindings);
+    for (i = 0; i < c; i++)
+    {
+        binding = gfc_list_get_nth(resource->bindings,i);
+        if (binding)binding->decoded[position] = 0;
+    }
+}
+
+void gfc_config_def_resource_apply_overlay(ConfigDefResource *resource,SJson *json)
+{
+    ConfigDefIndex *index;
+    SJson *list,*patch;
+    const char *name;
+    Sint32 position;
+    Bool patched = 0;
+    int i,c,j,k;
+    list = sj_object_get_value(json,resource->name);
+    c = sj_array_get_count(list);
+    for (i = 0; i < c; i++)
+    {
+        patch = sj_array_get_nth(list,i);
+        if (!sj_is_object(patch))continue;
+        name = sj_get_string_value(sj_object_get_value(patch,"name"));
+        if (!name)
+        {
+            slog("config def overlay entry %i has no name, it cannot be matched to a def",i);
+            continue;
+        }
+        position = gfc_config_def_find_position(resource,"name",name);
+        if (position >= 0)
+        {
+            gfc_config_def_resource_patch(resource,position,patch);
+            gfc_config_def_resource_add_source(resource,json);
+            patched = 1;
+            continue;
+        }
+        //a def the base files do not have
+        if (!gfc_config_def_resource_grow(resource))continue;
+        if (!resource->added)resource->added = sj_array_new();
+        sj_array_append(resource->added,sj_copy(patch));
+        gfc_config_def_resource_retire_list(resource);
+        k = gfc_list_get_count(resource->indices);
+        for (j = 0; j < k; j++)
+        {
+            index = gfc_list_get_nth(resource->indices,j);
+            if (!index)continue;
+            //the cache's name table does not know about added defs
+            if (!index->map)gfc_config_def_index_fill(index,resource);
+            else gfc_config_def_index_add(index,resource,resource->count - 1);
+        }
+    }
+    //a patch may have changed an indexed key
+    if (patched)gfc_config_def_resource_rebuild_indices(resource);
+}
+
+void gfc_config_def_load_overlay(const char *filename)
+{
+    int i,c;
+    const char *key;
+    SJList *keys;
+    SJson *json,*list;
+    ConfigDefResource *resource;
+    if (!filename)return;
+    if (!config_manager.defs)
+    {
+        slog("config def system not initialized");
+        return;
+    }
+    json = gfc_config_def_load_json(filename);
+    if (!json)
+    {
+        slog("failed to load config def overlay %s",filename);
+        return;
+    }
+    gfc_config_def_file_add(filename,json,NULL,1);
+    keys = sj_object_get_keys_list(json);
+    if (!keys)return;
+    c = sj_list_get_count(keys);
+    for (i = 0; i < c; i++)
+    {
+        key = sj_list_get_nth(keys,i);
+        if (!key)continue;
+        list = sj_object_get_value(json,key);
+        if (!sj_is_array(list))continue;
+        resource = gfc_config_def_get_resource(key);
+        if (!resource)
+        {
+            gfc_config_def_resource_add(key,json);
+            continue;
+        }
+        gfc_config_def_resource_apply_overlay(resource,json);
+    }
+    sj_list_delete(keys);
+}
+
+Bool gfc_config_def_json_equal(SJson *a,SJson *b)
+{
+    const char *key,*strA,*strB;
+    short int boolA = 0,boolB = 0;
+    SJList *keys;
+    int i,c;
+    Bool equal = 1;
+    if ((!a)||(!b))return a == b;
+    if (sj_is_array(a))
+    {
+        if (!sj_is_array(b))return 0;
+        c = sj_array_get_count(a);
+        if (c != sj_array_get_count(b))return 0;
+        for (i = 0; i < c; i++)
+        {
+            if (!gfc_config_def_json_equal(sj_array_get_nth(a,i),sj_array_get_nth(b,i)))return 0;
+        }
+        return 1;
+    }
+    if (sj_is_object(a))
+    {
+        if (!sj_is_object(b))return 0;
+        keys = sj_object_get_keys_list(a);
+        c = sj_list_get_count(keys);
+        for (i = 0; (equal)&&(i < c); i++)
+        {
+            key = sj_list_get_nth(keys,i);
+            if (!key)continue;
+            equal = gfc_config_def_json_equal(sj_object_get_value(a,key),sj_object_get_value(b,key));
+        }
+        sj_list_delete(keys);
+        if (!equal)return 0;
+        //every key of a is in b, so b only differs if it has more
+        keys = sj_object_get_keys_list(b);
+        i = sj_list_get_count(keys);
+        sj_list_delete(keys);
+        return i == c;
+    }
+    strA = sj_get_string_value(a);
+    strB = sj_get_string_value(b);
+    if ((strA)||(strB))
+    {
+        if ((!strA)||(!strB))return 0;
+        return strcmp(strA,strB) == 0;
+    }
+    if (sj_is_bool(a))
+    {
+        if (!sj_is_bool(b))return 0;
+        sj_get_bool_value(a,&boolA);
+        sj_get_bool_value(b,&boolB);
+        return boolA == boolB;
+    }
+    return sj_is_null(a) == sj_is_null(b);
+}
+
+ConfigDefResource *gfc_config_def_resource_build(const char *name)
+{
+    ConfigDefResource *resource = NULL;
+    ConfigDefFile *file;
     SJson *list;
+    Sint32 cacheResource;
+    int i,c;
+    //replay the files in load order, the same way they were first loaded
+    c = gfc_list_get_count(config_manager.files);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(config_manager.files,i);
+        if (!file)continue;
+        if (file->cache)
+        {
+            if (resource)continue;//compiled files are never overlays
+            cacheResource = gfc_config_def_cache_get_resource(file->cache,name);
+            if (cacheResource >= 0)resource = gfc_config_def_resource_new(name,NULL,file->cache,cacheResource);
+            continue;
+        }
+        list = sj_object_get_value(file->json,name);
+        if (!sj_is_array(list))continue;
+        if (!resource)
+        {
+            resource = gfc_config_def_resource_new(name,list,NULL,0);
+            if (resource)gfc_config_def_resource_add_source(resource,file->json);
+            continue;
+        }
+        if (file->overlay)gfc_config_def_resource_apply_overlay(resource,file->json);
+    }
+    return resource;
+}
+
+void gfc_config_def_resource_replace(const char *name,ConfigDefResource *resource)
+{
+    ConfigDefResource *old;
+    old = gfc_hashmap_get(config_manager.resources,name);
+    if (old)
+    {
+        gfc_hashmap_delete_by_key(config_manager.resources,name);
+        gfc_list_delete_data(config_manager.resourceList,old);
+        config_manager.retiredResources = gfc_list_append(config_manager.retiredResources,old);
+        if (resource)resource->version = old->version + 1;
+        else if (old->id)gfc_list_set_nth(config_manager.resourcesById,old->id - 1,NULL);
+    }
+    if (!resource)return;
+    gfc_config_def_resource_set_id(resource);
+    gfc_hashmap_insert(config_manager.resources,name,resource);
+    config_manager.resourceList = gfc_list_append(config_manager.resourceList,resource);
+}
+
+void gfc_config_def_notify(const char *resource)
+{
+    ConfigDefSubscriber *subscriber,*subscribers = NULL;
+    int i,c;
+    //call a copy of the list without the lock held, so subscribers can subscribe or unsubscribe
+    SDL_LockMutex(config_manager.subscriberLock);
+    c = gfc_list_get_count(config_manager.subscribers);
+    if (c)subscribers = gfc_allocate_array(sizeof(ConfigDefSubscriber),c);
+    if (!subscribers)c = 0;
+    for (i = 0; i < c; i++)
+    {
+        subscriber = gfc_list_get_nth(config_manager.subscribers,i);
+        if (subscriber)subscribers[i] = *subscriber;
+    }
+    SDL_UnlockMutex(config_manager.subscriberLock);
+    for (i = 0; i < c; i++)
+    {
+        if (subscribers[i].func)subscribers[i].func(resource,subscribers[i].data);
+    }
+    if (subscribers)free(subscribers);
+}
+
+List *gfc_config_def_json_changes(SJson *old,SJson *json,SJList *oldKeys,SJList *newKeys)
+{
+    List *changed;
+    const char *key;
+    int i,c;
+    changed = gfc_list_new();
+    c = sj_list_get_count(newKeys);
+    for (i = 0; i < c; i++)
+    {
+        key = sj_list_get_nth(newKeys,i);
+        if ((!key)||(strlen(key) >= GFCLINELEN))continue;
+        if (gfc_config_def_json_equal(sj_object_get_value(old,key),sj_object_get_value(json,key)))continue;
+        changed = gfc_list_append(changed,(void *)key);
+    }
+    c = sj_list_get_count(oldKeys);
+    for (i = 0; i < c; i++)
+    {
+        key = sj_list_get_nth(oldKeys,i);
+        if ((!key)||(strlen(key) >= GFCLINELEN))continue;
+        if (sj_object_get_value(json,key))continue;
+        changed = gfc_list_append(changed,(void *)key);//removed from the file
+    }
+    return changed;
+}
+
+List *gfc_config_def_cache_changes(GFC_ConfigDefCache *old,GFC_ConfigDefCache *cache)
+{
+    List *changed;
+    const char *key;
+    Uint32 i,value;
+    changed = gfc_list_new();
+    for (i = 0; (cache->values[0].type == CDCV_Object)&&(i < cache->values[0].count); i++)
+    {
+        key = &cache->strings[cache->values[cache->values[0].start + i].key];
+        if (strlen(key) >= GFCLINELEN)continue;
+        value = gfc_config_def_cache_object_get(old,0,key);
+        if ((value)&&(gfc_config_def_cache_equal(old,value,cache,cache->values[0].start + i)))continue;
+        changed = gfc_list_append(changed,(void *)key);
+    }
+    for (i = 0; (old->values[0].type == CDCV_Object)&&(i < old->values[0].count); i++)
+    {
+        key = &old->strings[old->values[old->values[0].start + i].key];
+        if (strlen(key) >= GFCLINELEN)continue;
+        if (gfc_config_def_cache_object_get(cache,0,key))continue;
+        changed = gfc_list_append(changed,(void *)key);//removed from the file
+    }
+    return changed;
+}
+
+Bool gfc_config_def_reload(const char *filename)
+{
+    ConfigDefFile *file;
+    GFC_ConfigDefCache *cache = NULL;
+    SJson *json = NULL;
+    SJList *newKeys = NULL,*oldKeys = NULL;
+    List *changed,*built;
+    int i,c;
+    if ((!filename)||(!config_manager.defs))return 0;
+    file = gfc_config_def_file_get(filename);
+    if (!file)
+    {
+        slog("config def file %s was never loaded, it cannot be reloaded",filename);
+        return 0;
+    }
+    if (file->cache)
+    {
+        if (!strlen(config_manager.cacheDir))
+        {
+            slog("config def file %s was loaded from the cache, it cannot be reloaded without a cache directory",filename);
+            return 0;
+        }
+        cache = gfc_config_def_load_cache(filename);
+    }
+    else json = gfc_config_def_load_json(filename);
+    if ((!json)&&(!cache))
+    {
+        slog("failed to reload config def file %s, keeping the defs already loaded",filename);
+        return 0;
+    }
+    if (cache)
+    {
+        changed = gfc_config_def_cache_changes(file->cache,cache);
+        //the old cache stays mapped, unchanged resources and returned defs still point into it
+        config_manager.caches = gfc_list_append(config_manager.caches,cache);
+        file->cache = cache;
+    }
+    else
+    {
+        newKeys = sj_object_get_keys_list(json);
+        oldKeys = sj_object_get_keys_list(file->json);
+        changed = gfc_config_def_json_changes(file->json,json,oldKeys,newKeys);
+        //the old json stays in the defs list, unchanged resources and returned defs still point into it
+        config_manager.defs = gfc_list_append(config_manager.defs,json);
+        file->json = json;
+    }
+    //build every changed resource before any is swapped in, so lookups never see half a reload
+    c = gfc_list_get_count(changed);
+    built = gfc_list_new();
+    for (i = 0; i < c; i++)
+    {
+        built = gfc_list_append(built,gfc_config_def_resource_build(gfc_list_get_nth(changed,i)));
+    }
+    for (i = 0; i < c; i++)
+    {
+        gfc_config_def_resource_replace(gfc_list_get_nth(changed,i),gfc_list_get_nth(built,i));
+    }
+    for (i = 0; i < c; i++)
+    {
+        gfc_config_def_notify(gfc_list_get_nth(changed,i));
+    }
+    gfc_list_delete(built);
+    gfc_list_delete(changed);
+    if (newKeys)sj_list_delete(newKeys);
+    if (oldKeys)sj_list_delete(oldKeys);
+    return 1;
+}
+
+/**
+ * @brief check whether anything still loaded reads from a json document
+ */
+Bool gfc_config_def_json_in_use(SJson *json)
+{
+    ConfigDefResource *resource;
+    ConfigDefFile *file;
+    int i,c;
+    c = gfc_list_get_count(config_manager.files);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(config_manager.files,i);
+        if ((file)&&(file->json == json))return 1;
+    }
+    c = gfc_list_get_count(config_manager.resourceList);
+    for (i = 0; i < c; i++)
+    {
+        resource = gfc_list_get_nth(config_manager.resourceList,i);
+        if ((resource)&&(resource->sources)&&(gfc_list_get_item_index(resource->sources,json) >= 0))return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief check whether anything still loaded reads from a compiled file
+ */
+Bool gfc_config_def_cache_in_use(GFC_ConfigDefCache *cache)
+{
+    ConfigDefResource *resource;
+    ConfigDefFile *file;
+    int i,c;
+    c = gfc_list_get_count(config_manager.files);
+    for (i = 0; i < c; i++)
+    {
+        file = gfc_list_get_nth(config_manager.files,i);
+        if ((file)&&(file->cache == cache))return 1;
+    }
+    c = gfc_list_get_count(config_manager.resourceList);
+    for (i = 0; i < c; i++)
+    {
+        resource = gfc_list_get_nth(config_manager.resourceList,i);
+        if ((resource)&&(resource->cache == cache))return 1;
+    }
+    return 0;
+}
+
+void gfc_config_def_collect()
+{
+    SJson *json;
+    GFC_ConfigDefCache *cache;
+    int i;
+    if (!config_manager.defs)return;
+    gfc_list_foreach(config_manager.retiredResources,(void (*)(void *))gfc_config_def_resource_free);
+    gfc_list_clear(config_manager.retiredResources);
+    gfc_list_foreach(config_manager.retired,(void (*)(void *))sj_free);
+    gfc_list_clear(config_manager.retired);
+    gfc_list_foreach(config_manager.retiredData,free);
+    gfc_list_clear(config_manager.retiredData);
+    //only retired resources could still point into replaced files, and they are gone now
+    for (i = gfc_list_get_count(config_manager.defs) - 1; i >= 0; i--)
+    {
+        json = gfc_list_get_nth(config_manager.defs,i);
+        if (gfc_config_def_json_in_use(json))continue;
+        gfc_list_delete_nth(config_manager.defs,i);
+        sj_free(json);
+    }
+    for (i = gfc_list_get_count(config_manager.caches) - 1; i >= 0; i--)
+    {
+        cache = gfc_list_get_nth(config_manager.caches,i);
+        if (gfc_config_def_cache_in_use(cache))continue;
+        gfc_list_delete_nth(config_manager.caches,i);
+        gfc_config_def_cache_free(cache);
+    }
+}
+
+void gfc_config_def_file_changed(const char *filename,void *data)
+{
+    if (!gfc_config_def_file_get(filename))return;//not a def file
+    gfc_config_def_reload(filename);
+}
+
+void gfc_config_def_watch(Bool enable)
+{
+    gfc_pak_manager_unsubscribe(gfc_config_def_file_changed,NULL);
+    if (enable)gfc_pak_manager_subscribe(gfc_config_def_file_changed,NULL);
+}
+
+void gfc_config_def_subscribe(gfc_config_def_change_func *func,void *data)
+{
+    ConfigDefSubscriber *subscriber;
+    if (!func)return;
+    subscriber = gfc_allocate_array(sizeof(ConfigDefSubscriber),1);
+    if (!subscriber)return;
+    subscriber->func = func;
+    subscriber->data = data;
+    SDL_LockMutex(config_manager.subscriberLock);
+    if (!config_manager.subscribers)config_manager.subscribers = gfc_list_new();
+    config_manager.subscribers = gfc_list_append(config_manager.subscribers,subscriber);
+    SDL_UnlockMutex(config_manager.subscriberLock);
+}
+
+void gfc_config_def_unsubscribe(gfc_config_def_change_func *func,void *data)
+{
+    ConfigDefSubscriber *subscriber;
+    int i,c;
+    SDL_LockMutex(config_manager.subscriberLock);
+    c = gfc_list_get_count(config_manager.subscribers);
+    for (i = 0; i < c; i++)
+    {
+        subscriber = gfc_list_get_nth(config_manager.subscribers,i);
+        if (!subscriber)continue;
+        if ((subscriber->func != func)||(subscriber->data != data))continue;
+        gfc_list_delete_nth(config_manager.subscribers,i);
+        free(subscriber);
+        break;
+    }
+    SDL_UnlockMutex(config_manager.subscriberLock);
+}
+
+SJson *gfc_config_def_find(const char *resource,const char *parameter,const char *name)
+{
+    ConfigDefResource *def;
+    Sint32 position;
+    def = gfc_config_def_get_resource(resource);
+    position = gfc_config_def_find_position(def,parameter,name);
+    if (position < 0)return NULL;
+    return gfc_config_def_resource_resolve(def,position);
+}
+
+SJson *gfc_config_def_get_by_index(const char *resource,Uint32 index)
+{
+    ConfigDefResource *def;
     if (!config_manager.defs)
     {
         slog("config def file not loaded");
         return NULL;
     }
     if (!resource)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    return sj_array_get_nth(list,index);
+    def = gfc_config_def_get_resource(resource);
+    if (!def)return NULL;
+    return gfc_config_def_resource_resolve(def,index);
 }
 
 SJson *gfc_config_def_get_value(const char *resource, const char *name, const char *key)
@@ -85,75 +1382,280 @@ SJson *gfc_config_def_get_value(const char *resource, const char *name, const ch
     return sj_object_get_value(def,key);
 }
 
-const char *gfc_config_def_get_name_by_index(const char *resource,Uint8 index)
+const char *gfc_config_def_get_name_by_index(const char *resource,Uint32 index)
 {
-    SJson *list;
-    SJson *def;
+    ConfigDefResource *def;
     if (!config_manager.defs)
     {
         slog("config def file not loaded");
         return NULL;
     }
     if (!resource)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    def = sj_array_get_nth(list,index);
+    def = gfc_config_def_get_resource(resource);
     if (!def)return NULL;
-    return sj_object_get_value_as_string(def,"name");
+    return gfc_config_def_resource_get_string(def,index,"name");
 }
 
 
 Uint32 gfc_config_def_get_resource_count(const char *resource)
 {
-    SJson *list;
+    ConfigDefResource *def;
     if (!config_manager.defs)return 0;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return 0;
-    return sj_array_get_count(list);
+    def = gfc_config_def_get_resource(resource);
+    if (!def)return 0;
+    return def->count;
 }
 
 SJson *gfc_config_def_get_by_parameter(const char *resource,const char *parameter,const char *name)
 {
-    const char *str;
-    int i,c;
-    SJson *item,*list;
+    SJson *item;
     if (!config_manager.defs)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    c = sj_array_get_count(list);
-    for (i = 0; i < c;i++)
-    {
-        item = sj_array_get_nth(list,i);
-        if (!item)continue;
-        str = sj_object_get_value_as_string(item,parameter);
-        if (!str)continue;
-        if (strlen(str) != strlen(name))continue;
-        if (strcmp(name,str)==0)return item;
-    }
+    item = gfc_config_def_find(resource,parameter,name);
+    if (item)return item;
     slog("no resource of %s found by parameter of %s and name of %s",resource,parameter,name);
     return NULL;
 }
 
 SJson *gfc_config_def_get_by_name(const char *resource,const char *name)
 {
+    SJson *item;
+    if (!config_manager.defs)return NULL;
+    item = gfc_config_def_find(resource,"name",name);
+    if (item)return item;
+    slog("no resource of %s found by name of %s",resource,name);
+    return NULL;
+}
+
+Bool gfc_config_def_bind(SJson *def,const GFC_ConfigDefSchema *schema,void *output)
+{
+    const GFC_ConfigDefField *field;
     const char *str;
+    SJson *value;
+    Uint8 *member;
+    Uint32 i;
+    int number;
+    if ((!def)||(!schema)||(!output))return 0;
+    if (schema->defaults)memcpy(output,schema->defaults,schema->size);
+    else memset(output,0,schema->size);
+    for (i = 0; i < schema->fieldCount; i++)
+    {
+        field = &schema->fields[i];
+        value = sj_object_get_value(def,field->key);
+        if (!value)continue;//keep the default
+        member = (Uint8 *)output + field->offset;
+        switch (field->type)
+        {
+            case CDFT_Int:
+                sj_get_integer_value(value,(int *)member);
+                break;
+            case CDFT_Uint32:
+                if (sj_get_integer_value(value,&number))*(Uint32 *)member = (Uint32)number;
+                break;
+            case CDFT_Float:
+                sj_get_float_value(value,(float *)member);
+                break;
+            case CDFT_Bool:
+                sj_get_bool_value(value,(Bool *)member);
+                break;
+            case CDFT_Vector2D:
+                sj_value_as_vector2d(value,(Vector2D *)member);
+                break;
+            case CDFT_Vector3D:
+                sj_value_as_vector3d(value,(Vector3D *)member);
+                break;
+            case CDFT_Vector4D:
+                sj_value_as_vector4d(value,(Vector4D *)member);
+                break;
+            case CDFT_Color:
+                *(Color *)member = sj_value_as_color(value);
+                break;
+            case CDFT_Rect:
+                gfc_rect_from_json(value,(Rect *)member);
+                break;
+            case CDFT_Shape:
+                gfc_shape_from_json(value,(Shape *)member);
+                break;
+            case CDFT_TextLine:
+                str = sj_get_string_value(value);
+                if (str)gfc_line_cpy((char *)member,str);
+                break;
+            default:
+                slog("schema %s field %s has an unknown type",schema->name,field->key);
+                break;
+        }
+    }
+    return 1;
+}
+
+ConfigDefBinding *gfc_config_def_resource_get_binding(ConfigDefResource *resource,const GFC_ConfigDefSchema *schema)
+{
+    ConfigDefBinding *binding;
     int i,c;
-    SJson *item,*list;
+    c = gfc_list_get_count(resource->bindings);
+    for (i = 0; i < c; i++)
+    {
+        binding = gfc_list_get_nth(resource->bindings,i);
+        if ((binding)&&(binding->schema == schema))return binding;
+    }
+    if (!resource->count)return NULL;
+    binding = gfc_allocate_array(sizeof(ConfigDefBinding),1);
+    if (!binding)return NULL;
+    binding->schema = schema;
+    binding->data = gfc_allocate_array(schema->size,resource->count);
+    binding->decoded = gfc_allocate_array(sizeof(Uint8),resource->count);
+    if ((!binding->data)||(!binding->decoded))
+    {
+        gfc_config_def_binding_free(binding);
+        return NULL;
+    }
+    if (!resource->bindings)resource->bindings = gfc_list_new();
+    resource->bindings = gfc_list_append(resource->bindings,binding);
+    return binding;
+}
+
+const void *gfc_config_def_resource_get_bound(ConfigDefResource *resource,Sint32 position,const GFC_ConfigDefSchema *schema)
+{
+    ConfigDefBinding *binding;
+    Uint8 *output;
+    if ((!resource)||(!schema)||(!schema->size))return NULL;
+    if ((position < 0)||(position >= resource->count))return NULL;
+    binding = gfc_config_def_resource_get_binding(resource,schema);
+    if (!binding)return NULL;
+    output = binding->data + (schema->size * position);
+    if (!binding->decoded[position])
+    {
+        if (!gfc_config_def_bind(gfc_config_def_resource_resolve(resource,position),schema,output))return NULL;
+        binding->decoded[position] = 1;
+    }
+    return output;
+}
+
+const void *gfc_config_def_get_bound(const char *resource,const char *name,const GFC_ConfigDefSchema *schema)
+{
+    ConfigDefResource *def;
+    Sint32 position;
     if (!config_manager.defs)return NULL;
-    list = gfc_config_def_get_resource_by_name(resource);
-    if (!list)return NULL;
-    c = sj_array_get_count(list);
-    for (i = 0; i < c;i++)
+    def = gfc_config_def_get_resource(resource);
+    if (!def)return NULL;
+    position = gfc_config_def_find_position(def,"name",name);
+    if (position < 0)
     {
-        item = sj_array_get_nth(list,i);
-        if (!item)continue;
-        str = sj_object_get_value_as_string(item,"name");
-        if (!str)continue;
-        if (strlen(str) != strlen(name))continue;
-        if (strcmp(name,str)==0)return item;
+        slog("no resource of %s found by name of %s",resource,name);
+        return NULL;
+    }
+    return gfc_config_def_resource_get_bound(def,position,schema);
+}
+
+const void *gfc_config_def_get_bound_by_index(const char *resource,Uint32 index,const GFC_ConfigDefSchema *schema)
+{
+    if (!config_manager.defs)return NULL;
+    return gfc_config_def_resource_get_bound(gfc_config_def_get_resource(resource),index,schema);
+}
+
+Uint32 gfc_config_def_get_version(const char *resource)
+{
+    ConfigDefResource *def;
+    def = gfc_config_def_get_resource(resource);
+    if (!def)return 0;
+    return def->version;
+}
+
+Uint32 gfc_config_def_handle_hash(const char *name)
+{
+    Uint32 hash;
+    if (!name)return 0;//unnamed defs are only checked by place
+    hash = gfc_config_def_cache_hash(name);
+    return hash ? hash : 1;
+}
+
+GFC_ConfigDefHandle gfc_config_def_make_handle(ConfigDefResource *resource,Sint32 position)
+{
+    Uint64 nameHash;
+    if ((!resource)||(position < 0)||((Uint32)position >= resource->count))return GFC_CONFIG_DEF_INVALID_HANDLE;
+    if (!resource->id)return GFC_CONFIG_DEF_INVALID_HANDLE;
+    if (position >= GFC_CONFIG_DEF_MAX_ENTRIES)
+    {
+        slog("config def %s entry %i is past the last one a handle can refer to",resource->name,position);
+        return GFC_CONFIG_DEF_INVALID_HANDLE;
+    }
+    nameHash = gfc_config_def_handle_hash(gfc_config_def_resource_get_string(resource,position,"name"));
+    return (nameHash << GFC_CONFIG_DEF_HANDLE_NAME_SHIFT) | (resource->id << GFC_CONFIG_DEF_HANDLE_ENTRY_BITS) | (Uint32)position;
+}
+
+GFC_ConfigDefHandle gfc_config_def_get_handle(const char *resource,const char *name)
+{
+    ConfigDefResource *def;
+    Sint32 position;
+    if ((!config_manager.defs)||(!name))return GFC_CONFIG_DEF_INVALID_HANDLE;
+    def = gfc_config_def_get_resource(resource);
+    if (!def)return GFC_CONFIG_DEF_INVALID_HANDLE;
+    position = gfc_config_def_find_position(def,"name",name);
+    if (position < 0)
+    {
+        slog("no resource of %s found by name of %s",resource,name);
+        return GFC_CONFIG_DEF_INVALID_HANDLE;
+    }
+    return gfc_config_def_make_handle(def,position);
+}
+
+GFC_ConfigDefHandle gfc_config_def_get_handle_by_index(const char *resource,Uint32 index)
+{
+    if (!config_manager.defs)return GFC_CONFIG_DEF_INVALID_HANDLE;
+    if (index > 0x7FFFFFFF)return GFC_CONFIG_DEF_INVALID_HANDLE;
+    return gfc_config_def_make_handle(gfc_config_def_get_resource(resource),(Sint32)index);
+}
+
+ConfigDefResource *gfc_config_def_resolve_handle(GFC_ConfigDefHandle handle,Uint32 *position)
+{
+    ConfigDefResource *resource;
+    Uint32 id,nameHash,i;
+    id = (Uint32)handle >> GFC_CONFIG_DEF_HANDLE_ENTRY_BITS;
+    if ((!id)||(!config_manager.resourcesById))return NULL;
+    resource = gfc_list_get_nth(config_manager.resourcesById,id - 1);
+    if (!resource)return NULL;
+    nameHash = (Uint32)(handle >> GFC_CONFIG_DEF_HANDLE_NAME_SHIFT);
+    *position = (Uint32)handle & (GFC_CONFIG_DEF_MAX_ENTRIES - 1);
+    if ((*position < resource->count)&&
+        (gfc_config_def_handle_hash(gfc_config_def_resource_get_string(resource,*position,"name")) == nameHash))
+    {
+        return resource;
+    }
+    if (!nameHash)return NULL;
+    //the def moved since the handle was made, find it by name
+    for (i = 0; i < resource->count; i++)
+    {
+        if (gfc_config_def_handle_hash(gfc_config_def_resource_get_string(resource,i,"name")) != nameHash)continue;
+        *position = i;
+        return resource;
     }
-    slog("no resource of %s found by name of %s",resource,name);
     return NULL;
 }
 
+SJson *gfc_config_def_get_by_handle(GFC_ConfigDefHandle handle)
+{
+    ConfigDefResource *resource;
+    Uint32 position;
+    resource = gfc_config_def_resolve_handle(handle,&position);
+    if (!resource)return NULL;
+    return gfc_config_def_resource_resolve(resource,position);
+}
+
+const char *gfc_config_def_get_name_by_handle(GFC_ConfigDefHandle handle)
+{
+    ConfigDefResource *resource;
+    Uint32 position;
+    resource = gfc_config_def_resolve_handle(handle,&position);
+    if (!resource)return NULL;
+    return gfc_config_def_resource_get_string(resource,position,"name");
+}
+
+const void *gfc_config_def_get_bound_by_handle(GFC_ConfigDefHandle handle,const GFC_ConfigDefSchema *schema)
+{
+    ConfigDefResource *resource;
+    Uint32 position;
+    resource = gfc_config_def_resolve_handle(handle,&position);
+    if (!resource)return NULL;
+    return gfc_config_def_resource_get_bound(resource,position,schema);
+}
+
 /*eol@eof*/
@@ -0,0 +1,541 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "simple_logger.h"
+
+#include "gfc_text.h"
+#include "gfc_config_def_cache.h"
+
+typedef struct
+{
+    GFC_ConfigDefCache *cache;
+    Uint32 valueUsed;       /**<how many values have been handed out while compiling*/
+    Uint32 stringUsed;      /**<how much of the string pool has been used while compiling*/
+}GFC_ConfigDefCacheBuilder;
+
+Uint32 gfc_config_def_cache_hash(const char *name)
+{
+    Uint32 hash = 2166136261u;
+    //fnv-1a
+    for (; *name != 0; name++)
+    {
+        hash ^= (Uint8)*name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+size_t gfc_config_def_cache_get_data_size(GFC_ConfigDefCacheHeader *header)
+{
+    return sizeof(GFC_ConfigDefCacheHeader) +
+        (sizeof(GFC_ConfigDefCacheValue) * (size_t)header->valueCount) +
+        (sizeof(GFC_ConfigDefCacheResource) * (size_t)header->resourceCount) +
+        (sizeof(GFC_ConfigDefCacheSlot) * (size_t)header->slotCount) +
+        header->stringPoolSize;
+}
+
+void gfc_config_def_cache_setup_pointers(GFC_ConfigDefCache *cache)
+{
+    cache->header = (GFC_ConfigDefCacheHeader *)cache->data;
+    cache->values = (GFC_ConfigDefCacheValue *)&cache->header[1];
+    cache->resources = (GFC_ConfigDefCacheResource *)&cache->values[cache->header->valueCount];
+    cache->slots = (GFC_ConfigDefCacheSlot *)&cache->resources[cache->header->resourceCount];
+    cache->strings = (char *)&cache->slots[cache->header->slotCount];
+}
+
+void gfc_config_def_cache_count(GFC_JsonValue *json,Uint32 *valueCount,Uint32 *stringPoolSize)
+{
+    Uint32 i;
+    (*valueCount)++;
+    if (json->key)*stringPoolSize += strlen(json->key) + 1;
+    switch (json->type)
+    {
+        case GJT_Array:
+        case GJT_Object:
+            for (i = 0; i < json->count; i++)
+            {
+                gfc_config_def_cache_count(&json->v.children[i],valueCount,stringPoolSize);
+            }
+            break;
+        case GJT_String:
+        case GJT_Number:
+            *stringPoolSize += json->count + 1;
+            break;
+    }
+}
+
+Uint32 gfc_config_def_cache_table_size(Uint32 named)
+{
+    Uint32 size = 1;
+    if (!named)return 0;
+    //at most half full, so probes stay short
+    while (size < named * 2)size <<= 1;
+    return size;
+}
+
+void gfc_config_def_cache_count_tables(GFC_JsonValue *root,Uint32 *resourceCount,Uint32 *slotCount)
+{
+    GFC_JsonValue *list;
+    Uint32 i,j,named;
+    if (root->type != GJT_Object)return;
+    for (i = 0; i < root->count; i++)
+    {
+        list = &root->v.children[i];
+        if (list->type != GJT_Array)continue;
+        named = 0;
+        for (j = 0; j < list->count; j++)
+        {
+            if (gfc_json_get_string(gfc_json_object_get(&list->v.children[j],"name")))named++;
+        }
+        (*resourceCount)++;
+        *slotCount += gfc_config_def_cache_table_size(named);
+    }
+}
+
+Uint32 gfc_config_def_cache_add_string(GFC_ConfigDefCacheBuilder *builder,const char *str,size_t length)
+{
+    Uint32 offset;
+    offset = builder->stringUsed;
+    memcpy(&builder->cache->strings[offset],str,length + 1);
+    builder->stringUsed += length + 1;
+    return offset;
+}
+
+void gfc_config_def_cache_fill(GFC_ConfigDefCacheBuilder *builder,GFC_JsonValue *json,Uint32 slot)
+{
+    GFC_ConfigDefCacheValue *value;
+    Uint32 i;
+    value = &builder->cache->values[slot];
+    if (json->key)value->key = gfc_config_def_cache_add_string(builder,json->key,strlen(json->key));
+    else value->key = GFC_CONFIG_DEF_CACHE_NO_KEY;
+    switch (json->type)
+    {
+        case GJT_Array:
+        case GJT_Object:
+            value->type = (json->type == GJT_Array) ? CDCV_Array : CDCV_Object;
+            value->start = builder->valueUsed;
+            value->count = json->count;
+            //reserve the children first so they sit next to each other
+            builder->valueUsed += json->count;
+            for (i = 0; i < json->count; i++)
+            {
+                gfc_config_def_cache_fill(builder,&json->v.children[i],value->start + i);
+            }
+            break;
+        case GJT_String:
+        case GJT_Number:
+            value->type = (json->type == GJT_Number) ? CDCV_Number : CDCV_String;
+            value->count = json->count;
+            value->start = gfc_config_def_cache_add_string(builder,json->v.text,json->count);
+            break;
+        case GJT_Bool:
+            value->type = CDCV_Bool;
+            value->count = json->boolean;
+            break;
+        default:
+            value->type = CDCV_Null;
+    }
+}
+
+void gfc_config_def_cache_table_insert(GFC_ConfigDefCache *cache,GFC_ConfigDefCacheResource *resource,Uint32 name,Uint32 position)
+{
+    GFC_ConfigDefCacheSlot *slot;
+    Uint32 hash,mask,i;
+    hash = gfc_config_def_cache_hash(&cache->strings[name]);
+    mask = resource->slotCount - 1;
+    for (i = hash & mask;; i = (i + 1) & mask)
+    {
+        slot = &cache->slots[resource->slotStart + i];
+        if (!slot->position)break;
+        //the first def with a name wins, like a scan of the list would
+        if ((slot->hash == hash)&&(strcmp(&cache->strings[slot->name],&cache->strings[name])==0))return;
+    }
+    slot->hash = hash;
+    slot->name = name;
+    slot->position = position + 1;
+}
+
+void gfc_config_def_cache_fill_tables(GFC_ConfigDefCache *cache)
+{
+    GFC_ConfigDefCacheValue *root,*list;
+    GFC_ConfigDefCacheResource *resource;
+    Uint32 i,j,name,named,slot = 0,count = 0;
+    root = &cache->values[0];
+    if (root->type != CDCV_Object)return;
+    for (i = 0; i < root->count; i++)
+    {
+        list = &cache->values[root->start + i];
+        if (list->type != CDCV_Array)continue;
+        resource = &cache->resources[count++];
+        resource->list = root->start + i;
+        resource->slotStart = slot;
+        named = 0;
+        for (j = 0; j < list->count; j++)
+        {
+            if (gfc_config_def_cache_get_string(cache,gfc_config_def_cache_object_get(cache,list->start + j,"name")))named++;
+        }
+        resource->slotCount = gfc_config_def_cache_table_size(named);
+        slot += resource->slotCount;
+        for (j = 0; (resource->slotCount)&&(j < list->count); j++)
+        {
+            name = gfc_config_def_cache_object_get(cache,list->start + j,"name");
+            if (!gfc_config_def_cache_get_string(cache,name))continue;
+            gfc_config_def_cache_table_insert(cache,resource,cache->values[name].start,j);
+        }
+    }
+}
+
+GFC_ConfigDefCache *gfc_config_def_cache_compile(GFC_JsonValue *json,Uint32 sourceCrc,Uint64 sourceSize,Uint64 sourceTime)
+{
+    GFC_ConfigDefCacheBuilder builder = {0};
+    GFC_ConfigDefCacheHeader header = {0};
+    GFC_ConfigDefCache *cache;
+    if (!json)return NULL;
+    gfc_config_def_cache_count(json,&header.valueCount,&header.stringPoolSize);
+    gfc_config_def_cache_count_tables(json,&header.resourceCount,&header.slotCount);
+    cache = gfc_allocate_array(sizeof(GFC_ConfigDefCache),1);
+    if (!cache)return NULL;
+    cache->size = gfc_config_def_cache_get_data_size(&header);
+    cache->data = gfc_allocate_array(cache->size,1);
+    if (!cache->data)
+    {
+        free(cache);
+        return NULL;
+    }
+    header.magic = GFC_CONFIG_DEF_CACHE_MAGIC;
+    header.version = GFC_CONFIG_DEF_CACHE_VERSION;
+    header.sourceCrc = sourceCrc;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    memcpy(cache->data,&header,sizeof(GFC_ConfigDefCacheHeader));
+    gfc_config_def_cache_setup_pointers(cache);
+    builder.cache = cache;
+    builder.valueUsed = 1;//the root
+    gfc_config_def_cache_fill(&builder,json,0);
+    gfc_config_def_cache_fill_tables(cache);
+    return cache;
+}
+
+Bool gfc_config_def_cache_validate(GFC_ConfigDefCache *cache)
+{
+    GFC_ConfigDefCacheValue *value;
+    GFC_ConfigDefCacheResource *resource;
+    GFC_ConfigDefCacheSlot *slot;
+    Uint32 i,j,valueCount,stringPoolSize;
+    valueCount = cache->header->valueCount;
+    stringPoolSize = cache->header->stringPoolSize;
+    if ((stringPoolSize)&&(cache->strings[stringPoolSize - 1] != 0))return 0;
+    for (i = 0; i < valueCount; i++)
+    {
+        value = &cache->values[i];
+        if ((value->key != GFC_CONFIG_DEF_CACHE_NO_KEY)&&(value->key >= stringPoolSize))return 0;
+        switch (value->type)
+        {
+            case CDCV_Null:
+            case CDCV_Bool:
+                break;
+            case CDCV_String:
+            case CDCV_Number:
+                if (((Uint64)value->start + value->count) >= stringPoolSize)return 0;
+                if (cache->strings[value->start + value->count] != 0)return 0;
+                break;
+            case CDCV_Array:
+            case CDCV_Object:
+                //children always come after their parent, which also rules out loops
+                if ((value->count)&&((value->start <= i)||(((Uint64)value->start + value->count) > valueCount)))return 0;
+                break;
+            default:
+                return 0;
+        }
+    }
+    for (i = 0; i < cache->header->resourceCount; i++)
+    {
+        resource = &cache->resources[i];
+        if ((!resource->list)||(resource->list >= valueCount))return 0;
+        value = &cache->values[resource->list];
+        if ((value->type != CDCV_Array)||(value->key == GFC_CONFIG_DEF_CACHE_NO_KEY))return 0;
+        if (resource->slotCount & (resource->slotCount - 1))return 0;
+        if (((Uint64)resource->slotStart + resource->slotCount) > cache->header->slotCount)return 0;
+        for (j = 0; j < resource->slotCount; j++)
+        {
+            slot = &cache->slots[resource->slotStart + j];
+            if (!slot->position)continue;
+            if ((slot->position > value->count)||(slot->name >= stringPoolSize))return 0;
+        }
+    }
+    return 1;
+}
+
+GFC_ConfigDefCache *gfc_config_def_cache_wrap(void *data,size_t size,Uint8 mapped)
+{
+    GFC_ConfigDefCache *cache;
+    GFC_ConfigDefCacheHeader *header;
+    if (!data)return NULL;
+    if (size < sizeof(GFC_ConfigDefCacheHeader))return NULL;
+    header = (GFC_ConfigDefCacheHeader *)data;
+    if (header->magic == GFC_CONFIG_DEF_CACHE_MAGIC_SWAPPED)
+    {
+        slog("config def cache was compiled on a machine of the other byte order");
+        return NULL;
+    }
+    if ((header->magic != GFC_CONFIG_DEF_CACHE_MAGIC)||(header->version != GFC_CONFIG_DEF_CACHE_VERSION))
+    {
+        return NULL;
+    }
+    if ((!header->valueCount)||(size != gfc_config_def_cache_get_data_size(header)))
+    {
+        slog("config def cache data is the wrong size");
+        return NULL;
+    }
+    cache = gfc_allocate_array(sizeof(GFC_ConfigDefCache),1);
+    if (!cache)return NULL;
+    cache->data = data;
+    cache->size = size;
+    cache->mapped = mapped;
+    gfc_config_def_cache_setup_pointers(cache);
+    if (!gfc_config_def_cache_validate(cache))
+    {
+        slog("config def cache data is corrupt");
+        free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+GFC_ConfigDefCache *gfc_config_def_cache_from_data(void *data,size_t size)
+{
+    return gfc_config_def_cache_wrap(data,size,0);
+}
+
+GFC_ConfigDefCache *gfc_config_def_cache_load(const char *filename)
+{
+    GFC_ConfigDefCache *cache;
+    struct stat fileStat;
+    void *data;
+    int fd;
+    if (!filename)return NULL;
+    fd = open(filename,O_RDONLY);
+    if (fd < 0)return NULL;
+    if ((fstat(fd,&fileStat) != 0)||(fileStat.st_size <= 0))
+    {
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL,fileStat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        slog("failed to map config def cache %s",filename);
+        return NULL;
+    }
+    cache = gfc_config_def_cache_wrap(data,fileStat.st_size,1);
+    if (!cache)munmap(data,fileStat.st_size);
+    return cache;
+}
+
+/**
+ * @brief write cache data beside a cache file and rename it over the file
+ */
+Bool gfc_config_def_cache_write_file(const char *filename,const void *data,size_t size)
+{
+    TextBlock temp;
+    FILE *file;
+    gfc_block_sprintf(temp,"%s.tmp",filename);
+    file = fopen(temp,"wb");
+    if (!file)
+    {
+        slog("failed to write config def cache %s",filename);
+        return 0;
+    }
+    if ((fwrite(data,size,1,file) != 1)||(fclose(file) != 0))
+    {
+        slog("failed to write config def cache %s",filename);
+        remove(temp);
+        return 0;
+    }
+    //replace the file rather than writing into it, an older cache may still be mapped from it
+    if (rename(temp,filename) != 0)
+    {
+        slog("failed to replace config def cache %s",filename);
+        remove(temp);
+        return 0;
+    }
+    return 1;
+}
+
+Bool gfc_config_def_cache_save(GFC_ConfigDefCache *cache,const char *filename)
+{
+    if ((!cache)||(!filename))return 0;
+    return gfc_config_def_cache_write_file(filename,cache->data,cache->size);
+}
+
+Bool gfc_config_def_cache_set_source_time(const char *filename,Uint64 sourceTime)
+{
+    GFC_ConfigDefCache *cache;
+    GFC_ConfigDefCacheHeader *header;
+    Uint8 *data;
+    Bool written;
+    if (!filename)return 0;
+    cache = gfc_config_def_cache_load(filename);
+    if (!cache)return 0;
+    //the file may be mapped by a loaded cache, so it is rewritten whole rather than patched in place
+    data = gfc_allocate_array(cache->size,1);
+    if (!data)
+    {
+        gfc_config_def_cache_free(cache);
+        return 0;
+    }
+    memcpy(data,cache->data,cache->size);
+    header = (GFC_ConfigDefCacheHeader *)data;
+    header->sourceTime = sourceTime;
+    written = gfc_config_def_cache_write_file(filename,data,cache->size);
+    free(data);
+    gfc_config_def_cache_free(cache);
+    return written;
+}
+
+Uint32 gfc_config_def_cache_object_get(GFC_ConfigDefCache *cache,Uint32 object,const char *key)
+{
+    GFC_ConfigDefCacheValue *value,*child;
+    Uint32 i;
+    if ((!cache)||(!key)||(object >= cache->header->valueCount))return 0;
+    value = &cache->values[object];
+    if (value->type != CDCV_Object)return 0;
+    for (i = 0; i < value->count; i++)
+    {
+        child = &cache->values[value->start + i];
+        if (child->key == GFC_CONFIG_DEF_CACHE_NO_KEY)continue;
+        if (strcmp(&cache->strings[child->key],key)==0)return value->start + i;
+    }
+    return 0;
+}
+
+const char *gfc_config_def_cache_get_string(GFC_ConfigDefCache *cache,Uint32 value)
+{
+    GFC_ConfigDefCacheValue *v;
+    if ((!cache)||(!value)||(value >= cache->header->valueCount))return NULL;
+    v = &cache->values[value];
+    if ((v->type != CDCV_String)&&(v->type != CDCV_Number))return NULL;
+    return &cache->strings[v->start];
+}
+
+Sint32 gfc_config_def_cache_get_resource(GFC_ConfigDefCache *cache,const char *name)
+{
+    Uint32 i;
+    if ((!cache)||(!name))return -1;
+    for (i = 0; i < cache->header->resourceCount; i++)
+    {
+        if (strcmp(&cache->strings[cache->values[cache->resources[i].list].key],name)==0)return i;
+    }
+    return -1;
+}
+
+Sint32 gfc_config_def_cache_find(GFC_ConfigDefCache *cache,Uint32 resource,const char *name)
+{
+    GFC_ConfigDefCacheResource *res;
+    GFC_ConfigDefCacheSlot *slot;
+    Uint32 hash,mask,i,probes;
+    if ((!cache)||(!name)||(resource >= cache->header->resourceCount))return -1;
+    res = &cache->resources[resource];
+    if (!res->slotCount)return -1;
+    hash = gfc_config_def_cache_hash(name);
+    mask = res->slotCount - 1;
+    for (i = hash & mask,probes = 0; probes < res->slotCount; i = (i + 1) & mask,probes++)
+    {
+        slot = &cache->slots[res->slotStart + i];
+        if (!slot->position)return -1;
+        if ((slot->hash == hash)&&(strcmp(&cache->strings[slot->name],name)==0))return slot->position - 1;
+    }
+    return -1;
+}
+
+Bool gfc_config_def_cache_equal(GFC_ConfigDefCache *a,Uint32 valueA,GFC_ConfigDefCache *b,Uint32 valueB)
+{
+    GFC_ConfigDefCacheValue *va,*vb,*child;
+    Uint32 i,match;
+    if ((!a)||(!b))return a == b;
+    va = &a->values[valueA];
+    vb = &b->values[valueB];
+    if ((va->type != vb->type)||(va->count != vb->count))return 0;
+    switch (va->type)
+    {
+        case CDCV_Bool:
+            return va->count == vb->count;
+        case CDCV_String:
+        case CDCV_Number:
+            return memcmp(&a->strings[va->start],&b->strings[vb->start],va->count) == 0;
+        case CDCV_Array:
+            for (i = 0; i < va->count; i++)
+            {
+                if (!gfc_config_def_cache_equal(a,va->start + i,b,vb->start + i))return 0;
+            }
+            return 1;
+        case CDCV_Object:
+            for (i = 0; i < va->count; i++)
+            {
+                child = &a->values[va->start + i];
+                if (child->key == GFC_CONFIG_DEF_CACHE_NO_KEY)continue;
+                match = gfc_config_def_cache_object_get(b,valueB,&a->strings[child->key]);
+                if (!match)return 0;
+                if (!gfc_config_def_cache_equal(a,va->start + i,b,match))return 0;
+            }
+            return 1;
+        default:
+            return 1;
+    }
+}
+
+SJson *gfc_config_def_cache_get_json(GFC_ConfigDefCache *cache,Uint32 index)
+{
+    GFC_ConfigDefCacheValue *value,*child;
+    SJson *json;
+    Uint32 i;
+    if ((!cache)||(index >= cache->header->valueCount))return NULL;
+    value = &cache->values[index];
+    switch (value->type)
+    {
+        case CDCV_Bool:
+            return sj_new_bool(value->count);
+        case CDCV_String:
+        case CDCV_Number:
+            return sj_new_str(&cache->strings[value->start]);
+        case CDCV_Array:
+            json = sj_array_new();
+            for (i = 0; i < value->count; i++)
+            {
+                sj_array_append(json,gfc_config_def_cache_get_json(cache,value->start + i));
+            }
+            return json;
+        case CDCV_Object:
+            json = sj_object_new();
+            for (i = 0; i < value->count; i++)
+            {
+                child = &cache->values[value->start + i];
+                if (child->key == GFC_CONFIG_DEF_CACHE_NO_KEY)continue;
+                sj_object_insert(json,&cache->strings[child->key],gfc_config_def_cache_get_json(cache,value->start + i));
+            }
+            return json;
+        default:
+            return sj_null_new();
+    }
+}
+
+SJson *gfc_config_def_cache_to_json(GFC_ConfigDefCache *cache)
+{
+    if ((!cache)||(!cache->header))return NULL;
+    return gfc_config_def_cache_get_json(cache,0);
+}
+
+void gfc_config_def_cache_free(GFC_ConfigDefCache *cache)
+{
+    if (!cache)return;
+    if (cache->mapped)munmap(cache->data,cache->size);
+    else if (cache->data)free(cache->data);
+    free(cache);
+}
+
+/*eol@eof*/
@@ -1,22 +1,34 @@
-#include <simple_json.h>
 #include "simple_logger.h"
 #include "gfc_list.h"
-#include "gfc_pak.h"
+#include "gfc_hashmap.h"
+#include "gfc_json_doc.h"
 #include "gfc_input.h"
 
 typedef struct
 {
     List *input_list;
+    HashMap *input_index;           /**<position + 1 in input_list by command name*/
+    Uint16 generation;              /**<goes up each purge, so old handles stop resolving*/
     const Uint8 * input_keys;
-    Uint8 * input_old_keys;
     int input_key_count;
+    Uint64 key_bits[GFC_INPUT_KEY_WORDS];       /**<input_keys packed a bit per key, plus the mod keys*/
+    Uint64 old_key_bits[GFC_INPUT_KEY_WORDS];   /**<key_bits from the last update*/
+    List *key_commands[GFC_INPUT_KEY_BITS];     /**<positions in input_list of the commands bound to each key*/
+    List *button_commands[GFC_INPUT_MAX_BUTTONS];/**<positions in input_list of the commands bound to each controller button*/
+    List *active_commands;                      /**<positions of the commands that were not idle after the last update*/
+    Uint32 *update_commands;                    /**<positions of the commands to update this frame, sized like command_marks*/
+    Uint32 update_count;                        /**<how many commands are queued this frame*/
+    Uint32 *command_marks;                      /**<the frame each command was last queued, by position*/
+    Uint32 command_marks_size;
+    Uint32 frame;
     int mouse_wheel_x;
     int mouse_wheel_y;
     int mouse_wheel_x_old;
     int mouse_wheel_y_old;
     List *controllers;
-    SJson *controller_button_map;
-    SJson *controller_axis_map;
+    GFC_JsonDoc *controller_doc;                /**<the config file the controller maps are read from*/
+    GFC_JsonValue *controller_button_map;       /**<points into controller_doc*/
+    GFC_JsonValue *controller_axis_map;         /**<points into controller_doc*/
 }GFC_InputData;
 
 static GFC_InputData gfc_input_data = {0};
@@ -25,6 +37,42 @@ static GFC_InputData gfc_input_data = {0};
 void gfc_input_close();
 Input *gfc_input_get_by_name(const char *name);
 
+#define gfc_input_bit_set(bits,n)  (bits[(n) >> 6] |= ((Uint64)1 << ((n) & 63)))
+#define gfc_input_bit_test(bits,n) ((bits[(n) >> 6] >> ((n) & 63)) & 1)
+
+/**
+ * @brief the bit used for a mod key, past the end of the scancodes
+ */
+#define gfc_input_mod_bit(mod)     (SDL_NUM_SCANCODES + (mod) - EMK_Shift)
+
+int gfc_input_bits_count(Uint64 bits)
+{
+    int count = 0;
+    for (;bits;count++)
+    {
+        bits &= bits - 1;
+    }
+    return count;
+}
+
+void gfc_input_keys_pack()
+{
+    const Uint8 *keys = gfc_input_data.input_keys;
+    Uint64 *bits = gfc_input_data.key_bits;
+    int i,c;
+    memset(bits,0,sizeof(Uint64)*GFC_INPUT_KEY_WORDS);
+    if (!keys)return;
+    c = MIN(gfc_input_data.input_key_count,SDL_NUM_SCANCODES);
+    for (i = 0; i < c; i++)
+    {
+        if (keys[i])gfc_input_bit_set(bits,i);
+    }
+    if (keys[SDL_SCANCODE_LSHIFT]||keys[SDL_SCANCODE_RSHIFT])gfc_input_bit_set(bits,gfc_input_mod_bit(EMK_Shift));
+    if (keys[SDL_SCANCODE_LALT]||keys[SDL_SCANCODE_RALT])gfc_input_bit_set(bits,gfc_input_mod_bit(EMK_Alt));
+    if (keys[SDL_SCANCODE_LCTRL]||keys[SDL_SCANCODE_RCTRL])gfc_input_bit_set(bits,gfc_input_mod_bit(EMK_Ctrl));
+    if (keys[SDL_SCANCODE_LGUI]||keys[SDL_SCANCODE_RGUI])gfc_input_bit_set(bits,gfc_input_mod_bit(EMK_Super));
+}
+
 void gfc_controller_update(GFC_InputController *controller)
 {
     int i;
@@ -32,11 +80,14 @@ void gfc_controller_update(GFC_InputController *controller)
     if (!controller)return;
     if (!controller->controller)return;//nothing to do
     memcpy(controller->old_buttons,controller->buttons,sizeof(Uint8)*controller->num_buttons);// backup the old
+    controller->old_button_bits = controller->button_bits;
+    controller->button_bits = 0;
     memcpy(controller->old_axis,controller->axis,sizeof(Sint16)*controller->num_axis);// backup the old
     for (i = 0; i < controller->num_buttons;i++)
     {
         button = SDL_JoystickGetButton(controller->controller,i);
         controller->buttons[i] = button;
+        if ((button)&&(i < GFC_INPUT_MAX_BUTTONS))controller->button_bits |= (Uint64)1 << i;
 //        if (controller->buttons[i])slog("controller button %i is %i",i,controller->buttons[i]);
     }
     for (i = 0; i < controller->num_axis;i++)
@@ -71,22 +122,25 @@ GFC_InputController *gfc_controller_new()
 
 void gfc_input_controller_load_mappings(const char *config)
 {
-    SJson *file,*mappings;
-    file = gfc_pak_load_json(config);
-    if (!file)
+    GFC_JsonDoc *doc;
+    GFC_JsonValue *mappings;
+    doc = gfc_json_doc_load(config);
+    if (!doc)
     {
         slog("failed to load input config");
         return;
     }
-    mappings = sj_object_get_value(file,"controller_map");
+    mappings = gfc_json_object_get(doc->root,"controller_map");
     if (!mappings)
     {
-        sj_free(file);
+        gfc_json_doc_free(doc);
         return;
     }
-    gfc_input_data.controller_button_map = sj_copy(sj_object_get_value(mappings,"buttons"));
-    gfc_input_data.controller_axis_map = sj_copy(sj_object_get_value(mappings,"axes"));
-    sj_free(file);
+    //the maps are read in place, so the document is kept until close
+    gfc_json_doc_free(gfc_input_data.controller_doc);
+    gfc_input_data.controller_doc = doc;
+    gfc_input_data.controller_button_map = gfc_json_object_get(mappings,"buttons");
+    gfc_input_data.controller_axis_map = gfc_json_object_get(mappings,"axes");
 }
 
 void gfc_input_init(char *configFile)
@@ -107,11 +161,8 @@ void gfc_input_init(char *configFile)
     {
         slog("failed to get keyboard count!");
     }
-    else
-    {
-        gfc_input_data.input_old_keys = (Uint8*)malloc(sizeof(Uint8)*gfc_input_data.input_key_count);
-        memcpy(gfc_input_data.input_old_keys,gfc_input_data.input_keys,sizeof(Uint8)*gfc_input_data.input_key_count);
-    }
+    gfc_input_keys_pack();
+    memcpy(gfc_input_data.old_key_bits,gfc_input_data.key_bits,sizeof(gfc_input_data.key_bits));
     //controller support
     gfc_input_controller_load_mappings(configFile);
     for (i = 0; i < SDL_NumJoysticks(); ++i)
@@ -148,23 +199,20 @@ void gfc_input_init(char *configFile)
 
 int gfc_input_controller_get_axis_index(const char *axis)
 {
-    int i,c;
-    int index;
+    Uint32 i,c;
     const char *name;
-    SJson *item;
+    GFC_JsonValue *item;
     if (!axis)return -1;
-    c = sj_array_get_count(gfc_input_data.controller_axis_map);
+    c = gfc_json_get_count(gfc_input_data.controller_axis_map);
     for (i = 0; i < c; i++)
     {
-        item = sj_array_get_nth(gfc_input_data.controller_axis_map,i);
+        item = gfc_json_array_get_nth(gfc_input_data.controller_axis_map,i);
         if (!item)continue;
-        name = sj_get_string_value(sj_object_get_value(item,"axis"));
+        name = gfc_json_get_string(gfc_json_object_get(item,"axis"));
         if (!name)continue;
         if (gfc_strlcmp(name,axis)==0)
         {
-            index = -1;
-            sj_object_get_value_as_int(item,"index",&index);
-            return index;
+            return gfc_json_get_int(gfc_json_object_get(item,"index"),-1);
         }
     }
     return -1;
@@ -172,23 +220,20 @@ int gfc_input_controller_get_axis_index(const char *axis)
 
 int gfc_input_controller_get_axis_max(const char *axis)
 {
-    int i,c;
-    int max;
+    Uint32 i,c;
     const char *name;
-    SJson *item;
+    GFC_JsonValue *item;
     if (!axis)return -1;
-    c = sj_array_get_count(gfc_input_data.controller_axis_map);
+    c = gfc_json_get_count(gfc_input_data.controller_axis_map);
     for (i = 0; i < c; i++)
     {
-        item = sj_array_get_nth(gfc_input_data.controller_axis_map,i);
+        item = gfc_json_array_get_nth(gfc_input_data.controller_axis_map,i);
         if (!item)continue;
-        name = sj_get_string_value(sj_object_get_value(item,"axis"));
+        name = gfc_json_get_string(gfc_json_object_get(item,"axis"));
         if (!name)continue;
         if (gfc_strlcmp(name,axis)==0)
         {
-            max = 0;
-            sj_object_get_value_as_int(item,"max",&max);
-            return max;
+            return gfc_json_get_int(gfc_json_object_get(item,"max"),0);
         }
     }
     return 0;
@@ -197,23 +242,23 @@ int gfc_input_controller_get_axis_max(const char *axis)
 
 int gfc_input_controller_get_button_index(const char *button)
 {
-    int i,c;
-    int index;
+    Uint32 i,c;
     const char *name;
-    SJson *item;
+    GFC_JsonValue *item,*index;
     if (!button)return -1;
-    c = sj_array_get_count(gfc_input_data.controller_button_map);
+    c = gfc_json_get_count(gfc_input_data.controller_button_map);
     for (i = 0; i < c; i++)
     {
-        item = sj_array_get_nth(gfc_input_data.controller_button_map,i);
+        item = gfc_json_array_get_nth(gfc_input_data.controller_button_map,i);
         if (!item)continue;
-        name = sj_get_string_value(sj_object_get_value(item,"button"));
+        name = gfc_json_get_string(gfc_json_object_get(item,"button"));
         if (!name)continue;
         if (strcmp(name,button)==0)
         {
-            if (sj_get_integer_value(sj_object_get_value(item,"index"),&index))
+            index = gfc_json_object_get(item,"index");
+            if ((index)&&(index->type == GJT_Number))
             {
-                return index;
+                return gfc_json_get_int(index,-1);
             }
         }
     }
@@ -409,12 +454,10 @@ void gfc_input_close()
     int i,c;
     gfc_input_commands_purge();
     gfc_input_data.input_list = NULL;
-    if (gfc_input_data.input_old_keys)
-    {
-        free(gfc_input_data.input_old_keys);
-    }
-    if (gfc_input_data.controller_button_map)sj_free(gfc_input_data.controller_button_map);
-    if (gfc_input_data.controller_axis_map)sj_free(gfc_input_data.controller_axis_map);
+    gfc_json_doc_free(gfc_input_data.controller_doc);
+    gfc_input_data.controller_doc = NULL;
+    gfc_input_data.controller_button_map = NULL;
+    gfc_input_data.controller_axis_map = NULL;
     c = gfc_list_get_count(gfc_input_data.controllers);
     for (i = 0; i < c; i++)
     {
@@ -423,6 +466,8 @@ void gfc_input_close()
         gfc_controller_free(controller);
     }
     gfc_list_delete(gfc_input_data.controllers);
+    if (gfc_input_data.update_commands)free(gfc_input_data.update_commands);
+    if (gfc_input_data.command_marks)free(gfc_input_data.command_marks);
     memset(&gfc_input_data,0,sizeof(GFC_InputData));
 }
 
@@ -439,35 +484,30 @@ void gfc_input_commands_purge()
         gfc_input_delete((Input*)data);
     }
     gfc_list_delete(gfc_input_data.input_list);
-}
-
-void gfc_input_update_controller(Input *command)
-{
-    GFC_InputController *controller;
-    Uint32 index,controllerId;
-    int c,i;
-    int old = 0, new = 0;
-    if (!command)return;
-    if (!command->controller)return;
-    if (!gfc_input_data.controllers)return;
-    controllerId = command->controller - 1;
-    controller = gfc_list_get_nth(gfc_input_data.controllers,controllerId);
-    if (!controller)return;
-    
-    c = gfc_list_get_count(command->buttons);
-    if (!c)
+    gfc_input_data.input_list = NULL;
+    gfc_hashmap_free(gfc_input_data.input_index);
+    gfc_input_data.input_index = NULL;
+    for (i = 0; i < GFC_INPUT_KEY_BITS; i++)
     {
-        return;// no buttons configured
+        gfc_list_delete(gfc_input_data.key_commands[i]);
+        gfc_input_data.key_commands[i] = NULL;
     }
-    for (i = 0; i < c; i++)
+    for (i = 0; i < GFC_INPUT_MAX_BUTTONS; i++)
     {
-#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
-        index = (Uint32)gfc_list_get_nth(command->buttons,i);
-        if (index >= controller->num_buttons)continue; // bad index
-        if (gfc_input_controller_button_state_by_index(controllerId, index))new++;
-        if (gfc_input_controller_old_button_state_by_index(controllerId, index))old++;
+        gfc_list_delete(gfc_input_data.button_commands[i]);
+        gfc_input_data.button_commands[i] = NULL;
     }
-    if ((old == c)&&(new == c))
+    gfc_list_delete(gfc_input_data.active_commands);
+    gfc_input_data.active_commands = NULL;
+    gfc_input_data.generation++;
+}
+
+/**
+ * @brief set a command's state and fire its callbacks from whether all of its inputs were down last update and are down now
+ */
+void gfc_input_command_set_state(Input *command,Bool oldAll,Bool newAll)
+{
+    if ((oldAll)&&(newAll))
     {
         command->state = IET_Hold;
         if (command->onHold)
@@ -475,7 +515,7 @@ void gfc_input_update_controller(Input *command)
             command->onHold(command->data);
         }
     }
-    else if ((old == c)&&(new != c))
+    else if ((oldAll)&&(!newAll))
     {
         command->state = IET_Release;
         if (command->onRelease)
@@ -483,7 +523,7 @@ void gfc_input_update_controller(Input *command)
             command->onRelease(command->data);
         }
     }
-    else if ((old != c)&&(new == c))
+    else if ((!oldAll)&&(newAll))
     {
         command->state = IET_Press;
         command->pressTime = SDL_GetTicks();
@@ -498,118 +538,276 @@ void gfc_input_update_controller(Input *command)
     }
 }
 
+void gfc_input_update_controller(Input *command)
+{
+    GFC_InputController *controller;
+    Uint64 mask;
+    if (!command)return;
+    if (!command->controller)return;
+    if (!gfc_input_data.controllers)return;
+    controller = gfc_list_get_nth(gfc_input_data.controllers,command->controller - 1);
+    if (!controller)return;
+    mask = command->buttonMask;
+    if (!mask)
+    {
+        return;// no buttons configured
+    }
+    gfc_input_command_set_state(
+        command,
+        (controller->old_button_bits & mask) == mask,
+        (controller->button_bits & mask) == mask);
+}
+
 void gfc_input_update_command(Input *command)
 {
-    Uint32 c,i;
-    Uint32 kc;
-    int old = 0, new = 0;
+    Uint64 mask,old = 0,new = 0;
+    int i;
     if (!command)return;
-    c = gfc_list_get_count(command->keyCodes);
-    if (!c)return;// no commands to update this with, do nothing
+    if (!gfc_list_get_count(command->keyCodes))return;// no commands to update this with, do nothing
     command->downCount = 0;
+    for (i = 0; i < GFC_INPUT_KEY_WORDS; i++)
+    {
+        mask = command->keyMask[i];
+        if (!mask)continue;
+        //collect any bit of the mask that is not down
+        old |= (gfc_input_data.old_key_bits[i] & mask) ^ mask;
+        new |= (gfc_input_data.key_bits[i] & mask) ^ mask;
+        command->downCount += gfc_input_bits_count(gfc_input_data.key_bits[i] & mask);
+    }
+    gfc_input_command_set_state(command,!old,!new);
+    if (command->state == IET_Idle)
+    {
+        gfc_input_update_controller(command);
+    }
+}
+
+/**
+ * @brief build the bitsets of a command's keys and buttons from its lists
+ */
+void gfc_input_command_compile(Input *command)
+{
+    Uint32 i,c,kc;
+    if (!command)return;
+    memset(command->keyMask,0,sizeof(command->keyMask));
+    command->buttonMask = 0;
+    c = gfc_list_get_count(command->keyCodes);
     for (i = 0; i < c; i++)
     {
-#pragma GCC diagnostic ignored "-Wpointer-to-int-cast"
-        kc = (Uint32)gfc_list_get_nth(command->keyCodes,i);
-        if (!kc)continue;
-        if (kc == EMK_Shift)
+        kc = (Uint32)(size_t)gfc_list_get_nth(command->keyCodes,i);
+        if ((kc >= EMK_Shift)&&(kc <= EMK_Super))kc = gfc_input_mod_bit(kc);
+        else if ((!kc)||(kc >= SDL_NUM_SCANCODES))
         {
-            //deal with mod keys
-            if (gfc_input_data.input_old_keys[SDL_SCANCODE_LSHIFT]||gfc_input_data.input_old_keys[SDL_SCANCODE_RSHIFT])old++;
-            if (gfc_input_data.input_keys[SDL_SCANCODE_LSHIFT]||gfc_input_data.input_keys[SDL_SCANCODE_RSHIFT])
-            {
-                new++;
-                command->downCount++;
-            }
+            //a spare bit past the keys is never set, so the command can never be down
+            kc = GFC_INPUT_KEY_WORDS * 64 - 1;
         }
-        else if (kc == EMK_Alt)
+        gfc_input_bit_set(command->keyMask,kc);
+    }
+    c = gfc_list_get_count(command->buttons);
+    for (i = 0; i < c; i++)
+    {
+        kc = (Uint32)(size_t)gfc_list_get_nth(command->buttons,i);
+        if (kc >= GFC_INPUT_MAX_BUTTONS)
         {
-            if (gfc_input_data.input_old_keys[SDL_SCANCODE_LALT]||gfc_input_data.input_old_keys[SDL_SCANCODE_RALT])old++;
-            if (gfc_input_data.input_keys[SDL_SCANCODE_LALT]||gfc_input_data.input_keys[SDL_SCANCODE_RALT])
-            {
-                new++;
-                command->downCount++;
-            }
+            //dropping the button would let the rest of the combo fire without it, so it can never be down instead
+            slog("command %s uses button %i, only the first %i can be bound",command->command,kc,GFC_INPUT_MAX_BUTTONS);
+            kc = GFC_INPUT_BUTTON_NEVER;
         }
-        else if (kc == EMK_Ctrl)
+        command->buttonMask |= (Uint64)1 << kc;
+    }
+}
+
+/**
+ * @brief add a command to the reverse index of every key and button it uses
+ */
+void gfc_input_command_index(Input *command,Uint32 position)
+{
+    Uint32 *marks,*update;
+    Uint32 i,size;
+    void *data = (void *)(size_t)position;
+    if (position >= gfc_input_data.command_marks_size)
+    {
+        size = MAX(gfc_input_data.command_marks_size * 2,64);
+        //each command is queued at most once a frame, so the update queue never needs more room than the marks
+        update = realloc(gfc_input_data.update_commands,sizeof(Uint32) * size);
+        if (!update)
         {
-            if (gfc_input_data.input_old_keys[SDL_SCANCODE_LCTRL]||gfc_input_data.input_old_keys[SDL_SCANCODE_RCTRL])old++;
-            if (gfc_input_data.input_keys[SDL_SCANCODE_LCTRL]||gfc_input_data.input_keys[SDL_SCANCODE_RCTRL])
-            {
-                command->downCount++;
-                new++;
-            }
+            slog("failed to allocate input command queue");
+            return;
         }
-        else if (kc == EMK_Super)
+        gfc_input_data.update_commands = update;
+        marks = realloc(gfc_input_data.command_marks,sizeof(Uint32) * size);
+        if (!marks)
         {
-            if (gfc_input_data.input_old_keys[SDL_SCANCODE_LGUI]||gfc_input_data.input_old_keys[SDL_SCANCODE_RGUI])old++;
-            if (gfc_input_data.input_keys[SDL_SCANCODE_LGUI]||gfc_input_data.input_keys[SDL_SCANCODE_RGUI])
-            {
-                command->downCount++;
-                new++;
-            }
+            slog("failed to allocate input command marks");
+            return;
         }
-        else
+        memset(&marks[gfc_input_data.command_marks_size],0,sizeof(Uint32) * (size - gfc_input_data.command_marks_size));
+        gfc_input_data.command_marks = marks;
+        gfc_input_data.command_marks_size = size;
+    }
+    for (i = 0; i < GFC_INPUT_KEY_BITS; i++)
+    {
+        if (!gfc_input_bit_test(command->keyMask,i))continue;
+        if (!gfc_input_data.key_commands[i])gfc_input_data.key_commands[i] = gfc_list_new();
+        gfc_input_data.key_commands[i] = gfc_list_append(gfc_input_data.key_commands[i],data);
+    }
+    for (i = 0; i < GFC_INPUT_MAX_BUTTONS; i++)
+    {
+        if (!((command->buttonMask >> i) & 1))continue;
+        if (!gfc_input_data.button_commands[i])gfc_input_data.button_commands[i] = gfc_list_new();
+        gfc_input_data.button_commands[i] = gfc_list_append(gfc_input_data.button_commands[i],data);
+    }
+    //update it once, in case its keys are already down
+    gfc_input_data.active_commands = gfc_list_append(gfc_input_data.active_commands,data);
+}
+
+/**
+ * @brief add commands to this frame's update, once each
+ * @param positions list of positions in input_list
+ */
+void gfc_input_commands_queue(List *positions)
+{
+    Uint32 i,c,position;
+    c = gfc_list_get_count(positions);
+    for (i = 0; i < c; i++)
+    {
+        position = (Uint32)(size_t)gfc_list_get_nth(positions,i);
+        if (position >= gfc_input_data.command_marks_size)continue;
+        if (gfc_input_data.command_marks[position] == gfc_input_data.frame)continue;
+        gfc_input_data.command_marks[position] = gfc_input_data.frame;
+        gfc_input_data.update_commands[gfc_input_data.update_count++] = position;
+    }
+}
+
+int gfc_input_position_compare(const void *a,const void *b)
+{
+    Uint32 pa = *(const Uint32 *)a;
+    Uint32 pb = *(const Uint32 *)b;
+    if (pa < pb)return -1;
+    if (pa > pb)return 1;
+    return 0;
+}
+
+/**
+ * @brief update only the commands bound to a key or button that changed, and the ones still pressed, held or released
+ */
+void gfc_input_update_commands()
+{
+    GFC_InputController *controller;
+    List *active;
+    Input *in;
+    Uint64 changed;
+    Uint32 i,c,w,b,position;
+    if (!++gfc_input_data.frame)
+    {
+        //wrapped around, so old marks could match again
+        if (gfc_input_data.command_marks)memset(gfc_input_data.command_marks,0,sizeof(Uint32) * gfc_input_data.command_marks_size);
+        gfc_input_data.frame = 1;
+    }
+    gfc_input_data.update_count = 0;
+    active = gfc_input_data.active_commands;
+    gfc_input_data.active_commands = NULL;
+    gfc_input_commands_queue(active);
+    gfc_list_delete(active);
+    for (w = 0; w < GFC_INPUT_KEY_WORDS; w++)
+    {
+        changed = gfc_input_data.key_bits[w] ^ gfc_input_data.old_key_bits[w];
+        for (b = 0; changed; b++,changed >>= 1)
         {
-            if(gfc_input_data.input_old_keys[kc])old++;
-            if(gfc_input_data.input_keys[kc])
+            if ((changed & 1)&&((w * 64) + b < GFC_INPUT_KEY_BITS))
             {
-                command->downCount++;
-                new++;
+                gfc_input_commands_queue(gfc_input_data.key_commands[(w * 64) + b]);
             }
         }
     }
-    if ((old == c)&&(new == c))
+    c = gfc_list_get_count(gfc_input_data.controllers);
+    for (i = 0; i < c; i++)
     {
-        command->state = IET_Hold;
-        if (command->onHold)
+        controller = gfc_list_get_nth(gfc_input_data.controllers,i);
+        if (!controller)continue;
+        changed = controller->button_bits ^ controller->old_button_bits;
+        for (b = 0; changed; b++,changed >>= 1)
         {
-            command->onHold(command->data);
+            if (changed & 1)gfc_input_commands_queue(gfc_input_data.button_commands[b]);
         }
     }
-    else if ((old == c)&&(new != c))
+    c = gfc_input_data.update_count;
+    if (c > 1)
     {
-        command->state = IET_Release;
-        if (command->onRelease)
-        {
-            command->onRelease(command->data);
-        }
+        //keep the callbacks in the order the commands were loaded
+        qsort(gfc_input_data.update_commands,c,sizeof(Uint32),gfc_input_position_compare);
     }
-    else if ((old != c)&&(new == c))
+    for (i = 0; i < c; i++)
     {
-        command->state = IET_Press;
-        command->pressTime = SDL_GetTicks();
-        if (command->onPress)
+        position = gfc_input_data.update_commands[i];
+        in = gfc_list_get_nth(gfc_input_data.input_list,position);
+        if (!in)continue;
+        gfc_input_update_command(in);
+        if (in->state != IET_Idle)
         {
-            command->onPress(command->data);
+            gfc_input_data.active_commands = gfc_list_append(gfc_input_data.active_commands,(void *)(size_t)position);
         }
     }
-    else
-    {
-        command->state = IET_Idle;
-        gfc_input_update_controller(command);
-    }
 }
 
 Input *gfc_input_get_by_name(const char *name)
 {
-    Uint32 c,i;
-    Input *in;
-    if (!name)
+    size_t position;
+    if ((!name)||(!gfc_input_data.input_index))
     {
         return NULL;
     }
-    c = gfc_list_get_count(gfc_input_data.input_list);
-    for (i = 0;i < c;i++)
-    {
-        in = (Input *)gfc_list_get_nth(gfc_input_data.input_list,i);
-        if (!in)continue;
-        if (gfc_line_cmp(in->command,name)==0)
-        {
-            return in;
-        }
-    }
-    return 0;
+    position = (size_t)gfc_hashmap_get(gfc_input_data.input_index,name);
+    if (!position)return NULL;
+    return (Input *)gfc_list_get_nth(gfc_input_data.input_list,position - 1);
+}
+
+GFC_InputCommandHandle gfc_input_command_handle(const char *command)
+{
+    size_t position;
+    if ((!command)||(!gfc_input_data.input_index))return GFC_INPUT_COMMAND_INVALID_HANDLE;
+    position = (size_t)gfc_hashmap_get(gfc_input_data.input_index,command);
+    if (!position)return GFC_INPUT_COMMAND_INVALID_HANDLE;
+    return ((Uint32)gfc_input_data.generation << 16) | (Uint32)position;
+}
+
+Input *gfc_input_get_by_handle(GFC_InputCommandHandle handle)
+{
+    Uint32 position;
+    if ((handle >> 16) != gfc_input_data.generation)return NULL;//from before a purge
+    position = handle & 0xFFFF;
+    if (!position)return NULL;
+    return (Input *)gfc_list_get_nth(gfc_input_data.input_list,position - 1);
+}
+
+InputEventType gfc_input_command_get_state_by_handle(GFC_InputCommandHandle handle)
+{
+    Input *in;
+    in = gfc_input_get_by_handle(handle);
+    if (!in)return IET_Idle;
+    return in->state;
+}
+
+Uint8 gfc_input_command_pressed_by_handle(GFC_InputCommandHandle handle)
+{
+    return gfc_input_command_get_state_by_handle(handle) == IET_Press;
+}
+
+Uint8 gfc_input_command_held_by_handle(GFC_InputCommandHandle handle)
+{
+    return gfc_input_command_get_state_by_handle(handle) == IET_Hold;
+}
+
+Uint8 gfc_input_command_released_by_handle(GFC_InputCommandHandle handle)
+{
+    return gfc_input_command_get_state_by_handle(handle) == IET_Release;
+}
+
+Uint8 gfc_input_command_down_by_handle(GFC_InputCommandHandle handle)
+{
+    InputEventType state;
+    state = gfc_input_command_get_state_by_handle(handle);
+    return (state == IET_Press)||(state == IET_Hold);
 }
 
 Uint8 gfc_input_command_pressed(const char *command)
@@ -656,34 +854,31 @@ InputEventType gfc_input_command_get_state(const char *command)
     return in->state;
 }
 
+Uint32 gfc_input_get_count_by_scancode(SDL_Scancode keysym)
+{
+    if ((keysym < 0)||(keysym >= SDL_NUM_SCANCODES))return 0;
+    return gfc_list_get_count(gfc_input_data.key_commands[keysym]);
+}
+
+Input *gfc_input_get_nth_by_scancode(SDL_Scancode keysym,Uint32 n)
+{
+    if (n >= gfc_input_get_count_by_scancode(keysym))return NULL;
+    return gfc_list_get_nth(gfc_input_data.input_list,(Uint32)(size_t)gfc_list_get_nth(gfc_input_data.key_commands[keysym],n));
+}
+
 List *gfc_input_get_by_scancode(SDL_Scancode keysym)
 {
-    int i,c,kc,ki;
+    Uint32 i,c;
     Input *in;
     List *keylist = NULL;
+    c = gfc_input_get_count_by_scancode(keysym);
+    if (!c)return NULL;
     keylist = gfc_list_new();
-    
-    c = gfc_list_get_count(gfc_input_data.input_list);
     for (i = 0;i < c;i++)
     {
-        in = (Input *)gfc_list_get_nth(gfc_input_data.input_list,i);
+        in = gfc_input_get_nth_by_scancode(keysym,i);
         if (!in)continue;
-        kc = gfc_list_get_count(in->keyCodes);
-        if (!kc)continue;
-        for (ki = 0;ki < kc;ki++)
-        {
-            if ((SDL_Scancode)gfc_list_get_nth(in->keyCodes,ki) == keysym)
-            {
-                keylist = gfc_list_append(keylist,in);
-                break;
-            }
-        }
-    }
-    
-    if (gfc_list_get_count(keylist) == 0)
-    {
-        gfc_list_delete(keylist);
-        return NULL;
+        keylist = gfc_list_append(keylist,in);
     }
     return keylist;
 }
@@ -695,7 +890,7 @@ void gfc_input_update()
     Uint32 c,i;
     SDL_Event event = {0};
     
-    memcpy(gfc_input_data.input_old_keys,gfc_input_data.input_keys,sizeof(Uint8)*gfc_input_data.input_key_count);
+    memcpy(gfc_input_data.old_key_bits,gfc_input_data.key_bits,sizeof(gfc_input_data.key_bits));
     gfc_input_data.mouse_wheel_x_old = gfc_input_data.mouse_wheel_x;
     gfc_input_data.mouse_wheel_y_old = gfc_input_data.mouse_wheel_y;
     gfc_input_data.mouse_wheel_x = 0;
@@ -712,14 +907,8 @@ void gfc_input_update()
     }
 
     gfc_input_data.input_keys = SDL_GetKeyboardState(&gfc_input_data.input_key_count);
-
-    c = gfc_list_get_count(gfc_input_data.input_list);
-    for (i = 0;i < c;i++)
-    {
-        in = gfc_list_get_nth(gfc_input_data.input_list,i);
-        if (!in)continue;
-        gfc_input_update_command(in);
-    }
+    gfc_input_keys_pack();
+    gfc_input_update_commands();
     while(SDL_PollEvent(&event))
     {
         if (event.type == SDL_WINDOWEVENT)
@@ -730,6 +919,10 @@ void gfc_input_update()
                 if (in)
                 {
                     in->state = IET_Press;
+                    //make sure it updates next frame
+                    gfc_input_data.active_commands = gfc_list_append(
+                        gfc_input_data.active_commands,
+                        (void *)((size_t)gfc_hashmap_get(gfc_input_data.input_index,"exit") - 1));
                 }
             }
         }
@@ -767,185 +960,119 @@ InputModKey gfc_input_key_mod_check(const char * buffer)
     return EMK_None;
 }
 
-SDL_Scancode gfc_input_key_to_scancode(const char * buffer)
+typedef struct
+{
+    const char *name;
+    SDL_Scancode scancode;
+}GFC_InputKeyName;
+
+/**
+ * @brief the keys with names longer than one character.  Sorted by strcmp() order for a binary search
+ */
+static const GFC_InputKeyName gfc_input_key_names[] =
+{
+    {"BACKSPACE",SDL_SCANCODE_BACKSPACE},
+    {"DELETE",SDL_SCANCODE_DELETE},
+    {"DOWN",SDL_SCANCODE_DOWN},
+    {"ESCAPE",SDL_SCANCODE_ESCAPE},
+    {"F1",SDL_SCANCODE_F1},
+    {"F10",SDL_SCANCODE_F10},
+    {"F11",SDL_SCANCODE_F11},
+    {"F12",SDL_SCANCODE_F12},
+    {"F13",SDL_SCANCODE_F13},
+    {"F14",SDL_SCANCODE_F14},
+    {"F15",SDL_SCANCODE_F15},
+    {"F16",SDL_SCANCODE_F16},
+    {"F17",SDL_SCANCODE_F17},
+    {"F18",SDL_SCANCODE_F18},
+    {"F19",SDL_SCANCODE_F19},
+    {"F2",SDL_SCANCODE_F2},
+    {"F20",SDL_SCANCODE_F20},
+    {"F21",SDL_SCANCODE_F21},
+    {"F22",SDL_SCANCODE_F22},
+    {"F23",SDL_SCANCODE_F23},
+    {"F24",SDL_SCANCODE_F24},
+    {"F3",SDL_SCANCODE_F3},
+    {"F4",SDL_SCANCODE_F4},
+    {"F5",SDL_SCANCODE_F5},
+    {"F6",SDL_SCANCODE_F6},
+    {"F7",SDL_SCANCODE_F7},
+    {"F8",SDL_SCANCODE_F8},
+    {"F9",SDL_SCANCODE_F9},
+    {"LALT",SDL_SCANCODE_LALT},
+    {"LCTRL",SDL_SCANCODE_LCTRL},
+    {"LEFT",SDL_SCANCODE_LEFT},
+    {"LSHIFT",SDL_SCANCODE_LSHIFT},
+    {"RALT",SDL_SCANCODE_RALT},
+    {"RCTRL",SDL_SCANCODE_RCTRL},
+    {"RETURN",SDL_SCANCODE_RETURN},
+    {"RIGHT",SDL_SCANCODE_RIGHT},
+    {"RSHIFT",SDL_SCANCODE_RSHIFT},
+    {"TAB",SDL_SCANCODE_TAB},
+    {"UP",SDL_SCANCODE_UP}
+};
+
+/**
+ * @brief the keys named by a single character that do not follow from their position in ascii
+ */
+static const SDL_Scancode gfc_input_key_chars[128] =
+{
+    ['0'] = SDL_SCANCODE_0,
+    ['1'] = SDL_SCANCODE_1,
+    ['2'] = SDL_SCANCODE_2,
+    ['3'] = SDL_SCANCODE_3,
+    ['4'] = SDL_SCANCODE_4,
+    ['5'] = SDL_SCANCODE_5,
+    ['6'] = SDL_SCANCODE_6,
+    ['7'] = SDL_SCANCODE_7,
+    ['8'] = SDL_SCANCODE_8,
+    ['9'] = SDL_SCANCODE_9,
+    ['-'] = SDL_SCANCODE_MINUS,
+    ['='] = SDL_SCANCODE_EQUALS,
+    ['['] = SDL_SCANCODE_LEFTBRACKET,
+    [']'] = SDL_SCANCODE_RIGHTBRACKET,
+    ['.'] = SDL_SCANCODE_PERIOD,
+    [','] = SDL_SCANCODE_COMMA,
+    [';'] = SDL_SCANCODE_SEMICOLON,
+    ['\\'] = SDL_SCANCODE_BACKSLASH,
+    ['/'] = SDL_SCANCODE_SLASH,
+    ['\''] = SDL_SCANCODE_APOSTROPHE,
+    ['`'] = SDL_SCANCODE_GRAVE
+};
+
+int gfc_input_key_name_compare(const void *key,const void *entry)
 {
-    int F = 0;
-    SDL_Scancode kc = -1;
-    if (strlen(buffer) == 1)
+    return strcmp((const char *)key,((const GFC_InputKeyName *)entry)->name);
+}
+
+SDL_Scancode gfc_input_key_lookup(const char * buffer)
+{
+    const GFC_InputKeyName *entry;
+    unsigned char c;
+    if ((!buffer)||(!buffer[0]))return -1;
+    if (!buffer[1])
     {
         //single letter code
-        if ((buffer[0] >= 'a')&&(buffer[0] <= 'z'))
-        {
-            kc = SDL_SCANCODE_A + buffer[0] - 'a';
-        }
-        else if (buffer[0] == '0')
-        {
-            kc = SDL_SCANCODE_0;
-        }
-        else if (buffer[0] == '1')
-        {
-            kc = SDL_SCANCODE_1;
-        }
-        else if (buffer[0] == '2')
-        {
-            kc = SDL_SCANCODE_2;
-        }
-        else if (buffer[0] == '3')
-        {
-            kc = SDL_SCANCODE_3;
-        }
-        else if (buffer[0] == '4')
-        {
-            kc = SDL_SCANCODE_4;
-        }
-        else if (buffer[0] == '5')
-        {
-            kc = SDL_SCANCODE_5;
-        }
-        else if (buffer[0] == '6')
-        {
-            kc = SDL_SCANCODE_6;
-        }
-        else if (buffer[0] == '7')
-        {
-            kc = SDL_SCANCODE_7;
-        }
-        else if (buffer[0] == '8')
-        {
-            kc = SDL_SCANCODE_8;
-        }
-        else if (buffer[0] == '9')
-        {
-            kc = SDL_SCANCODE_9;
-        }
-        else if (buffer[0] == '-')
-        {
-            kc = SDL_SCANCODE_MINUS;
-        }
-        else if (buffer[0] == '=')
-        {
-            kc = SDL_SCANCODE_EQUALS;
-        }
-        else if (buffer[0] == '[')
-        {
-            kc = SDL_SCANCODE_LEFTBRACKET;
-        }
-        else if (buffer[0] == ']')
-        {
-            kc = SDL_SCANCODE_RIGHTBRACKET;
-        }
-        else if (buffer[0] == '.')
-        {
-            kc = SDL_SCANCODE_PERIOD;
-        }
-        else if (buffer[0] == ',')
-        {
-            kc = SDL_SCANCODE_COMMA;
-        }
-        else if (buffer[0] == ';')
-        {
-            kc = SDL_SCANCODE_SEMICOLON;
-        }
-        else if (buffer[0] == '\\')
-        {
-            kc = SDL_SCANCODE_BACKSLASH;
-        }
-        else if (buffer[0] == '/')
-        {
-            kc = SDL_SCANCODE_SLASH;
-        }
-        else if (buffer[0] == '\'')
-        {
-            kc = SDL_SCANCODE_APOSTROPHE;
-        }
-        else if (buffer[0] == ';')
-        {
-            kc = SDL_SCANCODE_SEMICOLON;
-        }
-        else if (buffer[0] == '`')
-        {
-            kc = SDL_SCANCODE_GRAVE;
-        }
-        else if ((buffer[0] >= ' ')&&(buffer[0] <= '`'))
-        {
-            kc = SDL_SCANCODE_SPACE + buffer[0] - ' ';
-        }
-    }
-    else
-    {
-        if (buffer[0] == 'F')
-        {
-            F = atoi(&buffer[1]);
-            if (F <= 12)
-            {
-                kc = SDL_SCANCODE_F1 + F - 1; 
-            }
-            else if (F <= 24)
-            {
-                kc = SDL_SCANCODE_F13 + F - 1; 
-            }
-        }
-        else if (strcmp(buffer,"BACKSPACE") == 0)
-        {
-            kc = SDL_SCANCODE_BACKSPACE;
-        }
-        else if (strcmp(buffer,"RIGHT") == 0)
-        {
-            kc = SDL_SCANCODE_RIGHT;
-        }
-        else if (strcmp(buffer,"LEFT") == 0)
-        {
-            kc = SDL_SCANCODE_LEFT;
-        }
-        else if (strcmp(buffer,"UP") == 0)
-        {
-            kc = SDL_SCANCODE_UP;
-        }
-        else if (strcmp(buffer,"DOWN") == 0)
-        {
-            kc = SDL_SCANCODE_DOWN;
-        }
-        else if (strcmp(buffer,"LALT") == 0)
-        {
-            kc = SDL_SCANCODE_LALT;
-        }
-        else if (strcmp(buffer,"RALT") == 0)
-        {
-            kc = SDL_SCANCODE_RALT;
-        }
-        else if (strcmp(buffer,"LSHIFT") == 0)
-        {
-            kc = SDL_SCANCODE_LSHIFT;
-        }
-        else if (strcmp(buffer,"RSHIFT") == 0)
-        {
-            kc = SDL_SCANCODE_RSHIFT;
-        }
-        else if (strcmp(buffer,"LCTRL") == 0)
-        {
-            kc = SDL_SCANCODE_LCTRL;
-        }
-        else if (strcmp(buffer,"RCTRL") == 0)
-        {
-            kc = SDL_SCANCODE_RCTRL;
-        }
-        else if (strcmp(buffer,"TAB") == 0)
-        {
-            kc = SDL_SCANCODE_TAB;
-        }
-        else if (strcmp(buffer,"RETURN") == 0)
-        {
-            kc = SDL_SCANCODE_RETURN;
-        }
-        else if (strcmp(buffer,"DELETE") == 0)
-        {
-            kc = SDL_SCANCODE_DELETE;
-        }
-        else if (strcmp(buffer,"ESCAPE") == 0)
-        {
-            kc = SDL_SCANCODE_ESCAPE;
-        }
+        c = (unsigned char)buffer[0];
+        if ((c >= 'a')&&(c <= 'z'))return SDL_SCANCODE_A + c - 'a';
+        if ((c < 128)&&(gfc_input_key_chars[c] != SDL_SCANCODE_UNKNOWN))return gfc_input_key_chars[c];
+        if ((c >= ' ')&&(c <= '`'))return SDL_SCANCODE_SPACE + c - ' ';
+        return -1;
     }
+    entry = bsearch(
+        buffer,
+        gfc_input_key_names,
+        sizeof(gfc_input_key_names) / sizeof(GFC_InputKeyName),
+        sizeof(GFC_InputKeyName),
+        gfc_input_key_name_compare);
+    if (!entry)return -1;
+    return entry->scancode;
+}
+
+SDL_Scancode gfc_input_key_to_scancode(const char * buffer)
+{
+    SDL_Scancode kc;
+    kc = gfc_input_key_lookup(buffer);
     if (kc == -1)
     {
         slog("no input mapping available for %s",buffer);
@@ -956,68 +1083,68 @@ SDL_Scancode gfc_input_key_to_scancode(const char * buffer)
 Uint8 gfc_input_key_pressed(const char *key)
 {
     SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
+    kc = gfc_input_key_lookup(key);
     if (kc == -1)return 0;
-    if ((!gfc_input_data.input_old_keys[kc])&&(gfc_input_data.input_keys[kc]))return 1;
+    if ((!gfc_input_bit_test(gfc_input_data.old_key_bits,kc))&&(gfc_input_bit_test(gfc_input_data.key_bits,kc)))return 1;
     return 0;
 }
 
 Uint8 gfc_input_key_released(const char *key)
 {
     SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
+    kc = gfc_input_key_lookup(key);
     if (kc == -1)return 0;
-    if ((gfc_input_data.input_old_keys[kc])&&(!gfc_input_data.input_keys[kc]))return 1;
+    if ((gfc_input_bit_test(gfc_input_data.old_key_bits,kc))&&(!gfc_input_bit_test(gfc_input_data.key_bits,kc)))return 1;
     return 0;
 }
 
 Uint8 gfc_input_key_held(const char *key)
 {
     SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
+    kc = gfc_input_key_lookup(key);
     if (kc == -1)return 0;
-    if ((gfc_input_data.input_old_keys[kc])&&(gfc_input_data.input_keys[kc]))return 1;
+    if ((gfc_input_bit_test(gfc_input_data.old_key_bits,kc))&&(gfc_input_bit_test(gfc_input_data.key_bits,kc)))return 1;
     return 0;
 }
 
 Uint8 gfc_input_key_down(const char *key)
 {
     SDL_Scancode kc;
-    kc = gfc_input_key_to_scancode(key);
+    kc = gfc_input_key_lookup(key);
     if (kc == -1)return 0;
-    if (gfc_input_data.input_keys[kc])
+    if (gfc_input_bit_test(gfc_input_data.key_bits,kc))
     {
         return 1;
     }
     return 0;
 }
 
-void gfc_input_parse_command_json(SJson *command)
+void gfc_input_parse_command_json(GFC_JsonValue *command)
 {
-    SJson *value,*list;
+    GFC_JsonValue *value,*list;
     const char * buffer;
     Input *in;
-    int count,i,index;
+    int index;
+    Uint32 count,i;
     Sint32 kc = 0;
     if (!command)return;
-    value = sj_object_get_value(command,"command");
-    if (!value)
+    buffer = gfc_json_get_string(gfc_json_object_get(command,"command"));
+    if (!buffer)
     {
         slog("input command missing 'command' key");
         return;
     }
     in = gfc_input_new();
     if (!in)return;
-    buffer = sj_get_string_value(value);
     gfc_line_cpy(in->command,buffer);
-    list = sj_object_get_value(command,"keys");
-    count = sj_array_get_count(list);
+    list = gfc_json_object_get(command,"keys");
+    count = gfc_json_get_count(list);
     for (i = 0; i< count; i++)
     {
-        value = sj_array_get_nth(list,i);
+        value = gfc_json_array_get_nth(list,i);
         if (!value)continue;
-        buffer = sj_get_string_value(value);
-        if (strlen(buffer) == 0)
+        buffer = gfc_json_get_string(value);
+        if ((!buffer)||(strlen(buffer) == 0))
         {
             slog("error in key list, empty value");
             continue;   //error
@@ -1034,22 +1161,21 @@ void gfc_input_parse_command_json(SJson *command)
             in->keyCodes = gfc_list_append(in->keyCodes,(void *)kc);
         }
     }
-    index = 0;
-    value = sj_object_get_value(command,"controller");
+    value = gfc_json_object_get(command,"controller");
     if (value != NULL)
     {
-        sj_get_integer_value(value,&index);
+        index = gfc_json_get_int(value,0);
         in->controller = index + 1;
-        list = sj_object_get_value(command,"buttons");
+        list = gfc_json_object_get(command,"buttons");
         if (list)
         {
-            count = sj_array_get_count(list);
+            count = gfc_json_get_count(list);
             for (i = 0; i < count; i++)
             {
-                value = sj_array_get_nth(list,i);
+                value = gfc_json_array_get_nth(list,i);
                 if (!value)continue;
-                buffer = sj_get_string_value(value);
-                if (strlen(buffer) == 0)continue;
+                buffer = gfc_json_get_string(value);
+                if ((!buffer)||(strlen(buffer) == 0))continue;
                 index = gfc_input_controller_get_button_index(buffer);
                 if (index >= 0)
                 {
@@ -1061,45 +1187,59 @@ void gfc_input_parse_command_json(SJson *command)
                 }
             }
         }
-        list = sj_object_get_value(command,"axes");
+        list = gfc_json_object_get(command,"axes");
         if (list)
         {
-            count = sj_array_get_count(list);
+            count = gfc_json_get_count(list);
             for (i = 0; i < count; i++)
             {
-                value = sj_array_get_nth(list,i);
+                value = gfc_json_array_get_nth(list,i);
                 if (!value)continue;
             }            
         }
     }
+    gfc_input_command_compile(in);
+    if (gfc_list_get_count(gfc_input_data.input_list) >= 0xFFFF)
+    {
+        slog("too many input commands, cannot add %s",in->command);
+        gfc_input_delete(in);
+        return;
+    }
     gfc_input_data.input_list = gfc_list_append(gfc_input_data.input_list,(void *)in);
+    gfc_input_command_index(in,gfc_list_get_count(gfc_input_data.input_list) - 1);
+    if (!gfc_input_data.input_index)gfc_input_data.input_index = gfc_hashmap_new();
+    if (!gfc_hashmap_get(gfc_input_data.input_index,in->command))
+    {
+        //the first command with a name wins, as it did when searching the list
+        gfc_hashmap_insert(gfc_input_data.input_index,in->command,(void *)(size_t)gfc_list_get_count(gfc_input_data.input_list));
+    }
 }
 
 void gfc_input_commands_load(char *configFile)
 {
-    SJson *json;
-    SJson *commands;
-    SJson *value;
-    int count,i;
+    GFC_JsonDoc *doc;
+    GFC_JsonValue *commands;
+    GFC_JsonValue *value;
+    Uint32 count,i;
     if (!configFile)return;
-    json = gfc_pak_load_json(configFile);
-    if (!json)return;
-    commands = sj_object_get_value(json,"commands");
+    doc = gfc_json_doc_load(configFile);
+    if (!doc)return;
+    commands = gfc_json_object_get(doc->root,"commands");
     if (!commands)
     {
         slog("config file %s does not contain 'commands' object",configFile);
-        sj_free(json);
+        gfc_json_doc_free(doc);
         return;
     }
-    count = sj_array_get_count(commands);
+    count = gfc_json_get_count(commands);
     for (i = 0; i< count; i++)
     {
-        value = sj_array_get_nth(commands,i);
+        value = gfc_json_array_get_nth(commands,i);
         if (!value)continue;
         gfc_input_parse_command_json(value);
     }
     
-    sj_free(json);
+    gfc_json_doc_free(doc);
 }
 
 
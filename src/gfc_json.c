@@ -0,0 +1,493 @@
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_pak.h"
+#include "gfc_json.h"
+
+#define GFC_JSON_READ_CHUNK     65536
+#define GFC_JSON_BOM            "\xEF\xBB\xBF"
+
+typedef enum
+{
+    JPS_Value = 0,      /**<a value: the top level one, one after a ':' or one after a ',' in an array*/
+    JPS_ValueOrEnd,     /**<the first value of an array, or ']'*/
+    JPS_KeyOrEnd,       /**<the first key of an object, or '}'*/
+    JPS_Key,            /**<a key, after a ',' in an object*/
+    JPS_Colon,
+    JPS_CommaOrEnd,     /**<after a value in an object or array*/
+    JPS_Done            /**<the top level value is complete*/
+}GFC_JsonParserState;
+
+typedef enum
+{
+    JPT_None = 0,
+    JPT_String,
+    JPT_Number,
+    JPT_Literal
+}GFC_JsonParserToken;
+
+GFC_JsonParser *gfc_json_parser_new(const GFC_JsonCallbacks *callbacks,void *data)
+{
+    GFC_JsonParser *parser;
+    if (!callbacks)
+    {
+        slog("cannot make a json parser without callbacks");
+        return NULL;
+    }
+    parser = gfc_allocate_array(sizeof(GFC_JsonParser),1);
+    if (!parser)return NULL;
+    parser->callbacks = callbacks;
+    parser->data = data;
+    parser->line = 1;
+    return parser;
+}
+
+void gfc_json_parser_free(GFC_JsonParser *parser)
+{
+    if (!parser)return;
+    if (parser->stack)free(parser->stack);
+    if (parser->text)free(parser->text);
+    free(parser);
+}
+
+Bool gfc_json_parser_error(GFC_JsonParser *parser,const char *message)
+{
+    parser->failed = 1;
+    gfc_line_sprintf(parser->error,"line %u: %s",parser->line,message);
+    return 0;
+}
+
+Bool gfc_json_parser_stopped(GFC_JsonParser *parser)
+{
+    return gfc_json_parser_error(parser,"stopped by a callback");
+}
+
+const char *gfc_json_parser_get_error(GFC_JsonParser *parser)
+{
+    if (!parser)return "no parser";
+    return parser->error;
+}
+
+Bool gfc_json_parser_append(GFC_JsonParser *parser,char c)
+{
+    char *text;
+    size_t size;
+    if (parser->textLength + 1 >= parser->textSize)
+    {
+        size = parser->textSize ? parser->textSize * 2 : 256;
+        text = realloc(parser->text,size);
+        if (!text)return gfc_json_parser_error(parser,"out of memory");
+        parser->text = text;
+        parser->textSize = size;
+    }
+    parser->text[parser->textLength++] = c;
+    return 1;
+}
+
+Bool gfc_json_parser_append_code_point(GFC_JsonParser *parser,Uint32 codePoint)
+{
+    if (codePoint < 0x80)return gfc_json_parser_append(parser,codePoint);
+    if (codePoint < 0x800)
+    {
+        return gfc_json_parser_append(parser,0xC0 | (codePoint >> 6))&&
+            gfc_json_parser_append(parser,0x80 | (codePoint & 0x3F));
+    }
+    if (codePoint < 0x10000)
+    {
+        return gfc_json_parser_append(parser,0xE0 | (codePoint >> 12))&&
+            gfc_json_parser_append(parser,0x80 | ((codePoint >> 6) & 0x3F))&&
+            gfc_json_parser_append(parser,0x80 | (codePoint & 0x3F));
+    }
+    return gfc_json_parser_append(parser,0xF0 | (codePoint >> 18))&&
+        gfc_json_parser_append(parser,0x80 | ((codePoint >> 12) & 0x3F))&&
+        gfc_json_parser_append(parser,0x80 | ((codePoint >> 6) & 0x3F))&&
+        gfc_json_parser_append(parser,0x80 | (codePoint & 0x3F));
+}
+
+/**
+ * @brief a high surrogate escape not followed by a low one is not valid utf-16, so it becomes a replacement character
+ */
+Bool gfc_json_parser_flush_surrogate(GFC_JsonParser *parser)
+{
+    if (!parser->highSurrogate)return 1;
+    parser->highSurrogate = 0;
+    return gfc_json_parser_append_code_point(parser,0xFFFD);
+}
+
+Bool gfc_json_parser_escaped_code_point(GFC_JsonParser *parser,Uint32 codePoint)
+{
+    if ((codePoint >= 0xD800)&&(codePoint <= 0xDBFF))
+    {
+        if (!gfc_json_parser_flush_surrogate(parser))return 0;
+        parser->highSurrogate = codePoint;
+        return 1;
+    }
+    if ((codePoint >= 0xDC00)&&(codePoint <= 0xDFFF))
+    {
+        if (!parser->highSurrogate)return gfc_json_parser_append_code_point(parser,0xFFFD);
+        codePoint = 0x10000 + ((parser->highSurrogate - 0xD800) << 10) + (codePoint - 0xDC00);
+        parser->highSurrogate = 0;
+        return gfc_json_parser_append_code_point(parser,codePoint);
+    }
+    if (!gfc_json_parser_flush_surrogate(parser))return 0;
+    return gfc_json_parser_append_code_point(parser,codePoint);
+}
+
+Bool gfc_json_number_is_valid(const char *text,size_t length)
+{
+    size_t i = 0,start;
+    if ((i < length)&&(text[i] == '-'))i++;
+    if (i >= length)return 0;
+    if (text[i] == '0')i++;
+    else if ((text[i] >= '1')&&(text[i] <= '9'))
+    {
+        while ((i < length)&&(text[i] >= '0')&&(text[i] <= '9'))i++;
+    }
+    else return 0;
+    if ((i < length)&&(text[i] == '.'))
+    {
+        for (start = ++i;(i < length)&&(text[i] >= '0')&&(text[i] <= '9');i++);
+        if (i == start)return 0;
+    }
+    if ((i < length)&&((text[i] == 'e')||(text[i] == 'E')))
+    {
+        i++;
+        if ((i < length)&&((text[i] == '+')||(text[i] == '-')))i++;
+        for (start = i;(i < length)&&(text[i] >= '0')&&(text[i] <= '9');i++);
+        if (i == start)return 0;
+    }
+    return i == length;
+}
+
+Bool gfc_json_parser_value_done(GFC_JsonParser *parser)
+{
+    parser->state = parser->depth ? JPS_CommaOrEnd : JPS_Done;
+    return 1;
+}
+
+Bool gfc_json_parser_end_token(GFC_JsonParser *parser)
+{
+    const GFC_JsonCallbacks *callbacks = parser->callbacks;
+    const char *text;
+    size_t length;
+    Uint8 token;
+    token = parser->token;
+    parser->token = JPT_None;
+    if (!gfc_json_parser_append(parser,0))return 0;
+    text = parser->text;
+    length = --parser->textLength;
+    parser->textLength = 0;
+    switch (token)
+    {
+        case JPT_String:
+            if (parser->tokenIsKey)
+            {
+                if ((callbacks->key)&&(!callbacks->key(text,length,parser->data)))return gfc_json_parser_stopped(parser);
+                parser->state = JPS_Colon;
+                return 1;
+            }
+            if ((callbacks->string)&&(!callbacks->string(text,length,parser->data)))return gfc_json_parser_stopped(parser);
+            return gfc_json_parser_value_done(parser);
+        case JPT_Number:
+            if (!gfc_json_number_is_valid(text,length))return gfc_json_parser_error(parser,"bad number");
+            if ((callbacks->number)&&(!callbacks->number(text,length,parser->data)))return gfc_json_parser_stopped(parser);
+            return gfc_json_parser_value_done(parser);
+        case JPT_Literal:
+            if (strcmp(text,"true") == 0)
+            {
+                if ((callbacks->boolean)&&(!callbacks->boolean(1,parser->data)))return gfc_json_parser_stopped(parser);
+            }
+            else if (strcmp(text,"false") == 0)
+            {
+                if ((callbacks->boolean)&&(!callbacks->boolean(0,parser->data)))return gfc_json_parser_stopped(parser);
+            }
+            else if (strcmp(text,"null") == 0)
+            {
+                if ((callbacks->null)&&(!callbacks->null(parser->data)))return gfc_json_parser_stopped(parser);
+            }
+            else return gfc_json_parser_error(parser,"unknown literal, expected true, false or null");
+            return gfc_json_parser_value_done(parser);
+    }
+    return 1;
+}
+
+Bool gfc_json_parser_string_char(GFC_JsonParser *parser,char c)
+{
+    int digit;
+    if (parser->escape == 1)
+    {
+        parser->escape = 0;
+        if (c == 'u')
+        {
+            parser->escape = 2;
+            parser->codePoint = 0;
+            return 1;
+        }
+        if (!gfc_json_parser_flush_surrogate(parser))return 0;
+        switch (c)
+        {
+            case '"':
+            case '\\':
+            case '/':
+                return gfc_json_parser_append(parser,c);
+            case 'b':
+                return gfc_json_parser_append(parser,'\b');
+            case 'f':
+                return gfc_json_parser_append(parser,'\f');
+            case 'n':
+                return gfc_json_parser_append(parser,'\n');
+            case 'r':
+                return gfc_json_parser_append(parser,'\r');
+            case 't':
+                return gfc_json_parser_append(parser,'\t');
+        }
+        return gfc_json_parser_error(parser,"bad escape in string");
+    }
+    if (parser->escape)
+    {
+        if ((c >= '0')&&(c <= '9'))digit = c - '0';
+        else if ((c >= 'a')&&(c <= 'f'))digit = c - 'a' + 10;
+        else if ((c >= 'A')&&(c <= 'F'))digit = c - 'A' + 10;
+        else return gfc_json_parser_error(parser,"bad \\u escape in string");
+        parser->codePoint = (parser->codePoint << 4) | digit;
+        if (++parser->escape < 6)return 1;
+        parser->escape = 0;
+        return gfc_json_parser_escaped_code_point(parser,parser->codePoint);
+    }
+    if (c == '\\')
+    {
+        parser->escape = 1;
+        return 1;
+    }
+    if (!gfc_json_parser_flush_surrogate(parser))return 0;
+    if (c == '"')return gfc_json_parser_end_token(parser);
+    if ((Uint8)c < 0x20)return gfc_json_parser_error(parser,"control character in string, it must be escaped");
+    return gfc_json_parser_append(parser,c);
+}
+
+Bool gfc_json_parser_push(GFC_JsonParser *parser,Uint8 type)
+{
+    Uint8 *stack;
+    Uint32 size;
+    if (parser->depth >= parser->stackSize)
+    {
+        size = parser->stackSize ? parser->stackSize * 2 : 32;
+        stack = realloc(parser->stack,size);
+        if (!stack)return gfc_json_parser_error(parser,"out of memory");
+        parser->stack = stack;
+        parser->stackSize = size;
+    }
+    parser->stack[parser->depth++] = type;
+    return 1;
+}
+
+Bool gfc_json_parser_close(GFC_JsonParser *parser,char c)
+{
+    const GFC_JsonCallbacks *callbacks = parser->callbacks;
+    if ((!parser->depth)||((c == '}')&&(parser->stack[parser->depth - 1] != '{'))||
+        ((c == ']')&&(parser->stack[parser->depth - 1] != '[')))
+    {
+        return gfc_json_parser_error(parser,"mismatched close bracket");
+    }
+    parser->depth--;
+    if (c == '}')
+    {
+        if ((callbacks->end_object)&&(!callbacks->end_object(parser->data)))return gfc_json_parser_stopped(parser);
+    }
+    else if ((callbacks->end_array)&&(!callbacks->end_array(parser->data)))return gfc_json_parser_stopped(parser);
+    return gfc_json_parser_value_done(parser);
+}
+
+Bool gfc_json_parser_begin_value(GFC_JsonParser *parser,char c)
+{
+    const GFC_JsonCallbacks *callbacks = parser->callbacks;
+    if (c == '{')
+    {
+        if (!gfc_json_parser_push(parser,'{'))return 0;
+        if ((callbacks->begin_object)&&(!callbacks->begin_object(parser->data)))return gfc_json_parser_stopped(parser);
+        parser->state = JPS_KeyOrEnd;
+        return 1;
+    }
+    if (c == '[')
+    {
+        if (!gfc_json_parser_push(parser,'['))return 0;
+        if ((callbacks->begin_array)&&(!callbacks->begin_array(parser->data)))return gfc_json_parser_stopped(parser);
+        parser->state = JPS_ValueOrEnd;
+        return 1;
+    }
+    if (c == '"')
+    {
+        parser->token = JPT_String;
+        parser->tokenIsKey = 0;
+        return 1;
+    }
+    if ((c == '-')||((c >= '0')&&(c <= '9')))
+    {
+        parser->token = JPT_Number;
+        return gfc_json_parser_append(parser,c);
+    }
+    if ((c >= 'a')&&(c <= 'z'))
+    {
+        parser->token = JPT_Literal;
+        return gfc_json_parser_append(parser,c);
+    }
+    return gfc_json_parser_error(parser,"unexpected character, expected a value");
+}
+
+Bool gfc_json_parser_feed(GFC_JsonParser *parser,const char *text,size_t length)
+{
+    size_t i;
+    char c;
+    if ((!parser)||(parser->failed))return 0;
+    if (!text)return 1;
+    for (i = 0; i < length; i++)
+    {
+        c = text[i];
+        if (parser->bomRead != 0xFF)
+        {
+            //skip a byte order mark, even one split between feeds
+            if (c == GFC_JSON_BOM[parser->bomRead])
+            {
+                if (++parser->bomRead == strlen(GFC_JSON_BOM))parser->bomRead = 0xFF;
+                continue;
+            }
+            if (parser->bomRead)return gfc_json_parser_error(parser,"incomplete byte order mark");
+            parser->bomRead = 0xFF;
+        }
+        if (c == '\n')parser->line++;
+        if (parser->token == JPT_String)
+        {
+            if (!gfc_json_parser_string_char(parser,c))return 0;
+            continue;
+        }
+        if (parser->token == JPT_Number)
+        {
+            if (((c >= '0')&&(c <= '9'))||(c == '.')||(c == 'e')||(c == 'E')||(c == '+')||(c == '-'))
+            {
+                if (!gfc_json_parser_append(parser,c))return 0;
+                continue;
+            }
+            if (!gfc_json_parser_end_token(parser))return 0;
+        }
+        else if (parser->token == JPT_Literal)
+        {
+            if ((c >= 'a')&&(c <= 'z'))
+            {
+                if (parser->textLength >= 5)return gfc_json_parser_error(parser,"unknown literal, expected true, false or null");
+                if (!gfc_json_parser_append(parser,c))return 0;
+                continue;
+            }
+            if (!gfc_json_parser_end_token(parser))return 0;
+        }
+        if ((c == ' ')||(c == '\t')||(c == '\n')||(c == '\r'))continue;
+        switch (parser->state)
+        {
+            case JPS_Value:
+                if (!gfc_json_parser_begin_value(parser,c))return 0;
+                break;
+            case JPS_ValueOrEnd:
+                if (c == ']')
+                {
+                    if (!gfc_json_parser_close(parser,c))return 0;
+                }
+                else if (!gfc_json_parser_begin_value(parser,c))return 0;
+                break;
+            case JPS_KeyOrEnd:
+            case JPS_Key:
+                if ((c == '}')&&(parser->state == JPS_KeyOrEnd))
+                {
+                    if (!gfc_json_parser_close(parser,c))return 0;
+                }
+                else if (c == '"')
+                {
+                    parser->token = JPT_String;
+                    parser->tokenIsKey = 1;
+                }
+                else return gfc_json_parser_error(parser,"expected an object key");
+                break;
+            case JPS_Colon:
+                if (c != ':')return gfc_json_parser_error(parser,"expected ':' after an object key");
+                parser->state = JPS_Value;
+                break;
+            case JPS_CommaOrEnd:
+                if (c == ',')
+                {
+                    parser->state = (parser->stack[parser->depth - 1] == '{') ? JPS_Key : JPS_Value;
+                }
+                else if ((c == '}')||(c == ']'))
+                {
+                    if (!gfc_json_parser_close(parser,c))return 0;
+                }
+                else return gfc_json_parser_error(parser,"expected ',' or the end of the object or array");
+                break;
+            case JPS_Done:
+                return gfc_json_parser_error(parser,"unexpected text after the end of the json");
+        }
+    }
+    return 1;
+}
+
+Bool gfc_json_parser_finish(GFC_JsonParser *parser)
+{
+    if ((!parser)||(parser->failed))return 0;
+    if (parser->token == JPT_String)return gfc_json_parser_error(parser,"unterminated string");
+    if ((parser->token)&&(!gfc_json_parser_end_token(parser)))return 0;
+    if (parser->state != JPS_Done)return gfc_json_parser_error(parser,"unexpected end of json");
+    return 1;
+}
+
+Bool gfc_json_parse_buffer(const char *text,size_t length,const GFC_JsonCallbacks *callbacks,void *data)
+{
+    GFC_JsonParser *parser;
+    Bool success;
+    parser = gfc_json_parser_new(callbacks,data);
+    if (!parser)return 0;
+    success = gfc_json_parser_feed(parser,text,length)&&gfc_json_parser_finish(parser);
+    if (!success)slog("failed to parse json: %s",parser->error);
+    gfc_json_parser_free(parser);
+    return success;
+}
+
+Bool gfc_json_parse_file(const char *filename,const GFC_JsonCallbacks *callbacks,void *data)
+{
+    GFC_JsonParser *parser;
+    GFC_PakStream *stream;
+    char *buffer;
+    size_t read;
+    Bool success = 1;
+    if (!filename)return 0;
+    parser = gfc_json_parser_new(callbacks,data);
+    if (!parser)return 0;
+    stream = gfc_pak_stream_open(filename);
+    if (!stream)
+    {
+        slog("failed to open json file %s",filename);
+        gfc_json_parser_free(parser);
+        return 0;
+    }
+    buffer = gfc_allocate_array(GFC_JSON_READ_CHUNK,1);
+    if (!buffer)
+    {
+        gfc_pak_stream_close(stream);
+        gfc_json_parser_free(parser);
+        return 0;
+    }
+    while ((success)&&((read = gfc_pak_stream_read(stream,buffer,GFC_JSON_READ_CHUNK)) > 0))
+    {
+        success = gfc_json_parser_feed(parser,buffer,read);
+    }
+    if ((success)&&(gfc_pak_stream_failed(stream)))
+    {
+        slog("failed to read json file %s",filename);
+        success = 0;
+    }
+    else if (success)success = gfc_json_parser_finish(parser);
+    if ((!success)&&(parser->failed))slog("failed to parse json file %s: %s",filename,parser->error);
+    free(buffer);
+    gfc_pak_stream_close(stream);
+    gfc_json_parser_free(parser);
+    return success;
+}
+
+/*eol@eof*/
@@ -0,0 +1,312 @@
+#include <string.h>
+#include <limits.h>
+
+#include "simple_logger.h"
+
+#include "gfc_config.h"
+#include "gfc_json.h"
+#include "gfc_json_doc.h"
+
+#define GFC_JSON_DOC_BLOCK  65536
+
+typedef struct
+{
+    GFC_Arena *arena;
+    GFC_JsonValue *pending;     /**<values whose array or object is still open, each open one has a run at the end*/
+    Uint32 pendingCount;
+    Uint32 pendingSize;
+    Uint32 *starts;             /**<where the run of each open array or object begins in pending*/
+    Uint32 depth;
+    Uint32 startsSize;
+    const char *key;            /**<the key for the next value, NULL in an array*/
+}GFC_JsonDocBuilder;
+
+GFC_JsonValue *gfc_json_doc_builder_add(GFC_JsonDocBuilder *builder,Uint8 type)
+{
+    GFC_JsonValue *pending,*value;
+    Uint32 size;
+    if (builder->pendingCount >= builder->pendingSize)
+    {
+        size = builder->pendingSize ? builder->pendingSize * 2 : 64;
+        pending = realloc(builder->pending,sizeof(GFC_JsonValue) * size);
+        if (!pending)
+        {
+            slog("failed to allocate json document values");
+            return NULL;
+        }
+        builder->pending = pending;
+        builder->pendingSize = size;
+    }
+    value = &builder->pending[builder->pendingCount++];
+    memset(value,0,sizeof(GFC_JsonValue));
+    value->type = type;
+    value->key = builder->key;
+    builder->key = NULL;
+    return value;
+}
+
+char *gfc_json_doc_builder_copy(GFC_JsonDocBuilder *builder,const char *text,size_t length)
+{
+    char *copy;
+    copy = gfc_arena_alloc(builder->arena,length + 1);
+    if (!copy)return NULL;
+    memcpy(copy,text,length);
+    copy[length] = 0;
+    return copy;
+}
+
+Bool gfc_json_doc_builder_text(GFC_JsonDocBuilder *builder,Uint8 type,const char *text,size_t length)
+{
+    GFC_JsonValue *value;
+    char *copy;
+    copy = gfc_json_doc_builder_copy(builder,text,length);
+    if (!copy)return 0;
+    value = gfc_json_doc_builder_add(builder,type);
+    if (!value)return 0;
+    value->v.text = copy;
+    value->count = length;
+    return 1;
+}
+
+Bool gfc_json_doc_builder_open(GFC_JsonDocBuilder *builder,Uint8 type)
+{
+    Uint32 *starts;
+    Uint32 size;
+    if (!gfc_json_doc_builder_add(builder,type))return 0;
+    if (builder->depth >= builder->startsSize)
+    {
+        size = builder->startsSize ? builder->startsSize * 2 : 16;
+        starts = realloc(builder->starts,sizeof(Uint32) * size);
+        if (!starts)return 0;
+        builder->starts = starts;
+        builder->startsSize = size;
+    }
+    builder->starts[builder->depth++] = builder->pendingCount;
+    return 1;
+}
+
+Bool gfc_json_doc_builder_close(void *data)
+{
+    GFC_JsonDocBuilder *builder = data;
+    GFC_JsonValue *parent;
+    Uint32 start,count;
+    start = builder->starts[--builder->depth];
+    count = builder->pendingCount - start;
+    parent = &builder->pending[start - 1];
+    parent->count = count;
+    if (count)
+    {
+        //the children are final now, move them into the arena next to each other
+        parent->v.children = gfc_arena_alloc(builder->arena,sizeof(GFC_JsonValue) * count);
+        if (!parent->v.children)return 0;
+        memcpy(parent->v.children,&builder->pending[start],sizeof(GFC_JsonValue) * count);
+    }
+    builder->pendingCount = start;
+    return 1;
+}
+
+Bool gfc_json_doc_builder_begin_object(void *data)
+{
+    return gfc_json_doc_builder_open(data,GJT_Object);
+}
+
+Bool gfc_json_doc_builder_begin_array(void *data)
+{
+    return gfc_json_doc_builder_open(data,GJT_Array);
+}
+
+Bool gfc_json_doc_builder_key(const char *key,size_t length,void *data)
+{
+    GFC_JsonDocBuilder *builder = data;
+    builder->key = gfc_json_doc_builder_copy(builder,key,length);
+    return builder->key != NULL;
+}
+
+Bool gfc_json_doc_builder_string(const char *str,size_t length,void *data)
+{
+    return gfc_json_doc_builder_text(data,GJT_String,str,length);
+}
+
+Bool gfc_json_doc_builder_number(const char *text,size_t length,void *data)
+{
+    return gfc_json_doc_builder_text(data,GJT_Number,text,length);
+}
+
+Bool gfc_json_doc_builder_boolean(Bool b,void *data)
+{
+    GFC_JsonValue *value;
+    value = gfc_json_doc_builder_add(data,GJT_Bool);
+    if (!value)return 0;
+    value->boolean = b ? 1 : 0;
+    return 1;
+}
+
+Bool gfc_json_doc_builder_null(void *data)
+{
+    return gfc_json_doc_builder_add(data,GJT_Null) != NULL;
+}
+
+static const GFC_JsonCallbacks gfc_json_doc_callbacks =
+{
+    gfc_json_doc_builder_begin_object,
+    gfc_json_doc_builder_close,
+    gfc_json_doc_builder_begin_array,
+    gfc_json_doc_builder_close,
+    gfc_json_doc_builder_key,
+    gfc_json_doc_builder_string,
+    gfc_json_doc_builder_number,
+    gfc_json_doc_builder_boolean,
+    gfc_json_doc_builder_null
+};
+
+GFC_JsonDoc *gfc_json_doc_finish(GFC_JsonDocBuilder *builder,Bool success)
+{
+    GFC_JsonDoc *doc = NULL;
+    if ((success)&&(builder->pendingCount == 1))
+    {
+        doc = gfc_allocate_array(sizeof(GFC_JsonDoc),1);
+        if (doc)
+        {
+            doc->arena = builder->arena;
+            doc->root = gfc_arena_alloc(builder->arena,sizeof(GFC_JsonValue));
+            if (doc->root)memcpy(doc->root,builder->pending,sizeof(GFC_JsonValue));
+            else
+            {
+                free(doc);
+                doc = NULL;
+            }
+        }
+    }
+    if (!doc)gfc_arena_free(builder->arena);
+    if (builder->pending)free(builder->pending);
+    if (builder->starts)free(builder->starts);
+    return doc;
+}
+
+GFC_JsonDoc *gfc_json_doc_parse(const char *text,size_t length)
+{
+    GFC_JsonDocBuilder builder = {0};
+    Bool success;
+    if (!text)return NULL;
+    //the tree is usually a little smaller than the text, so one block tends to hold it all
+    builder.arena = gfc_arena_new(MAX(length,1024));
+    if (!builder.arena)return NULL;
+    success = gfc_json_parse_buffer(text,length,&gfc_json_doc_callbacks,&builder);
+    return gfc_json_doc_finish(&builder,success);
+}
+
+GFC_JsonDoc *gfc_json_doc_load(const char *filename)
+{
+    GFC_JsonDocBuilder builder = {0};
+    Bool success;
+    if (!filename)return NULL;
+    builder.arena = gfc_arena_new(GFC_JSON_DOC_BLOCK);
+    if (!builder.arena)return NULL;
+    success = gfc_json_parse_file(filename,&gfc_json_doc_callbacks,&builder);
+    return gfc_json_doc_finish(&builder,success);
+}
+
+void gfc_json_doc_free(GFC_JsonDoc *doc)
+{
+    if (!doc)return;
+    gfc_arena_free(doc->arena);
+    free(doc);
+}
+
+GFC_JsonValue *gfc_json_object_get(GFC_JsonValue *object,const char *key)
+{
+    Uint32 i;
+    if ((!object)||(!key)||(object->type != GJT_Object))return NULL;
+    for (i = 0; i < object->count; i++)
+    {
+        if (strcmp(object->v.children[i].key,key)==0)return &object->v.children[i];
+    }
+    return NULL;
+}
+
+GFC_JsonValue *gfc_json_array_get_nth(GFC_JsonValue *array,Uint32 n)
+{
+    if ((!array)||((array->type != GJT_Array)&&(array->type != GJT_Object)))return NULL;
+    if (n >= array->count)return NULL;
+    return &array->v.children[n];
+}
+
+Uint32 gfc_json_get_count(GFC_JsonValue *value)
+{
+    if ((!value)||((value->type != GJT_Array)&&(value->type != GJT_Object)))return 0;
+    return value->count;
+}
+
+const char *gfc_json_get_string(GFC_JsonValue *value)
+{
+    if ((!value)||((value->type != GJT_String)&&(value->type != GJT_Number)))return NULL;
+    return value->v.text;
+}
+
+/**
+ * @brief get the text of a number, or of a string that holds nothing but a number, like "3" written by hand
+ */
+const char *gfc_json_get_number_text(GFC_JsonValue *value)
+{
+    const char *end;
+    float number;
+    if (!value)return NULL;
+    if (value->type == GJT_Number)return value->v.text;
+    if (value->type != GJT_String)return NULL;
+    end = gfc_config_parse_float(value->v.text,&number);
+    if (!end)return NULL;
+    while ((*end == ' ')||(*end == '\t')||(*end == '\n')||(*end == '\r'))end++;
+    if (*end != 0)return NULL;
+    return value->v.text;
+}
+
+float gfc_json_get_float(GFC_JsonValue *value,float defaultValue)
+{
+    const char *text;
+    float number;
+    text = gfc_json_get_number_text(value);
+    if (!text)return defaultValue;
+    if (!gfc_config_parse_float(text,&number))return defaultValue;
+    return number;
+}
+
+int gfc_json_get_int(GFC_JsonValue *value,int defaultValue)
+{
+    const char *c;
+    Sint64 number = 0;
+    float f;
+    int sign = 1;
+    c = gfc_json_get_number_text(value);
+    if (!c)return defaultValue;
+    if (*c == '-')
+    {
+        sign = -1;
+        c++;
+    }
+    //read whole numbers exactly, a float only holds 24 bits of them
+    for (; (*c >= '0')&&(*c <= '9'); c++)
+    {
+        if (number <= (Sint64)INT_MAX + 1)number = (number * 10) + (*c - '0');
+    }
+    if (*c == 0)
+    {
+        number *= sign;
+        if (number > INT_MAX)return INT_MAX;
+        if (number < INT_MIN)return INT_MIN;
+        return (int)number;
+    }
+    f = gfc_json_get_float(value,(float)defaultValue);
+    //converting a float that is out of range for an int is undefined
+    if (f != f)return defaultValue;
+    if (f >= (float)INT_MAX)return INT_MAX;
+    if (f <= (float)INT_MIN)return INT_MIN;
+    return (int)f;
+}
+
+Bool gfc_json_get_bool(GFC_JsonValue *value,Bool defaultValue)
+{
+    if ((!value)||(value->type != GJT_Bool))return defaultValue;
+    return value->boolean;
+}
+
+/*eol@eof*/
@@ -0,0 +1,194 @@
+#include <string.h>
+
+#include "gfc_lz4.h"
+
+#define GFC_LZ4_MINMATCH        4
+#define GFC_LZ4_LAST_LITERALS   5   /**<the format requires the last 5 bytes to be literals*/
+#define GFC_LZ4_MFLIMIT         12  /**<the last match must start at least 12 bytes before the end*/
+#define GFC_LZ4_MAX_OFFSET      65535
+#define GFC_LZ4_HASH_LOG        14
+#define GFC_LZ4_HASH_SIZE       (1 << GFC_LZ4_HASH_LOG)
+
+Uint32 gfc_lz4_read32(const Uint8 *p)
+{
+    Uint32 value;
+    memcpy(&value,p,sizeof(Uint32));
+    return value;
+}
+
+Uint32 gfc_lz4_hash(Uint32 sequence)
+{
+    return (sequence * 2654435761u) >> (32 - GFC_LZ4_HASH_LOG);
+}
+
+size_t gfc_lz4_compress_bound(size_t size)
+{
+    return size + (size / 255) + 16;
+}
+
+Uint8 *gfc_lz4_write_length(Uint8 *op,Uint8 *oend,size_t length)
+{
+    while (length >= 255)
+    {
+        if (op >= oend)return NULL;
+        *op++ = 255;
+        length -= 255;
+    }
+    if (op >= oend)return NULL;
+    *op++ = (Uint8)length;
+    return op;
+}
+
+Uint8 *gfc_lz4_write_sequence(
+    Uint8 *op,
+    Uint8 *oend,
+    const Uint8 *literals,
+    size_t literalLength,
+    Uint32 offset,
+    size_t matchLength)
+{
+    Uint8 *token;
+    if (op >= oend)return NULL;
+    token = op++;
+    if (literalLength >= 15)
+    {
+        *token = 15 << 4;
+        op = gfc_lz4_write_length(op,oend,literalLength - 15);
+        if (!op)return NULL;
+    }
+    else *token = (Uint8)(literalLength << 4);
+    if (op + literalLength > oend)return NULL;
+    memcpy(op,literals,literalLength);
+    op += literalLength;
+    if (!matchLength)return op;// the last sequence has no match
+    if (op + 2 > oend)return NULL;
+    *op++ = offset & 0xFF;
+    *op++ = (offset >> 8) & 0xFF;
+    matchLength -= GFC_LZ4_MINMATCH;
+    if (matchLength >= 15)
+    {
+        *token |= 15;
+        op = gfc_lz4_write_length(op,oend,matchLength - 15);
+    }
+    else *token |= (Uint8)matchLength;
+    return op;
+}
+
+size_t gfc_lz4_compress(const void *src,size_t srcSize,void *dst,size_t dstCapacity)
+{
+    Uint32 *table;
+    const Uint8 *base = (const Uint8 *)src;
+    const Uint8 *ip = base,*anchor = base,*ref;
+    const Uint8 *iend = base + srcSize;
+    const Uint8 *mflimit,*matchlimit;
+    Uint8 *op = (Uint8 *)dst,*oend = (Uint8 *)dst + dstCapacity;
+    size_t matchLength;
+    Uint32 h;
+    if ((!src)||(!dst))return 0;
+    table = gfc_allocate_array(sizeof(Uint32),GFC_LZ4_HASH_SIZE);
+    if (!table)return 0;
+    if (srcSize > GFC_LZ4_MFLIMIT)
+    {
+        mflimit = iend - GFC_LZ4_MFLIMIT;
+        matchlimit = iend - GFC_LZ4_LAST_LITERALS;
+        ip++;
+        while (ip < mflimit)
+        {
+            h = gfc_lz4_hash(gfc_lz4_read32(ip));
+            ref = base + table[h];
+            table[h] = (Uint32)(ip - base);
+            if ((ref >= ip)||((size_t)(ip - ref) > GFC_LZ4_MAX_OFFSET)||
+                (gfc_lz4_read32(ref) != gfc_lz4_read32(ip)))
+            {
+                ip++;
+                continue;
+            }
+            //grow the match backwards into the pending literals
+            while ((ip > anchor)&&(ref > base)&&(ip[-1] == ref[-1]))
+            {
+                ip--;
+                ref--;
+            }
+            matchLength = GFC_LZ4_MINMATCH;
+            while ((ip + matchLength < matchlimit)&&(ip[matchLength] == ref[matchLength]))matchLength++;
+            op = gfc_lz4_write_sequence(op,oend,anchor,ip - anchor,(Uint32)(ip - ref),matchLength);
+            if (!op)
+            {
+                free(table);
+                return 0;
+            }
+            ip += matchLength;
+            anchor = ip;
+            if (ip < mflimit)
+            {
+                //prime the table with the end of the match so runs are picked up
+                table[gfc_lz4_hash(gfc_lz4_read32(ip - 2))] = (Uint32)(ip - 2 - base);
+            }
+        }
+    }
+    free(table);
+    op = gfc_lz4_write_sequence(op,oend,anchor,iend - anchor,0,0);
+    if (!op)return 0;
+    return op - (Uint8 *)dst;
+}
+
+size_t gfc_lz4_decompress(const void *src,size_t srcSize,void *dst,size_t dstCapacity)
+{
+    const Uint8 *ip = (const Uint8 *)src,*iend = (const Uint8 *)src + srcSize;
+    Uint8 *op = (Uint8 *)dst,*oend = (Uint8 *)dst + dstCapacity;
+    const Uint8 *match;
+    size_t length,offset;
+    Uint8 token,extra;
+    if ((!src)||(!dst)||(!srcSize))return 0;
+    while (ip < iend)
+    {
+        token = *ip++;
+        length = token >> 4;
+        if (length == 15)
+        {
+            do
+            {
+                if (ip >= iend)return 0;
+                extra = *ip++;
+                length += extra;
+            }
+            while (extra == 255);
+        }
+        if ((length > (size_t)(iend - ip))||(length > (size_t)(oend - op)))return 0;
+        memcpy(op,ip,length);
+        op += length;
+        ip += length;
+        if (ip >= iend)break;// the last sequence is literals only
+        if (iend - ip < 2)return 0;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if ((!offset)||(offset > (size_t)(op - (Uint8 *)dst)))return 0;
+        length = token & 15;
+        if (length == 15)
+        {
+            do
+            {
+                if (ip >= iend)return 0;
+                extra = *ip++;
+                length += extra;
+            }
+            while (extra == 255);
+        }
+        length += GFC_LZ4_MINMATCH;
+        if (length > (size_t)(oend - op))return 0;
+        match = op - offset;
+        if (offset >= length)
+        {
+            memcpy(op,match,length);
+            op += length;
+        }
+        else
+        {
+            //overlapping copy, this is how runs are encoded
+            while (length--)*op++ = *match++;
+        }
+    }
+    return op - (Uint8 *)dst;
+}
+
+/*eol@eof*/
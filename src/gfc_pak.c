@@ -1,42 +1,406 @@
+#include <sys/stat.h>
+#include <ctype.h>
+#include <dirent.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
 #include "miniz.h"
 #include "simple_logger.h"
 #include "simple_json_parse.h"
 #include "gfc_text.h"
 #include "gfc_list.h"
+#include "gfc_hashmap.h"
+#include "gfc_arena.h"
+#include "gfc_lz4.h"
+#include "gfc_pak_index.h"
+#include "gfc_json_doc.h"
 #include "gfc_pak.h"
 
+#define GFC_PAK_MAX_MOUNT_THREADS   8
+#define GFC_PAK_LOCAL_HEADER_SIZE   30
+#define GFC_PAK_END_RECORD_SIZE     22
+#define GFC_PAK_MAX_COMMENT_SIZE    0xFFFF
+#define GFC_PAK_STREAM_CHUNK        65536
+#define GFC_PAK_PREFETCH_MEMORY_LIMIT   (64 * 1024 * 1024)
+
 typedef struct
 {
     TextLine filename;
-    mz_zip_archive zipFile;
+    GFC_PakIndex *index;    /**<lookup table for every entry in the pak*/
+    Uint8 *overrides;       /**<per index record flag, set if a loose copy of the entry was on disk when last scanned*/
+    SDL_mutex *readerLock;  /**<guards the reader pool*/
+    List *readers;          /**<idle FILE handles open on the pak.  Each extract borrows one so threads never share a file position*/
+    SDL_atomic_t refCount;  /**<the manager holds one reference, each extract in progress holds another*/
+    Uint64 sourceSize;      /**<size of the pak when it was indexed*/
+    Uint64 sourceTime;      /**<modification time of the pak when it was indexed*/
+    Uint64 sourceDevice;    /**<with sourceInode, which file was indexed.  Readers opened on any other file are refused*/
+    Uint64 sourceInode;
+    int fd;                 /**<kept open on the file that was indexed so new readers open that same file, -1 if not available*/
 }GFC_PakFile;
 
+typedef struct
+{
+    int wd;                 /**<inotify watch descriptor*/
+    TextBlock dir;          /**<the directory as it prefixes pak and entry names, empty for the working directory*/
+}GFC_PakWatch;
+
+typedef struct
+{
+    gfc_pak_change_func *func;
+    void *data;
+}GFC_PakSubscriber;
+
 typedef struct
 {
     List *pak_files;
+    GFC_PakOverridePolicy overridePolicy;
+    TextLine indexCacheDir; /**<where to cache the index of paks that do not have one embedded.  Empty to disable*/
+    SDL_mutex *lock;        /**<guards the pak list, the policy, override snapshots, watches and subscribers*/
+    int watchFd;            /**<inotify instance, -1 if not watching for changes*/
+    List *watches;          /**<GFC_PakWatch for each watched directory*/
+    List *subscribers;      /**<GFC_PakSubscriber to notify of changed files*/
+    SDL_atomic_t stale;     /**<set when an extract finds a pak changed under its index, the next update reloads it*/
 }GFC_PakManager;
 
-static GFC_PakManager pak_manager = {0};
+typedef struct
+{
+    GFC_PakFile *pakFile;           /**<the pak the file is extracted from, NULL if it is loose on disk*/
+    GFC_PakIndexRecord *record;     /**<the entry in the pak*/
+    size_t size;                    /**<how big the file is once extracted*/
+    Uint8 isOverride;               /**<set if a loose file is used in place of a pak entry*/
+}GFC_PakSource;
+
+typedef struct
+{
+    TextLine filename;
+    TextLine source;                /**<the pak the file came from, empty if it was loaded from disk*/
+    SDL_threadID threadId;
+    Uint8 isOverride;
+    Uint8 failed;
+    Uint64 start;                   /**<performance counter when the extract began*/
+    Uint64 lookupTicks;
+    Uint64 readTicks;
+    Uint64 inflateTicks;
+    Uint64 totalTicks;
+    Uint64 bytesRead;
+    Uint64 bytesInflated;
+}GFC_PakTraceEvent;
+
+typedef enum
+{
+    PFS_Queued,
+    PFS_Loading,
+    PFS_Ready
+}GFC_PakPrefetchState;
+
+typedef struct
+{
+    char *filename;
+    void *data;                     /**<the extracted file once ready, NULL if that failed*/
+    size_t size;
+    GFC_PakPrefetchState state;
+    Uint8 stale;                    /**<the file changed while it was loading, throw the result away*/
+}GFC_PakPrefetch;
+
+typedef struct
+{
+    SDL_mutex *lock;
+    SDL_cond *signal;               /**<signalled when work is queued, a file finishes loading or ready data is taken*/
+    SDL_Thread *thread;             /**<extracts queued files in the background*/
+    List *entries;                  /**<GFC_PakPrefetch, in the order requested*/
+    HashMap *map;                   /**<entries that are not stale, by lower case file name*/
+    SDL_atomic_t pending;           /**<how many entries are in the map, so extracts can skip the lock when there are none*/
+    size_t readyBytes;              /**<size of the loaded files waiting to be taken*/
+    size_t memoryLimit;             /**<the worker waits while readyBytes is at or above this*/
+    Uint8 quit;
+    SDL_atomic_t logging;           /**<set while recording an access log, read without the lock*/
+    List *log;                      /**<names of files extracted while logging, in order*/
+}GFC_PakPrefetchManager;
+
+typedef struct
+{
+    Uint8 enabled;
+    SDL_mutex *lock;
+    GFC_PakStats totals;            /**<times are kept in performance counter ticks until they are handed out*/
+    GFC_PakTraceEvent *events;      /**<every extract since the stats were last reset*/
+    Uint32 eventCount;
+    Uint32 eventSize;
+    Uint64 baseTicks;               /**<trace timestamps are relative to this*/
+}GFC_PakStatsManager;
+
+typedef struct
+{
+    const char **filenames;
+    GFC_PakFile **pakFiles;
+    Uint32 count;
+    SDL_atomic_t next;      /**<the next pak to be opened by a worker*/
+}GFC_PakMountJob;
+
+struct GFC_PakStream_S
+{
+    TextLine filename;
+    GFC_PakSource source;
+    GFC_PakTraceEvent eventData;
+    GFC_PakTraceEvent *event;       /**<NULL unless stats are enabled*/
+    FILE *file;                     /**<a reader borrowed from the pak for the life of the stream, or the loose file*/
+    Uint64 compRemaining;           /**<entry data not yet read from the file*/
+    size_t size;                    /**<size of the whole file*/
+    size_t remaining;               /**<bytes not yet handed to the caller*/
+    Uint32 crc;                     /**<running crc32 of what has been handed out, checked at the end*/
+    Uint8 checkCrc;
+    Uint8 failed;
+    Uint8 inflating;                /**<set if the entry is deflated and decoded as it is read*/
+    mz_stream inflater;
+    Uint8 *input;                   /**<compressed data waiting to be inflated*/
+    Uint8 *memory;                  /**<the whole file, for prefetched files and lz4 entries*/
+    size_t memoryPosition;
+};
+
+static GFC_PakManager pak_manager = {0,0,{0},0,-1};
+static GFC_PakStatsManager pak_stats = {0};
+static GFC_PakPrefetchManager pak_prefetch = {0};
 
 void gfc_pak_file_free(GFC_PakFile *pakFile);
+void gfc_pak_file_unref(GFC_PakFile *pakFile);
+void gfc_pak_manager_watch_pak(GFC_PakFile *pakFile);
+void gfc_pak_manager_watch_close();
+void gfc_pak_prefetch_close();
+void gfc_pak_prefetch_drop(const char *filename);
+void *gfc_pak_prefetch_take(const char *filename,size_t *fileSize);
+void gfc_pak_access_log_record(const char *filename);
+void gfc_pak_file_scan_overrides(GFC_PakFile *pakFile,HashMap *snapshot);
+void gfc_pak_override_snapshot_free(HashMap *snapshot);
 GFC_PakFile *gfc_pak_file_new();
+GFC_PakFile *gfc_pak_file_open(const char *filename);
+void *gfc_pak_load_file_from_disk(const char *filename,size_t *fileSize);
+Uint64 gfc_pak_get_mtime(struct stat *pakStat);
 
 
 void gfc_pak_manager_close()
 {
     //clear out all loaded pak files
+    gfc_pak_prefetch_close();
     if (pak_manager.pak_files)
     {
-        gfc_list_foreach(pak_manager.pak_files,(gfc_work_func*)gfc_pak_file_free);
+        gfc_list_foreach(pak_manager.pak_files,(gfc_work_func*)gfc_pak_file_unref);
         gfc_list_delete(pak_manager.pak_files);
     }
     pak_manager.pak_files = NULL;
+    gfc_pak_manager_watch_close();
+    if (pak_manager.subscribers)
+    {
+        gfc_list_foreach(pak_manager.subscribers,free);
+        gfc_list_delete(pak_manager.subscribers);
+        pak_manager.subscribers = NULL;
+    }
+    if (pak_manager.lock)
+    {
+        SDL_DestroyMutex(pak_manager.lock);
+        pak_manager.lock = NULL;
+    }
+    if (pak_stats.events)free(pak_stats.events);
+    if (pak_stats.lock)SDL_DestroyMutex(pak_stats.lock);
+    memset(&pak_stats,0,sizeof(GFC_PakStatsManager));
 }
 
 void gfc_pak_manager_init()
 {
     atexit(gfc_pak_manager_close);
     pak_manager.pak_files = gfc_list_new();
+    pak_manager.lock = SDL_CreateMutex();
+    pak_stats.lock = SDL_CreateMutex();
+    pak_prefetch.lock = SDL_CreateMutex();
+    pak_prefetch.memoryLimit = GFC_PAK_PREFETCH_MEMORY_LIMIT;
+    pak_prefetch.signal = SDL_CreateCond();
+    if ((!pak_manager.lock)||(!pak_stats.lock)||(!pak_prefetch.lock)||(!pak_prefetch.signal))
+    {
+        slog("failed to create pak manager lock: %s",SDL_GetError());
+    }
+}
+
+void gfc_pak_stats_enable(Bool enable)
+{
+    SDL_LockMutex(pak_stats.lock);
+    if ((enable)&&(!pak_stats.enabled)&&(!pak_stats.baseTicks))
+    {
+        pak_stats.baseTicks = SDL_GetPerformanceCounter();
+    }
+    pak_stats.enabled = enable ? 1 : 0;
+    SDL_UnlockMutex(pak_stats.lock);
+}
+
+void gfc_pak_stats_reset()
+{
+    SDL_LockMutex(pak_stats.lock);
+    memset(&pak_stats.totals,0,sizeof(GFC_PakStats));
+    pak_stats.eventCount = 0;
+    pak_stats.baseTicks = SDL_GetPerformanceCounter();
+    SDL_UnlockMutex(pak_stats.lock);
+}
+
+Uint64 gfc_pak_stats_ticks_to_us(Uint64 ticks)
+{
+    return (Uint64)((double)ticks * 1000000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+void gfc_pak_stats_convert_times(GFC_PakStats *stats)
+{
+    stats->lookupTime = gfc_pak_stats_ticks_to_us(stats->lookupTime);
+    stats->readTime = gfc_pak_stats_ticks_to_us(stats->readTime);
+    stats->inflateTime = gfc_pak_stats_ticks_to_us(stats->inflateTime);
+    stats->totalTime = gfc_pak_stats_ticks_to_us(stats->totalTime);
+}
+
+void gfc_pak_stats_add_event(GFC_PakStats *stats,GFC_PakTraceEvent *event)
+{
+    stats->extracts++;
+    if (event->failed)stats->failures++;
+    if (event->isOverride)stats->overrideHits++;
+    else if ((!event->failed)&&(!strlen(event->source)))stats->diskLoads++;
+    stats->bytesRead += event->bytesRead;
+    stats->bytesInflated += event->bytesInflated;
+    stats->lookupTime += event->lookupTicks;
+    stats->readTime += event->readTicks;
+    stats->inflateTime += event->inflateTicks;
+    stats->totalTime += event->totalTicks;
+}
+
+void gfc_pak_stats_get(GFC_PakStats *stats)
+{
+    if (!stats)return;
+    SDL_LockMutex(pak_stats.lock);
+    memcpy(stats,&pak_stats.totals,sizeof(GFC_PakStats));
+    SDL_UnlockMutex(pak_stats.lock);
+    gfc_pak_stats_convert_times(stats);
+}
+
+Bool gfc_pak_stats_get_file(const char *filename,GFC_PakStats *stats)
+{
+    Uint32 i;
+    if ((!filename)||(!stats))return false;
+    memset(stats,0,sizeof(GFC_PakStats));
+    SDL_LockMutex(pak_stats.lock);
+    for (i = 0; i < pak_stats.eventCount; i++)
+    {
+        if (gfc_pak_index_name_cmp(pak_stats.events[i].filename,filename) != 0)continue;
+        gfc_pak_stats_add_event(stats,&pak_stats.events[i]);
+    }
+    SDL_UnlockMutex(pak_stats.lock);
+    gfc_pak_stats_convert_times(stats);
+    return stats->extracts ? true : false;
+}
+
+void gfc_pak_stats_add_index_cache_hit()
+{
+    if (!pak_stats.enabled)return;
+    SDL_LockMutex(pak_stats.lock);
+    pak_stats.totals.indexCacheHits++;
+    SDL_UnlockMutex(pak_stats.lock);
+}
+
+GFC_PakTraceEvent *gfc_pak_stats_begin(GFC_PakTraceEvent *event,const char *filename)
+{
+    if (!pak_stats.enabled)return NULL;
+    memset(event,0,sizeof(GFC_PakTraceEvent));
+    gfc_line_cpy(event->filename,filename);
+    event->threadId = SDL_ThreadID();
+    event->start = SDL_GetPerformanceCounter();
+    return event;
+}
+
+void gfc_pak_stats_end(GFC_PakTraceEvent *event,int success)
+{
+    GFC_PakTraceEvent *events;
+    Uint32 size;
+    if (!event)return;
+    event->failed = success ? 0 : 1;
+    event->totalTicks = SDL_GetPerformanceCounter() - event->start;
+    SDL_LockMutex(pak_stats.lock);
+    gfc_pak_stats_add_event(&pak_stats.totals,event);
+    if (pak_stats.eventCount >= pak_stats.eventSize)
+    {
+        size = pak_stats.eventSize ? pak_stats.eventSize * 2 : 256;
+        events = realloc(pak_stats.events,sizeof(GFC_PakTraceEvent) * size);
+        if (!events)
+        {
+            SDL_UnlockMutex(pak_stats.lock);
+            return;
+        }
+        pak_stats.events = events;
+        pak_stats.eventSize = size;
+    }
+    memcpy(&pak_stats.events[pak_stats.eventCount++],event,sizeof(GFC_PakTraceEvent));
+    SDL_UnlockMutex(pak_stats.lock);
+}
+
+void gfc_pak_stats_write_string(FILE *file,const char *str)
+{
+    fputc('"',file);
+    for (;*str != 0; str++)
+    {
+        if ((*str == '"')||(*str == '\\'))fputc('\\',file);
+        if ((Uint8)*str < 0x20)continue;
+        fputc(*str,file);
+    }
+    fputc('"',file);
+}
+
+void gfc_pak_stats_write_phase(FILE *file,GFC_PakTraceEvent *event,const char *name,Uint64 start,Uint64 ticks)
+{
+    if (!ticks)return;
+    fprintf(file,",\n{\"name\":\"%s\",\"cat\":\"pak\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":%lu}",
+        name,
+        (unsigned long)gfc_pak_stats_ticks_to_us(start - pak_stats.baseTicks),
+        (unsigned long)gfc_pak_stats_ticks_to_us(ticks),
+        (unsigned long)event->threadId);
+}
+
+Bool gfc_pak_stats_save_trace(const char *filename)
+{
+    GFC_PakTraceEvent *event;
+    FILE *file;
+    Uint64 start;
+    Uint32 i;
+    if (!filename)return false;
+    file = fopen(filename,"w");
+    if (!file)
+    {
+        slog("failed to open trace file %s for writing",filename);
+        return false;
+    }
+    SDL_LockMutex(pak_stats.lock);
+    fprintf(file,"{\"traceEvents\":[");
+    for (i = 0; i < pak_stats.eventCount; i++)
+    {
+        event = &pak_stats.events[i];
+        //events before the last reset may still be in flight, keep them at the start of the timeline
+        start = MAX(event->start,pak_stats.baseTicks);
+        fprintf(file,"%s\n{\"name\":",i ? "," : "");
+        gfc_pak_stats_write_string(file,event->filename);
+        fprintf(file,",\"cat\":\"pak\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":%lu,\"args\":{\"source\":",
+            (unsigned long)gfc_pak_stats_ticks_to_us(start - pak_stats.baseTicks),
+            (unsigned long)gfc_pak_stats_ticks_to_us(event->totalTicks),
+            (unsigned long)event->threadId);
+        gfc_pak_stats_write_string(file,strlen(event->source) ? event->source : "disk");
+        fprintf(file,",\"bytesRead\":%lu,\"bytesInflated\":%lu,\"override\":%i,\"failed\":%i}}",
+            (unsigned long)event->bytesRead,
+            (unsigned long)event->bytesInflated,
+            event->isOverride,
+            event->failed);
+        gfc_pak_stats_write_phase(file,event,"lookup",start,event->lookupTicks);
+        start += event->lookupTicks;
+        gfc_pak_stats_write_phase(file,event,"read",start,event->readTicks);
+        start += event->readTicks;
+        gfc_pak_stats_write_phase(file,event,"inflate",start,event->inflateTicks);
+    }
+    fprintf(file,"\n],\"displayTimeUnit\":\"ms\"}\n");
+    SDL_UnlockMutex(pak_stats.lock);
+    fclose(file);
+    return true;
 }
 
 GFC_PakFile *gfc_pak_manager_get_by_filename(const char *filename)
@@ -63,115 +427,2134 @@ void gfc_pak_manager_add(const char *filename)
         slog("pak manager not initialized");
         return;
     }
+    SDL_LockMutex(pak_manager.lock);
     pakFile = gfc_pak_manager_get_by_filename(filename);
+    SDL_UnlockMutex(pak_manager.lock);
     if (pakFile)return;// already loaded
-    pakFile = gfc_pak_file_new();
-    if (!pakFile)
+    pakFile = gfc_pak_file_open(filename);
+    if (!pakFile)return;
+    SDL_LockMutex(pak_manager.lock);
+    if (gfc_pak_manager_get_by_filename(filename))
     {
-        slog("failed to allocate data for pak file");
+        //another thread added it while we were opening it
+        gfc_pak_file_free(pakFile);
+    }
+    else
+    {
+        gfc_list_append(pak_manager.pak_files,pakFile);
+        gfc_pak_manager_watch_pak(pakFile);
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+}
+
+int gfc_pak_mount_worker(void *data)
+{
+    GFC_PakMountJob *job = (GFC_PakMountJob *)data;
+    int i;
+    while ((i = SDL_AtomicAdd(&job->next,1)) < (int)job->count)
+    {
+        if (!job->filenames[i])continue;
+        job->pakFiles[i] = gfc_pak_file_open(job->filenames[i]);
+    }
+    return 0;
+}
+
+void gfc_pak_manager_add_many(const char **filenames,Uint32 count)
+{
+    GFC_PakMountJob job = {0};
+    SDL_Thread *threads[GFC_PAK_MAX_MOUNT_THREADS] = {0};
+    int threadCount,i;
+    Uint32 n;
+    if ((!filenames)||(!count))return;
+    if (!pak_manager.pak_files)
+    {
+        slog("pak manager not initialized");
         return;
     }
-    if (!mz_zip_reader_init_file(&pakFile->zipFile, filename, 0))
+    job.filenames = filenames;
+    job.count = count;
+    job.pakFiles = gfc_allocate_array(sizeof(GFC_PakFile *),count);
+    if (!job.pakFiles)return;
+    threadCount = MIN(SDL_GetCPUCount(),GFC_PAK_MAX_MOUNT_THREADS);
+    if (threadCount > (int)count)threadCount = count;
+    //this thread works too, so one fewer is spawned
+    for (i = 0; i < threadCount - 1; i++)
     {
-        slog("loading of archive file %s failed.",filename);
-        gfc_pak_file_free(pakFile);
+        threads[i] = SDL_CreateThread(gfc_pak_mount_worker,"gfc_pak_mount",&job);
+    }
+    gfc_pak_mount_worker(&job);
+    for (i = 0; i < threadCount - 1; i++)
+    {
+        if (threads[i])SDL_WaitThread(threads[i],NULL);
+    }
+    //register in the order given so search priority does not depend on which pak opened first
+    SDL_LockMutex(pak_manager.lock);
+    for (n = 0; n < count; n++)
+    {
+        if (!job.pakFiles[n])continue;
+        if (gfc_pak_manager_get_by_filename(job.pakFiles[n]->filename))
+        {
+            gfc_pak_file_free(job.pakFiles[n]);
+            continue;
+        }
+        gfc_list_append(pak_manager.pak_files,job.pakFiles[n]);
+        gfc_pak_manager_watch_pak(job.pakFiles[n]);
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    free(job.pakFiles);
+}
+
+void gfc_pak_manager_set_index_cache_dir(const char *dir)
+{
+    if (!dir)
+    {
+        gfc_line_clear(pak_manager.indexCacheDir);
+        return;
+    }
+    gfc_line_cpy(pak_manager.indexCacheDir,dir);
+}
+
+void gfc_pak_manager_set_override_policy(GFC_PakOverridePolicy policy)
+{
+    int i,c;
+    GFC_PakFile *pakFile;
+    HashMap *snapshot;
+    SDL_LockMutex(pak_manager.lock);
+    if (pak_manager.overridePolicy == policy)
+    {
+        SDL_UnlockMutex(pak_manager.lock);
         return;
     }
-    gfc_list_append(pak_manager.pak_files,pakFile);
+    pak_manager.overridePolicy = policy;
+    if (policy == POP_DiskFirst)
+    {
+        //any pak added under another policy was never scanned
+        snapshot = gfc_hashmap_new();
+        c = gfc_list_get_count(pak_manager.pak_files);
+        for (i = 0; i < c; i++)
+        {
+            pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+            if ((!pakFile)||(pakFile->overrides))continue;
+            gfc_pak_file_scan_overrides(pakFile,snapshot);
+        }
+        gfc_pak_override_snapshot_free(snapshot);
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+}
+
+GFC_PakOverridePolicy gfc_pak_manager_get_override_policy()
+{
+    return pak_manager.overridePolicy;
+}
+
+void gfc_pak_manager_refresh_overrides()
+{
+    int i,c;
+    GFC_PakFile *pakFile;
+    HashMap *snapshot;
+    snapshot = gfc_hashmap_new();
+    SDL_LockMutex(pak_manager.lock);
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i < c; i++)
+    {
+        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+        if (!pakFile)continue;
+        gfc_pak_file_scan_overrides(pakFile,snapshot);
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    gfc_pak_override_snapshot_free(snapshot);
 }
 
 void gfc_pak_file_free(GFC_PakFile *pakFile)
 {
+    int i,c;
     if (!pakFile)return;
-    mz_zip_reader_end(&pakFile->zipFile);
+    if (pakFile->readers)
+    {
+        c = gfc_list_get_count(pakFile->readers);
+        for (i = 0; i < c; i++)
+        {
+            fclose((FILE *)gfc_list_get_nth(pakFile->readers,i));
+        }
+        gfc_list_delete(pakFile->readers);
+    }
+    if (pakFile->readerLock)SDL_DestroyMutex(pakFile->readerLock);
+#ifdef __linux__
+    if (pakFile->fd >= 0)close(pakFile->fd);
+#endif
+    gfc_pak_index_free(pakFile->index);
+    if (pakFile->overrides)free(pakFile->overrides);
     free(pakFile);
 }
 
-GFC_PakFile *gfc_pak_file_new()
+void gfc_pak_file_unref(GFC_PakFile *pakFile)
 {
-    return gfc_allocate_array(sizeof(GFC_PakFile),1);
+    if (!pakFile)return;
+    if (SDL_AtomicDecRef(&pakFile->refCount))gfc_pak_file_free(pakFile);
 }
 
-void *gfc_pak_load_file_from_disk(const char *filename,size_t *fileSize)
+void gfc_pak_file_get_read_path(GFC_PakFile *pakFile,TextLine path)
 {
-    long size;
-    void *data;
+#ifdef __linux__
+    //the descriptor names the file that was indexed, even after another has been renamed over the pak
+    if (pakFile->fd >= 0)
+    {
+        gfc_line_sprintf(path,"/proc/self/fd/%i",pakFile->fd);
+        return;
+    }
+#endif
+    gfc_line_cpy(path,pakFile->filename);
+}
+
+FILE *gfc_pak_file_open_reader(GFC_PakFile *pakFile)
+{
+    struct stat fileStat;
+    TextLine path;
     FILE *file;
-    if (!filename)return NULL;
-    file = fopen(filename,"r");
+    gfc_pak_file_get_read_path(pakFile,path);
+    file = fopen(path,"rb");
+    if (!file)
+    {
+        slog("failed to open pak file %s",pakFile->filename);
+        return NULL;
+    }
+    if ((fstat(fileno(file),&fileStat) != 0)||
+        ((Uint64)fileStat.st_dev != pakFile->sourceDevice)||
+        ((Uint64)fileStat.st_ino != pakFile->sourceInode)||
+        ((Uint64)fileStat.st_size != pakFile->sourceSize)||
+        (gfc_pak_get_mtime(&fileStat) != pakFile->sourceTime))
+    {
+        //the index no longer describes what is on disk, reading on would hand out the wrong data
+        slog("pak file %s has changed since it was indexed, it will be reloaded",pakFile->filename);
+        SDL_AtomicSet(&pak_manager.stale,1);
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+FILE *gfc_pak_file_get_reader(GFC_PakFile *pakFile)
+{
+    FILE *file = NULL;
+    Uint32 c;
+    SDL_LockMutex(pakFile->readerLock);
+    c = gfc_list_get_count(pakFile->readers);
+    if (c)
+    {
+        file = gfc_list_get_nth(pakFile->readers,c - 1);
+        gfc_list_delete_last(pakFile->readers);
+    }
+    SDL_UnlockMutex(pakFile->readerLock);
+    if (file)return file;
+    //every reader is busy on another thread, so open one more
+    return gfc_pak_file_open_reader(pakFile);
+}
+
+void gfc_pak_file_release_reader(GFC_PakFile *pakFile,FILE *file)
+{
+    if (!file)return;
+    SDL_LockMutex(pakFile->readerLock);
+    pakFile->readers = gfc_list_append(pakFile->readers,file);
+    SDL_UnlockMutex(pakFile->readerLock);
+}
+
+Uint16 gfc_pak_read_u16(const Uint8 *data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+Uint32 gfc_pak_read_u32(const Uint8 *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((Uint32)data[3] << 24);
+}
+
+Uint64 gfc_pak_read_data_offset(FILE *file,Uint64 localHeaderOffset)
+{
+    Uint8 header[GFC_PAK_LOCAL_HEADER_SIZE];
+    if (fseek(file,(long)localHeaderOffset,SEEK_SET) != 0)return 0;
+    if (fread(header,GFC_PAK_LOCAL_HEADER_SIZE,1,file) != 1)return 0;
+    if (gfc_pak_read_u32(header) != 0x04034b50)return 0;
+    return localHeaderOffset + GFC_PAK_LOCAL_HEADER_SIZE + gfc_pak_read_u16(&header[26]) + gfc_pak_read_u16(&header[28]);
+}
+
+GFC_PakIndex *gfc_pak_file_load_embedded_index(const char *filename)
+{
+    FILE *file;
+    Uint8 header[GFC_PAK_LOCAL_HEADER_SIZE];
+    char name[sizeof(GFC_PAK_INDEX_NAME)];
+    GFC_PakIndex *index;
+    Uint32 crc,size;
+    void *data;
+    file = fopen(filename,"rb");
     if (!file)return NULL;
-    size = get_file_Size(file);
-    if (!size)
+    //gfcpak writes the index as the first entry, stored, so it is right at the front
+    if ((fread(header,GFC_PAK_LOCAL_HEADER_SIZE,1,file) != 1)||
+        (gfc_pak_read_u32(header) != 0x04034b50)||
+        (gfc_pak_read_u16(&header[8]) != 0)||
+        (gfc_pak_read_u16(&header[26]) != strlen(GFC_PAK_INDEX_NAME))||
+        (gfc_pak_read_u32(&header[18]) != gfc_pak_read_u32(&header[22]))||
+        (fread(name,strlen(GFC_PAK_INDEX_NAME),1,file) != 1)||
+        (memcmp(name,GFC_PAK_INDEX_NAME,strlen(GFC_PAK_INDEX_NAME)) != 0)||
+        (fseek(file,gfc_pak_read_u16(&header[28]),SEEK_CUR) != 0))
     {
-        slog("file %s is empty",filename);
         fclose(file);
         return NULL;
     }
-    data = gfc_allocate_array(size + 1,1);
+    crc = gfc_pak_read_u32(&header[14]);
+    size = gfc_pak_read_u32(&header[18]);
+    data = gfc_allocate_array(size,1);
     if (!data)
     {
         fclose(file);
         return NULL;
     }
-    fread(data, size, 1, file);
-    if (fileSize)
+    if ((fread(data,size,1,file) != 1)||(mz_crc32(MZ_CRC32_INIT,data,size) != crc))
     {
-        *fileSize = size;
+        slog("pak %s has a corrupt index",filename);
+        free(data);
+        fclose(file);
+        return NULL;
     }
-    return data;
+    fclose(file);
+    index = gfc_pak_index_from_data(data,size);
+    if (!index)free(data);
+    return index;
 }
 
-SJson *gfc_pak_load_json(const char *filename)
+void gfc_pak_get_index_cache_path(const char *filename,TextBlock path)
 {
-    void *data;
-    SJson *json;
-    size_t fileSize;
-    data = gfc_pak_file_extract(filename,&fileSize);
-    if (!data)return NULL;
-    json = sj_parse_buffer(data,fileSize);
+    TextBlock name;
+    char *c;
+    gfc_block_cpy(name,filename);
+    for (c = name; *c != 0; c++)
+    {
+        if ((*c == '/')||(*c == '\\')||(*c == ':'))*c = '_';
+    }
+    gfc_block_sprintf(path,"%s/%s.gidx",pak_manager.indexCacheDir,name);
+}
+
+Uint64 gfc_pak_get_mtime(struct stat *pakStat)
+{
+    //nanoseconds where the platform has them, as a pak can be rebuilt within a second
+#if defined(__APPLE__)
+    return ((Uint64)pakStat->st_mtimespec.tv_sec * 1000000000) + pakStat->st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    return ((Uint64)pakStat->st_mtim.tv_sec * 1000000000) + pakStat->st_mtim.tv_nsec;
+#else
+    return (Uint64)pakStat->st_mtime * 1000000000;
+#endif
+}
+
+Uint32 gfc_pak_file_get_central_dir_crc(FILE *file,const Uint8 *tail,long tailSize,long fileSize)
+{
+    Uint8 *data;
+    Uint32 crc,dirSize,dirOffset;
+    long i;
+    for (i = tailSize - GFC_PAK_END_RECORD_SIZE; i >= 0; i--)
+    {
+        if (gfc_pak_read_u32(&tail[i]) == 0x06054b50)break;
+    }
+    if (i < 0)return 0;
+    crc = mz_crc32(MZ_CRC32_INIT,&tail[i],tailSize - i);
+    dirSize = gfc_pak_read_u32(&tail[i + 12]);
+    dirOffset = gfc_pak_read_u32(&tail[i + 16]);
+    if ((dirSize == 0xFFFFFFFF)||(dirOffset == 0xFFFFFFFF)||((Uint64)dirOffset + dirSize > (Uint64)fileSize))
+    {
+        return crc;//zip64, the end record alone has to do
+    }
+    data = malloc(dirSize);
+    if (!data)return 0;
+    if ((fseek(file,dirOffset,SEEK_SET) == 0)&&(fread(data,dirSize,1,file) == 1))
+    {
+        crc = mz_crc32(crc,data,dirSize);
+    }
+    else crc = 0;
     free(data);
-    return json;
+    return crc;
 }
 
-void *gfc_pak_file_extract(const char *filename,size_t *fileSize)
+/**
+ * @brief get the crc32 of the end record and central directory of a zip, which changes whenever any entry does
+ * @return 0 on error, the crc otherwise
+ */
+Uint32 gfc_pak_get_central_dir_crc(const char *filename)
 {
-    GFC_PakFile *pakFile = NULL;
-    mz_zip_archive_file_stat pStat = {0};
-    void *fileData;
-    int index;
-    int i,c;
-    if (!filename)return NULL;
-    //first we see if there is a local override to a pak file
-    fileData = gfc_pak_load_file_from_disk(filename,fileSize);
-    if (fileData)return fileData;
-    c = gfc_list_get_count(pak_manager.pak_files);
-    for (i = 0; i< c; i++)
+    FILE *file;
+    Uint8 *tail = NULL;
+    Uint32 crc = 0;
+    long fileSize,tailSize = 0;
+    file = fopen(filename,"rb");
+    if (!file)return 0;
+    if ((fseek(file,0,SEEK_END) == 0)&&((fileSize = ftell(file)) >= GFC_PAK_END_RECORD_SIZE))
     {
-        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
-        if (!pakFile)continue;
-        index = mz_zip_reader_locate_file(&pakFile->zipFile, filename, NULL, 0);
-        if (index == -1)continue;// not in this file
-        if (!mz_zip_reader_file_stat(&pakFile->zipFile, index, &pStat))
-        {
-            slog("failed to read archive for file %f",filename);
-            return NULL;
-        }
-        fileData = gfc_allocate_array(pStat.m_uncomp_size,1);
-        if (!fileData)
-        {
-            slog("failed to allocate data to extract file %f",filename);
-            return NULL;
-        }
-        if (!mz_zip_reader_extract_to_mem(&pakFile->zipFile, index, fileData, pStat.m_uncomp_size, 0))
-        {
-            slog("failed to extract file %f",filename);
-            free(fileData);
-            return NULL;
-        }
-        if (fileSize)*fileSize = pStat.m_uncomp_size;
-        return fileData;
+        //the end record is at the very end, unless the zip has a comment
+        tailSize = MIN(fileSize,GFC_PAK_END_RECORD_SIZE + GFC_PAK_MAX_COMMENT_SIZE);
+        tail = malloc(tailSize);
     }
-    //nope, couldn't find it
-    return NULL;
+    if ((tail)&&(fseek(file,fileSize - tailSize,SEEK_SET) == 0)&&(fread(tail,tailSize,1,file) == 1))
+    {
+        crc = gfc_pak_file_get_central_dir_crc(file,tail,tailSize,fileSize);
+    }
+    if (tail)free(tail);
+    fclose(file);
+    return crc;
 }
+
+GFC_PakIndex *gfc_pak_file_load_cached_index(const char *filename,struct stat *pakStat)
+{
+    TextBlock path;
+    GFC_PakIndex *index;
+    void *data;
+    size_t size = 0;
+    if (!strlen(pak_manager.indexCacheDir))return NULL;
+    gfc_pak_get_index_cache_path(filename,path);
+    data = gfc_pak_load_file_from_disk(path,&size);
+    if (!data)return NULL;
+    index = gfc_pak_index_from_data(data,size);
+    if (!index)
+    {
+        free(data);
+        return NULL;
+    }
+    if ((index->header->sourceSize != (Uint64)pakStat->st_size)||
+        (index->header->sourceTime != gfc_pak_get_mtime(pakStat))||
+        (!index->header->sourceCrc)||
+        (index->header->sourceCrc != gfc_pak_get_central_dir_crc(filename)))
+    {
+        //the pak has changed since the cache was written
+        gfc_pak_index_free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void gfc_pak_file_save_cached_index(GFC_PakFile *pakFile,struct stat *pakStat)
+{
+    TextBlock path;
+    FILE *file;
+    if ((!pakFile)||(!pakFile->index))return;
+    if (!strlen(pak_manager.indexCacheDir))return;
+    gfc_pak_get_index_cache_path(pakFile->filename,path);
+    pakFile->index->header->sourceSize = pakStat->st_size;
+    pakFile->index->header->sourceTime = gfc_pak_get_mtime(pakStat);
+    pakFile->index->header->sourceCrc = gfc_pak_get_central_dir_crc(pakFile->filename);
+    file = fopen(path,"wb");
+    if (!file)
+    {
+        slog("failed to write pak index cache %s",path);
+        return;
+    }
+    if (fwrite(pakFile->index->data,pakFile->index->size,1,file) != 1)
+    {
+        slog("failed to write pak index cache %s",path);
+    }
+    fclose(file);
+}
+
+GFC_PakIndex *gfc_pak_file_build_index(GFC_PakFile *pakFile)
+{
+    mz_zip_archive zipFile = {0};
+    mz_zip_archive_file_stat pStat;
+    GFC_PakIndexRecord record;
+    GFC_PakIndex *index;
+    TextLine path;
+    FILE *file;
+    Uint32 i,c,count = 0,namePoolSize = 0;
+    gfc_pak_file_get_read_path(pakFile,path);
+    if (!mz_zip_reader_init_file(&zipFile, path, 0))
+    {
+        slog("loading of archive file %s failed.",pakFile->filename);
+        return NULL;
+    }
+    file = fopen(path,"rb");
+    if (!file)
+    {
+        mz_zip_reader_end(&zipFile);
+        return NULL;
+    }
+    c = mz_zip_reader_get_num_files(&zipFile);
+    for (i = 0; i < c; i++)
+    {
+        if (!mz_zip_reader_file_stat(&zipFile,i,&pStat))continue;
+        if (pStat.m_is_directory)continue;
+        count++;
+        namePoolSize += strlen(pStat.m_filename) + 1;
+    }
+    index = gfc_pak_index_new(count,namePoolSize);
+    for (i = 0; (index)&&(i < c); i++)
+    {
+        if (!mz_zip_reader_file_stat(&zipFile,i,&pStat))continue;
+        if (pStat.m_is_directory)continue;
+        memset(&record,0,sizeof(GFC_PakIndexRecord));
+        //the local header is read now so extraction can go straight to the data
+        record.dataOffset = gfc_pak_read_data_offset(file,pStat.m_local_header_ofs);
+        if (!record.dataOffset)
+        {
+            slog("pak %s entry %s has a bad local header",pakFile->filename,pStat.m_filename);
+            continue;
+        }
+        record.method = pStat.m_method;
+        record.crc32 = pStat.m_crc32;
+        record.fileIndex = i;
+        record.compSize = pStat.m_comp_size;
+        record.uncompSize = pStat.m_uncomp_size;
+        gfc_pak_index_add(index,pStat.m_filename,&record);
+    }
+    fclose(file);
+    mz_zip_reader_end(&zipFile);
+    if (index)gfc_pak_index_finalize(index);
+    return index;
+}
+
+Bool gfc_pak_index_has_offsets(GFC_PakIndex *index)
+{
+    Uint32 i;
+    for (i = 0; i < index->header->entryCount; i++)
+    {
+        if (!index->records[i].dataOffset)return false;
+    }
+    return true;
+}
+
+GFC_PakFile *gfc_pak_file_open(const char *filename)
+{
+    GFC_PakFile *pakFile;
+    struct stat pakStat;
+    TextLine path;
+    if (!filename)return NULL;
+    if (stat(filename,&pakStat) != 0)
+    {
+        slog("pak file %s not found",filename);
+        return NULL;
+    }
+    pakFile = gfc_pak_file_new();
+    if (!pakFile)
+    {
+        slog("failed to allocate data for pak file");
+        return NULL;
+    }
+    gfc_line_cpy(pakFile->filename,filename);
+    SDL_AtomicSet(&pakFile->refCount,1);
+#ifdef __linux__
+    //hold on to the file being indexed, so a pak rewritten and renamed into place is never read through this index
+    pakFile->fd = open(filename,O_RDONLY|O_CLOEXEC);
+    if ((pakFile->fd >= 0)&&((fstat(pakFile->fd,&pakStat) != 0)||(access("/proc/self/fd",F_OK) != 0)))
+    {
+        close(pakFile->fd);
+        pakFile->fd = -1;
+    }
+#endif
+    pakFile->sourceSize = pakStat.st_size;
+    pakFile->sourceTime = gfc_pak_get_mtime(&pakStat);
+    pakFile->sourceDevice = pakStat.st_dev;
+    pakFile->sourceInode = pakStat.st_ino;
+    gfc_pak_file_get_read_path(pakFile,path);
+    pakFile->readerLock = SDL_CreateMutex();
+    pakFile->readers = gfc_list_new();
+    if ((!pakFile->readerLock)||(!pakFile->readers))
+    {
+        gfc_pak_file_free(pakFile);
+        return NULL;
+    }
+    //prefer an index that does not need the central directory to be parsed
+    pakFile->index = gfc_pak_file_load_embedded_index(path);
+    if (!pakFile->index)
+    {
+        pakFile->index = gfc_pak_file_load_cached_index(filename,&pakStat);
+        if (pakFile->index)gfc_pak_stats_add_index_cache_hit();
+    }
+    if ((pakFile->index)&&(!gfc_pak_index_has_offsets(pakFile->index)))
+    {
+        //written by an older tool, rebuild it so every entry can be read directly
+        gfc_pak_index_free(pakFile->index);
+        pakFile->index = NULL;
+    }
+    if ((pakFile->index)&&(!gfc_pak_index_check_bounds(pakFile->index,pakFile->sourceSize)))
+    {
+        slog("pak %s has an index that does not match its contents, rebuilding it",filename);
+        gfc_pak_index_free(pakFile->index);
+        pakFile->index = NULL;
+    }
+    if (!pakFile->index)
+    {
+        pakFile->index = gfc_pak_file_build_index(pakFile);
+        if ((pakFile->index)&&(!gfc_pak_index_check_bounds(pakFile->index,pakFile->sourceSize)))
+        {
+            slog("pak %s has entries that run past the end of the file",filename);
+            gfc_pak_index_free(pakFile->index);
+            pakFile->index = NULL;
+        }
+        if (!pakFile->index)
+        {
+            gfc_pak_file_free(pakFile);
+            return NULL;
+        }
+        gfc_pak_file_save_cached_index(pakFile,&pakStat);
+    }
+    if (pak_manager.overridePolicy == POP_DiskFirst)
+    {
+        gfc_pak_file_scan_overrides(pakFile,NULL);
+    }
+    return pakFile;
+}
+
+Bool gfc_pak_override_is_file(const char *path)
+{
+    struct stat fileStat;
+    if (stat(path,&fileStat) != 0)return false;
+    return S_ISREG(fileStat.st_mode);
+}
+
+void gfc_pak_override_snapshot_free(HashMap *snapshot)
+{
+    HashElement *element;
+    List *dirs;
+    int i,c;
+    if (!snapshot)return;
+    dirs = gfc_hashmap_get_all_values(snapshot);
+    c = gfc_list_get_count(dirs);
+    for (i = 0; i < c; i++)
+    {
+        element = gfc_list_get_nth(dirs,i);
+        if (element)gfc_hashmap_free(element->data);
+    }
+    gfc_list_delete(dirs);
+    gfc_hashmap_free(snapshot);
+}
+
+/**
+ * @brief get the regular files in a directory from a snapshot, reading the directory the first time it is asked for
+ * @param snapshot HashMap of directory to a HashMap of the names of the files in it
+ * @param dir the directory, "." for the working directory
+ * @return NULL on error, the names otherwise.  Empty if the directory does not exist
+ */
+HashMap *gfc_pak_override_get_dir(HashMap *snapshot,const char *dir)
+{
+    HashMap *names;
+    DIR *handle;
+    struct dirent *entry;
+    TextLine path;
+    names = gfc_hashmap_get(snapshot,dir);
+    if (names)return names;
+    names = gfc_hashmap_new();
+    if (!names)return NULL;
+    gfc_hashmap_insert(snapshot,dir,names);
+    handle = opendir(dir);
+    if (!handle)return names;
+    while ((entry = readdir(handle)) != NULL)
+    {
+        if (strlen(entry->d_name) >= GFCLINELEN)continue;
+#ifdef _DIRENT_HAVE_D_TYPE
+        if ((entry->d_type != DT_REG)&&(entry->d_type != DT_LNK)&&(entry->d_type != DT_UNKNOWN))continue;
+        if (entry->d_type != DT_REG)
+#endif
+        {
+            //only the type is needed, which readdir does not always give
+            gfc_line_sprintf(path,"%s/%s",dir,entry->d_name);
+            if (!gfc_pak_override_is_file(path))continue;
+        }
+        gfc_hashmap_insert(names,entry->d_name,(void *)1);
+    }
+    closedir(handle);
+    return names;
+}
+
+Bool gfc_pak_override_exists(HashMap *snapshot,const char *name)
+{
+    TextLine dir;
+    HashMap *names;
+    const char *base;
+    base = strrchr(name,'/');
+    if (!base)
+    {
+        gfc_line_cpy(dir,".");
+        base = name;
+    }
+    else
+    {
+        if ((size_t)(base - name) >= GFCLINELEN)return gfc_pak_override_is_file(name);
+        if (base == name)gfc_line_cpy(dir,"/");
+        else
+        {
+            memcpy(dir,name,base - name);
+            dir[base - name] = 0;
+        }
+        base++;
+    }
+    if (strlen(base) >= GFCLINELEN)return gfc_pak_override_is_file(name);
+    names = gfc_pak_override_get_dir(snapshot,dir);
+    if (!names)return gfc_pak_override_is_file(name);
+    return gfc_hashmap_get(names,base) != NULL;
+}
+
+void gfc_pak_file_scan_overrides(GFC_PakFile *pakFile,HashMap *snapshot)
+{
+    const char *entryName;
+    HashMap *own = NULL;
+    Uint32 i,c;
+    if ((!pakFile)||(!pakFile->index))return;
+    if (pakFile->overrides)
+    {
+        free(pakFile->overrides);
+        pakFile->overrides = NULL;
+    }
+    c = pakFile->index->header->entryCount;
+    if (!c)return;
+    pakFile->overrides = gfc_allocate_array(sizeof(Uint8),c);
+    if (!pakFile->overrides)return;
+    //each directory is read once rather than every entry being looked for on its own
+    if (!snapshot)snapshot = own = gfc_hashmap_new();
+    for (i = 0; i < c; i++)
+    {
+        entryName = gfc_pak_index_get_name(pakFile->index,&pakFile->index->records[i]);
+        if (!entryName)continue;
+        if (snapshot)pakFile->overrides[i] = gfc_pak_override_exists(snapshot,entryName);
+        else pakFile->overrides[i] = gfc_pak_override_is_file(entryName);
+    }
+    gfc_pak_override_snapshot_free(own);
+}
+
+GFC_PakFile *gfc_pak_file_new()
+{
+    GFC_PakFile *pakFile;
+    pakFile = gfc_allocate_array(sizeof(GFC_PakFile),1);
+    if (pakFile)pakFile->fd = -1;
+    return pakFile;
+}
+
+void *gfc_pak_load_file_from_disk(const char *filename,size_t *fileSize)
+{
+    long size;
+    void *data;
+    FILE *file;
+    if (!filename)return NULL;
+    file = fopen(filename,"rb");
+    if (!file)return NULL;
+    if ((fseek(file, 0, SEEK_END) != 0)||((size = ftell(file)) < 0))
+    {
+        slog("failed to get the size of file %s",filename);
+        fclose(file);
+        return NULL;
+    }
+    if (!size)
+    {
+        slog("file %s is empty",filename);
+        fclose(file);
+        return NULL;
+    }
+    rewind(file);
+    data = gfc_allocate_array(size + 1,1);
+    if (!data)
+    {
+        fclose(file);
+        return NULL;
+    }
+    if (fread(data, size, 1, file) != 1)
+    {
+        slog("failed to read file %s",filename);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    if (fileSize)
+    {
+        *fileSize = size;
+    }
+    return data;
+}
+
+size_t gfc_pak_decode_data(Uint16 method,const void *src,size_t srcSize,void *dst,size_t dstSize)
+{
+    size_t size;
+    if ((!src)||(!dst))return 0;
+    switch (method)
+    {
+        case 0:
+            if (srcSize > dstSize)return 0;
+            memcpy(dst,src,srcSize);
+            return srcSize;
+        case MZ_DEFLATED:
+            size = tinfl_decompress_mem_to_mem(dst,dstSize,src,srcSize,TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+            if (size == TINFL_DECOMPRESS_MEM_TO_MEM_FAILED)return 0;
+            return size;
+        case GFC_PAK_METHOD_LZ4:
+            return gfc_lz4_decompress(src,srcSize,dst,dstSize);
+    }
+    slog("unsupported pak compression method %i",method);
+    return 0;
+}
+
+int gfc_pak_file_read_entry(GFC_PakFile *pakFile,GFC_PakIndexRecord *record,const char *filename,void *buffer,GFC_PakTraceEvent *event)
+{
+    Uint64 inflateStart = 0;
+    FILE *file;
+    void *compressed = NULL;
+    void *target;
+    int read;
+    if ((record->method == 0)&&(record->compSize != record->uncompSize))
+    {
+        slog("pak entry %s has a bad size",filename);
+        return 0;
+    }
+    if (record->method != 0)
+    {
+        compressed = gfc_allocate_array(record->compSize,1);
+        if (!compressed)return 0;
+    }
+    //stored entries are read straight into the caller's buffer
+    target = compressed ? compressed : buffer;
+    file = gfc_pak_file_get_reader(pakFile);
+    if (!file)
+    {
+        if (compressed)free(compressed);
+        return 0;
+    }
+    read = (fseek(file,(long)record->dataOffset,SEEK_SET) == 0)&&
+        ((!record->compSize)||(fread(target,record->compSize,1,file) == 1));
+    gfc_pak_file_release_reader(pakFile,file);
+    if (!read)
+    {
+        slog("failed to read pak entry %s",filename);
+        if (compressed)free(compressed);
+        return 0;
+    }
+    if (event)event->bytesRead += record->compSize;
+    if (compressed)
+    {
+        //decoding happens after the reader is returned, so other threads can read while this one inflates
+        if (event)inflateStart = SDL_GetPerformanceCounter();
+        read = gfc_pak_decode_data(record->method,compressed,record->compSize,buffer,record->uncompSize) == record->uncompSize;
+        if (event)
+        {
+            event->inflateTicks += SDL_GetPerformanceCounter() - inflateStart;
+            event->bytesInflated += record->uncompSize;
+        }
+        free(compressed);
+        if (!read)
+        {
+            slog("failed to extract file %s",filename);
+            return 0;
+        }
+    }
+    if (mz_crc32(MZ_CRC32_INIT,buffer,record->uncompSize) != record->crc32)
+    {
+        slog("crc check failed for pak entry %s",filename);
+        return 0;
+    }
+    return 1;
+}
+
+SJson *gfc_pak_load_json(const char *filename)
+{
+    void *data;
+    SJson *json;
+    size_t fileSize;
+    data = gfc_pak_file_extract(filename,&fileSize);
+    if (!data)return NULL;
+    json = sj_parse_buffer(data,fileSize);
+    free(data);
+    return json;
+}
+
+int gfc_pak_file_get_disk_source(const char *filename,GFC_PakSource *source)
+{
+    struct stat fileStat;
+    if (stat(filename,&fileStat) != 0)return 0;
+    if (!S_ISREG(fileStat.st_mode))return 0;
+    source->pakFile = NULL;
+    source->record = NULL;
+    source->size = fileStat.st_size;
+    source->isOverride = 0;
+    return 1;
+}
+
+int gfc_pak_file_find_source(const char *filename,GFC_PakSource *source)
+{
+    GFC_PakFile *pakFile = NULL;
+    GFC_PakIndexRecord *record;
+    GFC_PakOverridePolicy policy;
+    int i,c;
+    source->pakFile = NULL;
+    SDL_LockMutex(pak_manager.lock);
+    policy = pak_manager.overridePolicy;
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i< c; i++)
+    {
+        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+        if (!pakFile)continue;
+        record = gfc_pak_index_find(pakFile->index,filename);
+        if (!record)continue;// not in this file
+        if ((policy == POP_DiskFirst)&&(pakFile->overrides)&&
+            (pakFile->overrides[record - pakFile->index->records]))
+        {
+            //there was a local override to this pak file when we last looked
+            if (gfc_pak_file_get_disk_source(filename,source))
+            {
+                source->isOverride = 1;
+                SDL_UnlockMutex(pak_manager.lock);
+                return 1;
+            }
+        }
+        source->pakFile = pakFile;
+        source->record = record;
+        source->size = record->uncompSize;
+        source->isOverride = 0;
+        //keeps the pak alive if it is reloaded before this extract is done with it
+        SDL_AtomicIncRef(&pakFile->refCount);
+        SDL_UnlockMutex(pak_manager.lock);
+        return 1;
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    //not in any pak, but it may still be a loose file
+    if (policy == POP_PakOnly)return 0;
+    return gfc_pak_file_get_disk_source(filename,source);
+}
+
+void gfc_pak_source_release(GFC_PakSource *source)
+{
+    gfc_pak_file_unref(source->pakFile);
+    source->pakFile = NULL;
+    source->record = NULL;
+}
+
+int gfc_pak_file_read_from_disk(const char *filename,void *buffer,size_t size)
+{
+    FILE *file;
+    file = fopen(filename,"rb");
+    if (!file)
+    {
+        slog("failed to open file %s",filename);
+        return 0;
+    }
+    if ((size)&&(fread(buffer, size, 1, file) != 1))
+    {
+        slog("failed to read file %s",filename);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    return 1;
+}
+
+int gfc_pak_file_find_source_traced(const char *filename,GFC_PakSource *source,GFC_PakTraceEvent *event)
+{
+    int found;
+    found = gfc_pak_file_find_source(filename,source);
+    if (!event)return found;
+    event->lookupTicks = SDL_GetPerformanceCounter() - event->start;
+    if (!found)return 0;
+    event->isOverride = source->isOverride;
+    if (source->pakFile)gfc_line_cpy(event->source,source->pakFile->filename);
+    return 1;
+}
+
+int gfc_pak_file_read_source(GFC_PakSource *source,const char *filename,void *buffer,GFC_PakTraceEvent *event)
+{
+    Uint64 start = 0;
+    int success;
+    if (event)start = SDL_GetPerformanceCounter();
+    if (!source->pakFile)
+    {
+        success = gfc_pak_file_read_from_disk(filename,buffer,source->size);
+        if (event)event->bytesRead += source->size;
+    }
+    else success = gfc_pak_file_read_entry(source->pakFile,source->record,filename,buffer,event);
+    if (event)event->readTicks += SDL_GetPerformanceCounter() - start - event->inflateTicks;
+    return success;
+}
+
+void gfc_pak_file_extract_end(GFC_PakSource *source,GFC_PakTraceEvent *event,int success)
+{
+    gfc_pak_source_release(source);
+    gfc_pak_stats_end(event,success);
+}
+
+void *gfc_pak_file_extract_direct(const char *filename,size_t *fileSize)
+{
+    GFC_PakTraceEvent eventData,*event;
+    GFC_PakSource source;
+    void *fileData;
+    if (!filename)return NULL;
+    event = gfc_pak_stats_begin(&eventData,filename);
+    if (!gfc_pak_file_find_source_traced(filename,&source,event))
+    {
+        gfc_pak_stats_end(event,0);
+        return NULL;
+    }
+    fileData = gfc_allocate_array(source.size + 1,1);// the extra byte keeps text null terminated
+    if (!fileData)
+    {
+        slog("failed to allocate data to extract file %s",filename);
+        gfc_pak_file_extract_end(&source,event,0);
+        return NULL;
+    }
+    if (!gfc_pak_file_read_source(&source,filename,fileData,event))
+    {
+        free(fileData);
+        gfc_pak_file_extract_end(&source,event,0);
+        return NULL;
+    }
+    gfc_pak_file_extract_end(&source,event,1);
+    if (fileSize)*fileSize = source.size;
+    return fileData;
+}
+
+void *gfc_pak_file_extract(const char *filename,size_t *fileSize)
+{
+    void *fileData;
+    if (!filename)return NULL;
+    fileData = gfc_pak_prefetch_take(filename,fileSize);
+    if (!fileData)fileData = gfc_pak_file_extract_direct(filename,fileSize);
+    if (fileData)gfc_pak_access_log_record(filename);
+    return fileData;
+}
+
+GFC_PakStream *gfc_pak_stream_fail(GFC_PakStream *stream)
+{
+    stream->failed = 1;
+    gfc_pak_stream_close(stream);
+    return NULL;
+}
+
+GFC_PakStream *gfc_pak_stream_open(const char *filename)
+{
+    GFC_PakStream *stream;
+    GFC_PakIndexRecord *record;
+    if (!filename)return NULL;
+    stream = gfc_allocate_array(sizeof(GFC_PakStream),1);
+    if (!stream)return NULL;
+    gfc_line_cpy(stream->filename,filename);
+    stream->crc = MZ_CRC32_INIT;
+    stream->memory = gfc_pak_prefetch_take(filename,&stream->remaining);
+    if (stream->memory)
+    {
+        stream->size = stream->remaining;
+        gfc_pak_access_log_record(filename);
+        return stream;
+    }
+    stream->event = gfc_pak_stats_begin(&stream->eventData,filename);
+    if (!gfc_pak_file_find_source_traced(filename,&stream->source,stream->event))
+    {
+        gfc_pak_stats_end(stream->event,0);
+        free(stream);
+        return NULL;
+    }
+    stream->size = stream->remaining = stream->source.size;
+    record = stream->source.record;
+    if (!stream->source.pakFile)
+    {
+        stream->file = fopen(filename,"rb");
+        if (!stream->file)
+        {
+            slog("failed to open file %s",filename);
+            return gfc_pak_stream_fail(stream);
+        }
+    }
+    else if (record->method == GFC_PAK_METHOD_LZ4)
+    {
+        //lz4 entries are a single block, so they are decoded whole and handed out from memory
+        stream->memory = gfc_allocate_array(stream->source.size + 1,1);
+        if ((!stream->memory)||
+            (!gfc_pak_file_read_source(&stream->source,filename,stream->memory,stream->event)))
+        {
+            return gfc_pak_stream_fail(stream);
+        }
+    }
+    else
+    {
+        if (((record->method == 0)&&(record->compSize != record->uncompSize))||
+            ((record->method != 0)&&(record->method != MZ_DEFLATED)))
+        {
+            slog("pak entry %s cannot be streamed",filename);
+            return gfc_pak_stream_fail(stream);
+        }
+        stream->file = gfc_pak_file_get_reader(stream->source.pakFile);
+        if ((!stream->file)||(fseek(stream->file,(long)record->dataOffset,SEEK_SET) != 0))
+        {
+            slog("failed to read pak entry %s",filename);
+            return gfc_pak_stream_fail(stream);
+        }
+        stream->compRemaining = record->compSize;
+        stream->checkCrc = 1;
+        if (record->method == MZ_DEFLATED)
+        {
+            stream->input = gfc_allocate_array(GFC_PAK_STREAM_CHUNK,1);
+            if ((!stream->input)||(mz_inflateInit2(&stream->inflater,-MZ_DEFAULT_WINDOW_BITS) != MZ_OK))
+            {
+                return gfc_pak_stream_fail(stream);
+            }
+            stream->inflating = 1;
+        }
+    }
+    gfc_pak_access_log_record(filename);
+    return stream;
+}
+
+int gfc_pak_stream_inflate(GFC_PakStream *stream,void *buffer,size_t size)
+{
+    Uint64 start = 0;
+    size_t chunk;
+    int status;
+    stream->inflater.next_out = buffer;
+    stream->inflater.avail_out = size;
+    while (stream->inflater.avail_out)
+    {
+        if ((!stream->inflater.avail_in)&&(stream->compRemaining))
+        {
+            if (stream->event)start = SDL_GetPerformanceCounter();
+            chunk = MIN(stream->compRemaining,GFC_PAK_STREAM_CHUNK);
+            if (fread(stream->input,chunk,1,stream->file) != 1)return 0;
+            stream->compRemaining -= chunk;
+            stream->inflater.next_in = stream->input;
+            stream->inflater.avail_in = chunk;
+            if (stream->event)
+            {
+                stream->event->readTicks += SDL_GetPerformanceCounter() - start;
+                stream->event->bytesRead += chunk;
+            }
+        }
+        if (stream->event)start = SDL_GetPerformanceCounter();
+        status = mz_inflate(&stream->inflater,MZ_NO_FLUSH);
+        if (stream->event)stream->event->inflateTicks += SDL_GetPerformanceCounter() - start;
+        if (status == MZ_STREAM_END)break;
+        if (status != MZ_OK)return 0;
+    }
+    if (stream->event)stream->event->bytesInflated += size - stream->inflater.avail_out;
+    return stream->inflater.avail_out == 0;
+}
+
+size_t gfc_pak_stream_read(GFC_PakStream *stream,void *buffer,size_t size)
+{
+    Uint64 start = 0;
+    int success;
+    if ((!stream)||(!buffer)||(stream->failed))return 0;
+    size = MIN(size,stream->remaining);
+    if (!size)return 0;
+    if (stream->memory)
+    {
+        memcpy(buffer,stream->memory + stream->memoryPosition,size);
+        stream->memoryPosition += size;
+        success = 1;
+    }
+    else if (stream->inflating)success = gfc_pak_stream_inflate(stream,buffer,size);
+    else
+    {
+        if (stream->event)start = SDL_GetPerformanceCounter();
+        success = fread(buffer,size,1,stream->file) == 1;
+        if (stream->event)
+        {
+            stream->event->readTicks += SDL_GetPerformanceCounter() - start;
+            stream->event->bytesRead += size;
+        }
+    }
+    if (!success)
+    {
+        slog("failed to read %s",stream->filename);
+        stream->failed = 1;
+        return 0;
+    }
+    stream->remaining -= size;
+    if (stream->checkCrc)
+    {
+        stream->crc = mz_crc32(stream->crc,buffer,size);
+        if ((!stream->remaining)&&(stream->crc != stream->source.record->crc32))
+        {
+            slog("crc check failed for pak entry %s",stream->filename);
+            stream->failed = 1;
+        }
+    }
+    return size;
+}
+
+size_t gfc_pak_stream_get_size(GFC_PakStream *stream)
+{
+    if (!stream)return 0;
+    return stream->size;
+}
+
+Bool gfc_pak_stream_failed(GFC_PakStream *stream)
+{
+    if (!stream)return 1;
+    return stream->failed;
+}
+
+void gfc_pak_stream_close(GFC_PakStream *stream)
+{
+    if (!stream)return;
+    if (stream->inflating)mz_inflateEnd(&stream->inflater);
+    if (stream->file)
+    {
+        if (stream->source.pakFile)gfc_pak_file_release_reader(stream->source.pakFile,stream->file);
+        else fclose(stream->file);
+    }
+    if (stream->input)free(stream->input);
+    if (stream->memory)free(stream->memory);
+    gfc_pak_file_extract_end(&stream->source,stream->event,!stream->failed);
+    free(stream);
+}
+
+size_t gfc_pak_file_extract_into(const char *filename,void *buffer,size_t capacity)
+{
+    GFC_PakTraceEvent eventData,*event;
+    GFC_PakSource source;
+    void *fileData;
+    size_t size = 0;
+    if ((!filename)||(!buffer))return 0;
+    fileData = gfc_pak_prefetch_take(filename,&size);
+    if (fileData)
+    {
+        if (size > capacity)
+        {
+            slog("buffer of %lu bytes is too small to extract file %s of %lu bytes",
+                 (unsigned long)capacity,filename,(unsigned long)size);
+            free(fileData);
+            return 0;
+        }
+        memcpy(buffer,fileData,size);
+        free(fileData);
+        gfc_pak_access_log_record(filename);
+        return size;
+    }
+    event = gfc_pak_stats_begin(&eventData,filename);
+    if (!gfc_pak_file_find_source_traced(filename,&source,event))
+    {
+        gfc_pak_stats_end(event,0);
+        return 0;
+    }
+    if (source.size > capacity)
+    {
+        slog("buffer of %lu bytes is too small to extract file %s of %lu bytes",
+             (unsigned long)capacity,filename,(unsigned long)source.size);
+        gfc_pak_file_extract_end(&source,event,0);
+        return 0;
+    }
+    if (!gfc_pak_file_read_source(&source,filename,buffer,event))
+    {
+        gfc_pak_file_extract_end(&source,event,0);
+        return 0;
+    }
+    gfc_pak_file_extract_end(&source,event,1);
+    gfc_pak_access_log_record(filename);
+    return source.size;
+}
+
+void *gfc_pak_file_extract_arena(const char *filename,GFC_Arena *arena,size_t *fileSize)
+{
+    GFC_PakTraceEvent eventData,*event;
+    GFC_PakSource source;
+    Uint8 *fileData;
+    void *prefetched;
+    size_t size = 0;
+    if ((!filename)||(!arena))return NULL;
+    prefetched = gfc_pak_prefetch_take(filename,&size);
+    if (prefetched)
+    {
+        fileData = gfc_arena_alloc(arena,size + 1);
+        if (fileData)
+        {
+            memcpy(fileData,prefetched,size + 1);
+            if (fileSize)*fileSize = size;
+            gfc_pak_access_log_record(filename);
+        }
+        free(prefetched);
+        return fileData;
+    }
+    event = gfc_pak_stats_begin(&eventData,filename);
+    if (!gfc_pak_file_find_source_traced(filename,&source,event))
+    {
+        gfc_pak_stats_end(event,0);
+        return NULL;
+    }
+    fileData = gfc_arena_alloc(arena,source.size + 1);
+    if (!fileData)
+    {
+        slog("failed to allocate data to extract file %s",filename);
+        gfc_pak_file_extract_end(&source,event,0);
+        return NULL;
+    }
+    if (!gfc_pak_file_read_source(&source,filename,fileData,event))
+    {
+        gfc_pak_file_extract_end(&source,event,0);
+        return NULL;
+    }
+    gfc_pak_file_extract_end(&source,event,1);
+    gfc_pak_access_log_record(filename);
+    fileData[source.size] = 0;
+    if (fileSize)*fileSize = source.size;
+    return fileData;
+}
+
+Bool gfc_pak_file_exists(const char *filename)
+{
+    GFC_PakSource source;
+    if (!filename)return false;
+    if (!gfc_pak_file_find_source(filename,&source))return false;
+    gfc_pak_source_release(&source);
+    return true;
+}
+
+size_t gfc_pak_file_size(const char *filename)
+{
+    GFC_PakSource source;
+    if (!filename)return 0;
+    if (!gfc_pak_file_find_source(filename,&source))return 0;
+    gfc_pak_source_release(&source);
+    return source.size;
+}
+
+Bool gfc_pak_file_get_info(const char *filename,GFC_PakFileInfo *info)
+{
+    GFC_PakSource source;
+    struct stat fileStat;
+    if ((!filename)||(!info))return false;
+    memset(info,0,sizeof(GFC_PakFileInfo));
+    if (!gfc_pak_file_find_source(filename,&source))return false;
+    info->size = source.size;
+    if (source.pakFile)
+    {
+        info->crc = source.record->crc32;
+        info->inPak = true;
+    }
+    else if (stat(filename,&fileStat) == 0)
+    {
+        info->mtime = gfc_pak_get_mtime(&fileStat);
+    }
+    gfc_pak_source_release(&source);
+    return true;
+}
+
+Bool gfc_pak_manager_entry_is_hidden(int pakIndex,const char *name)
+{
+    GFC_PakFile *pakFile;
+    int i;
+    for (i = 0; i < pakIndex; i++)
+    {
+        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+        if (!pakFile)continue;
+        if (gfc_pak_index_find(pakFile->index,name))return true;
+    }
+    return false;
+}
+
+List *gfc_pak_list_dir(const char *prefix)
+{
+    GFC_PakFile *pakFile;
+    GFC_PakIndexRecord *record;
+    const char *name;
+    char *copy;
+    List *list;
+    Uint32 n,count;
+    int i,c;
+    if (!prefix)return NULL;
+    list = gfc_list_new();
+    if (!list)return NULL;
+    SDL_LockMutex(pak_manager.lock);
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i < c; i++)
+    {
+        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+        if (!pakFile)continue;
+        record = gfc_pak_index_find_prefix(pakFile->index,prefix,&count);
+        for (n = 0; n < count; n++)
+        {
+            name = gfc_pak_index_get_name(pakFile->index,&record[n]);
+            if (!name)continue;
+            //an earlier pak has a file by the same name that would be extracted instead
+            if (gfc_pak_manager_entry_is_hidden(i,name))continue;
+            //copied, as a reload frees the index the name is in
+            copy = malloc(record[n].nameLength + 1);
+            if (!copy)continue;
+            memcpy(copy,name,record[n].nameLength + 1);
+            list = gfc_list_append(list,copy);
+        }
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    return list;
+}
+void gfc_pak_manager_subscribe(gfc_pak_change_func *func,void *data)
+{
+    GFC_PakSubscriber *subscriber;
+    if (!func)return;
+    subscriber = gfc_allocate_array(sizeof(GFC_PakSubscriber),1);
+    if (!subscriber)return;
+    subscriber->func = func;
+    subscriber->data = data;
+    SDL_LockMutex(pak_manager.lock);
+    if (!pak_manager.subscribers)pak_manager.subscribers = gfc_list_new();
+    pak_manager.subscribers = gfc_list_append(pak_manager.subscribers,subscriber);
+    SDL_UnlockMutex(pak_manager.lock);
+}
+
+void gfc_pak_manager_unsubscribe(gfc_pak_change_func *func,void *data)
+{
+    GFC_PakSubscriber *subscriber;
+    int i,c;
+    SDL_LockMutex(pak_manager.lock);
+    c = gfc_list_get_count(pak_manager.subscribers);
+    for (i = 0; i < c; i++)
+    {
+        subscriber = gfc_list_get_nth(pak_manager.subscribers,i);
+        if (!subscriber)continue;
+        if ((subscriber->func != func)||(subscriber->data != data))continue;
+        gfc_list_delete_nth(pak_manager.subscribers,i);
+        free(subscriber);
+        break;
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+}
+
+void gfc_pak_manager_notify(const char *filename)
+{
+    GFC_PakSubscriber *subscriber,*subscribers = NULL;
+    int i,c = 0;
+    gfc_pak_prefetch_drop(filename);
+    //call a copy of the list without the lock held, so subscribers can extract files and subscribe or unsubscribe
+    SDL_LockMutex(pak_manager.lock);
+    c = gfc_list_get_count(pak_manager.subscribers);
+    if (c)subscribers = gfc_allocate_array(sizeof(GFC_PakSubscriber),c);
+    if (!subscribers)c = 0;
+    for (i = 0; i < c; i++)
+    {
+        subscriber = gfc_list_get_nth(pak_manager.subscribers,i);
+        if (subscriber)subscribers[i] = *subscriber;
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    for (i = 0; i < c; i++)
+    {
+        if (subscribers[i].func)subscribers[i].func(filename,subscribers[i].data);
+    }
+    if (subscribers)free(subscribers);
+}
+
+void gfc_pak_manager_update_override(const char *filename)
+{
+    GFC_PakFile *pakFile;
+    GFC_PakIndexRecord *record;
+    struct stat fileStat;
+    Uint8 isFile;
+    int i,c;
+    isFile = ((stat(filename,&fileStat) == 0)&&(S_ISREG(fileStat.st_mode)));
+    SDL_LockMutex(pak_manager.lock);
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i < c; i++)
+    {
+        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+        if ((!pakFile)||(!pakFile->overrides))continue;
+        record = gfc_pak_index_find(pakFile->index,filename);
+        if (!record)continue;
+        pakFile->overrides[record - pakFile->index->records] = isFile;
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+}
+
+int gfc_pak_record_differs(GFC_PakIndexRecord *a,GFC_PakIndexRecord *b)
+{
+    if ((!a)||(!b))return 1;
+    return (a->crc32 != b->crc32)||(a->uncompSize != b->uncompSize);
+}
+
+void gfc_pak_manager_reload_pak(GFC_PakFile *oldPak)
+{
+    GFC_PakFile *newPak;
+    GFC_PakIndexRecord *record;
+    const char *name;
+    List *changed;
+    Uint32 n;
+    int i;
+    newPak = gfc_pak_file_open(oldPak->filename);
+    if (!newPak)
+    {
+        slog("failed to reload pak file %s, keeping its old contents",oldPak->filename);
+        return;
+    }
+    //only the index is re-read, entry data is not touched until it is next extracted
+    changed = gfc_list_new();
+    for (n = 0; n < newPak->index->header->entryCount; n++)
+    {
+        record = &newPak->index->records[n];
+        name = gfc_pak_index_get_name(newPak->index,record);
+        if (!name)continue;
+        if (!gfc_pak_record_differs(record,gfc_pak_index_find(oldPak->index,name)))continue;
+        changed = gfc_list_append(changed,(void *)name);
+    }
+    for (n = 0; n < oldPak->index->header->entryCount; n++)
+    {
+        name = gfc_pak_index_get_name(oldPak->index,&oldPak->index->records[n]);
+        if ((!name)||(gfc_pak_index_find(newPak->index,name)))continue;
+        changed = gfc_list_append(changed,(void *)name);// removed from the pak
+    }
+    SDL_LockMutex(pak_manager.lock);
+    i = gfc_list_get_item_index(pak_manager.pak_files,oldPak);
+    if (i >= 0)
+    {
+        gfc_list_set_nth(pak_manager.pak_files,i,newPak);
+        gfc_pak_manager_watch_pak(newPak);
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    if (i < 0)
+    {
+        //it was unmounted in the mean time
+        gfc_list_delete(changed);
+        gfc_pak_file_unref(newPak);
+        return;
+    }
+    //extracts still reading the old pak keep it alive until they finish
+    gfc_pak_file_unref(oldPak);
+    for (n = 0; n < gfc_list_get_count(changed); n++)
+    {
+        gfc_pak_manager_notify(gfc_list_get_nth(changed,n));
+    }
+    gfc_list_delete(changed);
+}
+
+Bool gfc_pak_manager_reload(const char *filename)
+{
+    GFC_PakFile *pakFile;
+    if (!filename)return 0;
+    SDL_LockMutex(pak_manager.lock);
+    pakFile = gfc_pak_manager_get_by_filename(filename);
+    if (pakFile)SDL_AtomicIncRef(&pakFile->refCount);
+    SDL_UnlockMutex(pak_manager.lock);
+    if (!pakFile)return 0;
+    gfc_pak_manager_reload_pak(pakFile);
+    gfc_pak_file_unref(pakFile);
+    return 1;
+}
+
+void gfc_pak_manager_handle_change(const char *path)
+{
+    if (gfc_pak_manager_reload(path))return;
+    //a loose file, which may add, change or remove an override
+    gfc_pak_manager_update_override(path);
+    gfc_pak_manager_notify(path);
+}
+
+Bool gfc_pak_prefetch_get_key(const char *filename,TextLine key)
+{
+    int i;
+    //names longer than a hashmap key are not prefetched, they are just extracted when asked for
+    if (strlen(filename) >= GFCLINELEN)return false;
+    for (i = 0; filename[i] != 0; i++)
+    {
+        key[i] = tolower((Uint8)filename[i]);
+    }
+    key[i] = 0;
+    return true;
+}
+
+GFC_PakPrefetch *gfc_pak_prefetch_find(const char *filename)
+{
+    TextLine key;
+    if (!gfc_pak_prefetch_get_key(filename,key))return NULL;
+    return gfc_hashmap_get(pak_prefetch.map,key);
+}
+
+void gfc_pak_prefetch_free(GFC_PakPrefetch *entry)
+{
+    if (!entry)return;
+    if (entry->data)free(entry->data);
+    free(entry->filename);
+    free(entry);
+}
+
+void gfc_pak_prefetch_unmap(GFC_PakPrefetch *entry)
+{
+    TextLine key;
+    if (entry->stale)return;// already out of the map
+    if (gfc_pak_prefetch_get_key(entry->filename,key))gfc_hashmap_delete_by_key(pak_prefetch.map,key);
+    SDL_AtomicAdd(&pak_prefetch.pending,-1);
+}
+
+void gfc_pak_prefetch_remove(GFC_PakPrefetch *entry)
+{
+    gfc_pak_prefetch_unmap(entry);
+    if (entry->state == PFS_Ready)
+    {
+        pak_prefetch.readyBytes -= entry->size;
+        SDL_CondBroadcast(pak_prefetch.signal);// the worker may be waiting for room
+    }
+    gfc_list_delete_data(pak_prefetch.entries,entry);
+    gfc_pak_prefetch_free(entry);
+}
+
+int gfc_pak_prefetch_worker(void *data)
+{
+    GFC_PakPrefetch *entry;
+    void *fileData;
+    size_t size;
+    int i,c;
+    SDL_LockMutex(pak_prefetch.lock);
+    while (!pak_prefetch.quit)
+    {
+        entry = NULL;
+        //hold off until some of what is ready has been used
+        if ((!pak_prefetch.readyBytes)||(pak_prefetch.readyBytes < pak_prefetch.memoryLimit))
+        {
+            c = gfc_list_get_count(pak_prefetch.entries);
+            for (i = 0; i < c; i++)
+            {
+                entry = gfc_list_get_nth(pak_prefetch.entries,i);
+                if ((entry)&&(entry->state == PFS_Queued))break;
+                entry = NULL;
+            }
+        }
+        if (!entry)
+        {
+            SDL_CondWait(pak_prefetch.signal,pak_prefetch.lock);
+            continue;
+        }
+        entry->state = PFS_Loading;
+        SDL_UnlockMutex(pak_prefetch.lock);
+        size = 0;
+        fileData = gfc_pak_file_extract_direct(entry->filename,&size);
+        SDL_LockMutex(pak_prefetch.lock);
+        entry->data = fileData;
+        entry->size = fileData ? size : 0;
+        entry->state = PFS_Ready;
+        pak_prefetch.readyBytes += entry->size;
+        if (entry->stale)gfc_pak_prefetch_remove(entry);
+        SDL_CondBroadcast(pak_prefetch.signal);
+    }
+    SDL_UnlockMutex(pak_prefetch.lock);
+    return 0;
+}
+
+void gfc_pak_prefetch_clear()
+{
+    GFC_PakPrefetch *entry;
+    int i;
+    SDL_LockMutex(pak_prefetch.lock);
+    for (i = gfc_list_get_count(pak_prefetch.entries) - 1; i >= 0; i--)
+    {
+        entry = gfc_list_get_nth(pak_prefetch.entries,i);
+        if (!entry)continue;
+        if (entry->state == PFS_Loading)
+        {
+            gfc_pak_prefetch_unmap(entry);
+            entry->stale = 1;// the worker frees it when done
+            continue;
+        }
+        gfc_pak_prefetch_remove(entry);
+    }
+    SDL_UnlockMutex(pak_prefetch.lock);
+}
+
+void gfc_pak_prefetch_close()
+{
+    if (pak_prefetch.thread)
+    {
+        SDL_LockMutex(pak_prefetch.lock);
+        pak_prefetch.quit = 1;
+        SDL_CondBroadcast(pak_prefetch.signal);
+        SDL_UnlockMutex(pak_prefetch.lock);
+        SDL_WaitThread(pak_prefetch.thread,NULL);
+        pak_prefetch.thread = NULL;
+    }
+    gfc_pak_prefetch_clear();
+    gfc_list_delete(pak_prefetch.entries);
+    gfc_hashmap_free(pak_prefetch.map);
+    if (pak_prefetch.log)
+    {
+        gfc_list_foreach(pak_prefetch.log,free);
+        gfc_list_delete(pak_prefetch.log);
+    }
+    if (pak_prefetch.signal)SDL_DestroyCond(pak_prefetch.signal);
+    if (pak_prefetch.lock)SDL_DestroyMutex(pak_prefetch.lock);
+    memset(&pak_prefetch,0,sizeof(GFC_PakPrefetchManager));
+}
+
+void gfc_pak_prefetch_set_memory_limit(size_t bytes)
+{
+    SDL_LockMutex(pak_prefetch.lock);
+    pak_prefetch.memoryLimit = bytes ? bytes : GFC_PAK_PREFETCH_MEMORY_LIMIT;
+    SDL_CondBroadcast(pak_prefetch.signal);
+    SDL_UnlockMutex(pak_prefetch.lock);
+}
+
+void gfc_pak_prefetch_drop(const char *filename)
+{
+    GFC_PakPrefetch *entry;
+    if (!SDL_AtomicGet(&pak_prefetch.pending))return;
+    SDL_LockMutex(pak_prefetch.lock);
+    entry = gfc_pak_prefetch_find(filename);
+    if (entry)
+    {
+        if (entry->state == PFS_Loading)
+        {
+            gfc_pak_prefetch_unmap(entry);
+            entry->stale = 1;
+        }
+        else gfc_pak_prefetch_remove(entry);
+    }
+    SDL_UnlockMutex(pak_prefetch.lock);
+}
+
+void *gfc_pak_prefetch_take(const char *filename,size_t *fileSize)
+{
+    GFC_PakPrefetch *entry;
+    void *fileData = NULL;
+    //the usual case, nothing prefetched, costs no lock
+    if (!SDL_AtomicGet(&pak_prefetch.pending))return NULL;
+    SDL_LockMutex(pak_prefetch.lock);
+    entry = gfc_pak_prefetch_find(filename);
+    while ((entry)&&(entry->state == PFS_Loading))
+    {
+        //already on its way, waiting is cheaper than loading it again
+        SDL_CondWait(pak_prefetch.signal,pak_prefetch.lock);
+        entry = gfc_pak_prefetch_find(filename);
+    }
+    if (entry)
+    {
+        if (entry->state == PFS_Ready)
+        {
+            fileData = entry->data;
+            if ((fileData)&&(fileSize))*fileSize = entry->size;
+            entry->data = NULL;
+        }
+        //still queued means the caller got here first, it may as well load it itself
+        gfc_pak_prefetch_remove(entry);
+    }
+    SDL_UnlockMutex(pak_prefetch.lock);
+    return fileData;
+}
+
+void gfc_pak_prefetch_advise(const char *filename)
+{
+#ifdef __linux__
+    GFC_PakSource source;
+    FILE *file;
+    if (!gfc_pak_file_find_source(filename,&source))return;
+    if (source.pakFile)
+    {
+        file = gfc_pak_file_get_reader(source.pakFile);
+        if (file)
+        {
+            //start the kernel reading the entry in now, the background extract will find it in the page cache
+            posix_fadvise(fileno(file),(off_t)source.record->dataOffset,(off_t)source.record->compSize,POSIX_FADV_WILLNEED);
+            gfc_pak_file_release_reader(source.pakFile,file);
+        }
+    }
+    gfc_pak_source_release(&source);
+#endif
+}
+
+void gfc_pak_prefetch(List *filenames)
+{
+    GFC_PakPrefetch *entry;
+    const char *filename;
+    TextLine key;
+    int i,c;
+    if (!filenames)return;
+    if (!pak_prefetch.lock)
+    {
+        slog("pak manager not initialized");
+        return;
+    }
+    c = gfc_list_get_count(filenames);
+    for (i = 0; i < c; i++)
+    {
+        filename = gfc_list_get_nth(filenames,i);
+        if (filename)gfc_pak_prefetch_advise(filename);
+    }
+    SDL_LockMutex(pak_prefetch.lock);
+    if (!pak_prefetch.entries)pak_prefetch.entries = gfc_list_new();
+    if (!pak_prefetch.map)pak_prefetch.map = gfc_hashmap_new();
+    for (i = 0; i < c; i++)
+    {
+        filename = gfc_list_get_nth(filenames,i);
+        if ((!filename)||(!gfc_pak_prefetch_get_key(filename,key)))continue;
+        if (gfc_hashmap_get(pak_prefetch.map,key))continue;
+        entry = gfc_allocate_array(sizeof(GFC_PakPrefetch),1);
+        if (!entry)break;
+        entry->filename = malloc(strlen(filename) + 1);
+        if (!entry->filename)
+        {
+            free(entry);
+            break;
+        }
+        strcpy(entry->filename,filename);
+        pak_prefetch.entries = gfc_list_append(pak_prefetch.entries,entry);
+        gfc_hashmap_insert(pak_prefetch.map,key,entry);
+        SDL_AtomicAdd(&pak_prefetch.pending,1);
+    }
+    if (!pak_prefetch.thread)
+    {
+        pak_prefetch.thread = SDL_CreateThread(gfc_pak_prefetch_worker,"gfc_pak_prefetch",NULL);
+        if (!pak_prefetch.thread)slog("failed to start pak prefetch thread: %s",SDL_GetError());
+    }
+    SDL_CondBroadcast(pak_prefetch.signal);
+    SDL_UnlockMutex(pak_prefetch.lock);
+}
+
+void gfc_pak_prefetch_manifest(const char *filename)
+{
+    GFC_JsonDoc *doc;
+    GFC_JsonValue *files;
+    const char *name;
+    List *list;
+    Uint32 i,c;
+    doc = gfc_json_doc_load(filename);
+    if (!doc)
+    {
+        slog("failed to load prefetch manifest %s",filename);
+        return;
+    }
+    files = gfc_json_object_get(doc->root,"files");
+    c = gfc_json_get_count(files);
+    list = gfc_list_new_size(MAX(c,1));
+    for (i = 0; i < c; i++)
+    {
+        name = gfc_json_get_string(gfc_json_array_get_nth(files,i));
+        if (name)list = gfc_list_append(list,(void *)name);
+    }
+    gfc_pak_prefetch(list);
+    gfc_list_delete(list);
+    gfc_json_doc_free(doc);
+}
+
+void gfc_pak_access_log_begin()
+{
+    SDL_LockMutex(pak_prefetch.lock);
+    if (!pak_prefetch.log)pak_prefetch.log = gfc_list_new();
+    SDL_AtomicSet(&pak_prefetch.logging,1);
+    SDL_UnlockMutex(pak_prefetch.lock);
+}
+
+void gfc_pak_access_log_record(const char *filename)
+{
+    char *name;
+    if (!SDL_AtomicGet(&pak_prefetch.logging))return;
+    SDL_LockMutex(pak_prefetch.lock);
+    if (SDL_AtomicGet(&pak_prefetch.logging))
+    {
+        name = malloc(strlen(filename) + 1);
+        if (name)
+        {
+            strcpy(name,filename);
+            pak_prefetch.log = gfc_list_append(pak_prefetch.log,name);
+        }
+    }
+    SDL_UnlockMutex(pak_prefetch.lock);
+}
+
+typedef struct
+{
+    const char *name;
+    Uint32 order;
+}GFC_PakLogEntry;
+
+int gfc_pak_access_log_compare(const void *a,const void *b)
+{
+    const GFC_PakLogEntry *entryA = a,*entryB = b;
+    int result;
+    result = gfc_pak_index_name_cmp(entryA->name,entryB->name);
+    if (result)return result;
+    return (entryA->order < entryB->order) ? -1 : (entryA->order > entryB->order);
+}
+
+Bool gfc_pak_access_log_save(const char *filename)
+{
+    SJson *json,*files;
+    GFC_PakLogEntry *sorted;
+    Uint8 *repeated;
+    Uint32 i,c;
+    if (!filename)return false;
+    SDL_LockMutex(pak_prefetch.lock);
+    SDL_AtomicSet(&pak_prefetch.logging,0);
+    c = gfc_list_get_count(pak_prefetch.log);
+    sorted = gfc_allocate_array(sizeof(GFC_PakLogEntry),MAX(c,1));
+    repeated = gfc_allocate_array(sizeof(Uint8),MAX(c,1));
+    if ((!sorted)||(!repeated))
+    {
+        SDL_UnlockMutex(pak_prefetch.lock);
+        if (sorted)free(sorted);
+        if (repeated)free(repeated);
+        return false;
+    }
+    //only the first access to a file matters, find the repeats by sorting on name then order
+    for (i = 0; i < c; i++)
+    {
+        sorted[i].name = gfc_list_get_nth(pak_prefetch.log,i);
+        sorted[i].order = i;
+    }
+    qsort(sorted,c,sizeof(GFC_PakLogEntry),gfc_pak_access_log_compare);
+    for (i = 1; i < c; i++)
+    {
+        if (gfc_pak_index_name_cmp(sorted[i].name,sorted[i - 1].name) == 0)repeated[sorted[i].order] = 1;
+    }
+    json = sj_object_new();
+    files = sj_array_new();
+    for (i = 0; i < c; i++)
+    {
+        if (repeated[i])continue;
+        sj_array_append(files,sj_new_str(gfc_list_get_nth(pak_prefetch.log,i)));
+    }
+    gfc_list_foreach(pak_prefetch.log,free);
+    gfc_list_clear(pak_prefetch.log);
+    SDL_UnlockMutex(pak_prefetch.lock);
+    free(sorted);
+    free(repeated);
+    sj_object_insert(json,"files",files);
+    sj_save(json,filename);
+    sj_free(json);
+    return true;
+}
+void gfc_pak_manager_reload_changed()
+{
+    GFC_PakFile *pakFile;
+    struct stat pakStat;
+    List *changed;
+    char *filename;
+    int i,c;
+    changed = gfc_list_new();
+    SDL_LockMutex(pak_manager.lock);
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i < c; i++)
+    {
+        pakFile = gfc_list_get_nth(pak_manager.pak_files,i);
+        if (!pakFile)continue;
+        if ((stat(pakFile->filename,&pakStat) == 0)&&
+            ((Uint64)pakStat.st_size == pakFile->sourceSize)&&
+            (gfc_pak_get_mtime(&pakStat) == pakFile->sourceTime))continue;
+        filename = gfc_allocate_array(sizeof(TextLine),1);
+        if (!filename)continue;
+        gfc_line_cpy(filename,pakFile->filename);
+        changed = gfc_list_append(changed,filename);
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    c = gfc_list_get_count(changed);
+    for (i = 0; i < c; i++)
+    {
+        filename = gfc_list_get_nth(changed,i);
+        gfc_pak_manager_reload(filename);
+        free(filename);
+    }
+    gfc_list_delete(changed);
+}
+
+#ifdef __linux__
+
+#define GFC_PAK_WATCH_MASK (IN_CLOSE_WRITE|IN_MOVED_TO|IN_DELETE|IN_MOVED_FROM)
+
+GFC_PakWatch *gfc_pak_manager_get_watch(int wd)
+{
+    GFC_PakWatch *watch;
+    int i,c;
+    c = gfc_list_get_count(pak_manager.watches);
+    for (i = 0; i < c; i++)
+    {
+        watch = gfc_list_get_nth(pak_manager.watches,i);
+        if ((watch)&&(watch->wd == wd))return watch;
+    }
+    return NULL;
+}
+
+void gfc_pak_manager_add_watch(const char *dir)
+{
+    GFC_PakWatch *watch;
+    int i,c,wd;
+    c = gfc_list_get_count(pak_manager.watches);
+    for (i = 0; i < c; i++)
+    {
+        watch = gfc_list_get_nth(pak_manager.watches,i);
+        if ((watch)&&(gfc_block_cmp(watch->dir,dir) == 0))return;
+    }
+    wd = inotify_add_watch(pak_manager.watchFd,strlen(dir) ? dir : ".",GFC_PAK_WATCH_MASK);
+    if (wd < 0)return;// no such directory on disk, so nothing there to override
+    if (gfc_pak_manager_get_watch(wd))return;// the same directory by another name
+    watch = gfc_allocate_array(sizeof(GFC_PakWatch),1);
+    if (!watch)return;
+    watch->wd = wd;
+    gfc_block_cpy(watch->dir,dir);
+    pak_manager.watches = gfc_list_append(pak_manager.watches,watch);
+}
+
+void gfc_pak_manager_add_watch_for(const char *filename)
+{
+    TextBlock dir;
+    const char *slash;
+    slash = strrchr(filename,'/');
+    if (!slash)
+    {
+        gfc_pak_manager_add_watch("");
+        return;
+    }
+    if ((size_t)(slash - filename) >= GFCTEXTLEN)return;
+    memcpy(dir,filename,slash - filename);
+    dir[slash - filename] = 0;
+    gfc_pak_manager_add_watch(dir);
+}
+
+void gfc_pak_manager_watch_pak(GFC_PakFile *pakFile)
+{
+    const char *name,*lastName = NULL;
+    const char *slash;
+    size_t dirLength,lastDirLength = 0;
+    Uint32 n;
+    if ((pak_manager.watchFd < 0)||(!pakFile))return;
+    gfc_pak_manager_add_watch_for(pakFile->filename);
+    for (n = 0; n < pakFile->index->header->entryCount; n++)
+    {
+        name = gfc_pak_index_get_name(pakFile->index,&pakFile->index->records[n]);
+        if (!name)continue;
+        slash = strrchr(name,'/');
+        dirLength = slash ? (size_t)(slash - name) : 0;
+        //entries are sorted by name, so most share the directory of the one before
+        if ((lastName)&&(dirLength == lastDirLength)&&
+            (strncmp(name,lastName,dirLength) == 0))continue;
+        gfc_pak_manager_add_watch_for(name);
+        lastName = name;
+        lastDirLength = dirLength;
+    }
+}
+
+void gfc_pak_manager_watch_close()
+{
+    SDL_LockMutex(pak_manager.lock);
+    if (pak_manager.watchFd >= 0)close(pak_manager.watchFd);
+    pak_manager.watchFd = -1;
+    if (pak_manager.watches)
+    {
+        gfc_list_foreach(pak_manager.watches,free);
+        gfc_list_delete(pak_manager.watches);
+        pak_manager.watches = NULL;
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+}
+
+Bool gfc_pak_manager_watch(Bool enable)
+{
+    int i,c;
+    if (!enable)
+    {
+        gfc_pak_manager_watch_close();
+        return true;
+    }
+    SDL_LockMutex(pak_manager.lock);
+    if (pak_manager.watchFd >= 0)
+    {
+        SDL_UnlockMutex(pak_manager.lock);
+        return true;
+    }
+    pak_manager.watchFd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if (pak_manager.watchFd < 0)
+    {
+        SDL_UnlockMutex(pak_manager.lock);
+        slog("failed to start watching pak files: %s",strerror(errno));
+        return false;
+    }
+    pak_manager.watches = gfc_list_new();
+    c = gfc_list_get_count(pak_manager.pak_files);
+    for (i = 0; i < c; i++)
+    {
+        gfc_pak_manager_watch_pak(gfc_list_get_nth(pak_manager.pak_files,i));
+    }
+    SDL_UnlockMutex(pak_manager.lock);
+    return true;
+}
+
+void gfc_pak_manager_watch_dir(const char *dir)
+{
+    if (!dir)return;
+    SDL_LockMutex(pak_manager.lock);
+    if (pak_manager.watchFd >= 0)gfc_pak_manager_add_watch(dir);
+    SDL_UnlockMutex(pak_manager.lock);
+}
+
+
+void gfc_pak_manager_update()
+{
+    union
+    {
+        struct inotify_event event;
+        char data[4096];
+    }buffer;
+    const struct inotify_event *event;
+    GFC_PakWatch *watch;
+    List *changed;
+    char *path;
+    ssize_t length,offset;
+    Bool overflow = false;
+    int i,c;
+    if (SDL_AtomicCAS(&pak_manager.stale,1,0))gfc_pak_manager_reload_changed();
+    SDL_LockMutex(pak_manager.lock);
+    if (pak_manager.watchFd < 0)
+    {
+        SDL_UnlockMutex(pak_manager.lock);
+        return;
+    }
+    changed = gfc_list_new();
+    while ((length = read(pak_manager.watchFd,&buffer,sizeof(buffer))) > 0)
+    {
+        for (offset = 0; offset < length; offset += sizeof(struct inotify_event) + event->len)
+        {
+            event = (const struct inotify_event *)&buffer.data[offset];
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+            if ((!event->len)||(event->mask & IN_ISDIR))continue;
+            watch = gfc_pak_manager_get_watch(event->wd);
+            if (!watch)continue;
+            path = gfc_allocate_array(sizeof(TextBlock),1);
+            if (!path)continue;
+            if (strlen(watch->dir))gfc_block_sprintf(path,"%s/%s",watch->dir,event->name);
+            else gfc_block_cpy(path,event->name);
+            //saving a file usually produces several events, handle it once
+            c = gfc_list_get_count(changed);
+            for (i = 0; i < c; i++)
+            {
+                if (strcmp(gfc_list_get_nth(changed,i),path) == 0)break;
+            }
+            if (i < c)free(path);
+            else changed = gfc_list_append(changed,path);
+        }
+    }
+    //changes are handled without the lock, subscribers may extract files or add watches
+    SDL_UnlockMutex(pak_manager.lock);
+    if (overflow)
+    {
+        //events were lost, so any pak may have been rewritten and any override added or removed
+        slog("too many file changes at once, rescanning all paks and pak overrides");
+        gfc_pak_manager_reload_changed();
+        gfc_pak_manager_refresh_overrides();
+    }
+    c = gfc_list_get_count(changed);
+    for (i = 0; i < c; i++)
+    {
+        path = gfc_list_get_nth(changed,i);
+        gfc_pak_manager_handle_change(path);
+        free(path);
+    }
+    gfc_list_delete(changed);
+}
+
+#else
+
+void gfc_pak_manager_watch_pak(GFC_PakFile *pakFile)
+{
+}
+
+void gfc_pak_manager_watch_close()
+{
+}
+
+Bool gfc_pak_manager_watch(Bool enable)
+{
+    if (enable)slog("watching pak files for changes is not supported on this platform");
+    return false;
+}
+
+void gfc_pak_manager_watch_dir(const char *dir)
+{
+}
+
+void gfc_pak_manager_update()
+{
+    if (SDL_AtomicCAS(&pak_manager.stale,1,0))gfc_pak_manager_reload_changed();
+}
+
+#endif
 /*eol@eof*/
@@ -0,0 +1,347 @@
+#include <ctype.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_pak_index.h"
+
+Uint32 gfc_pak_index_hash(const char *name)
+{
+    Uint32 h = 2166136261u;//FNV-1a
+    const char *p;
+    if (!name)return 0;
+    for (p = name; *p != 0; p++)
+    {
+        h ^= (Uint8)tolower((Uint8)*p);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int gfc_pak_index_name_cmp(const char *a,const char *b)
+{
+    int ca,cb;
+    if ((!a)||(!b))return -1;
+    do
+    {
+        ca = tolower((Uint8)*a++);
+        cb = tolower((Uint8)*b++);
+    }
+    while ((ca)&&(ca == cb));
+    return ca - cb;
+}
+
+Uint32 gfc_pak_index_get_table_size(Uint32 entryCount)
+{
+    Uint32 size = 16;
+    while (size < entryCount * 2)size <<= 1;// keep the load factor at or below half
+    return size;
+}
+
+size_t gfc_pak_index_get_data_size(Uint32 entryCount,Uint32 namePoolSize)
+{
+    return sizeof(GFC_PakIndexHeader) +
+        (sizeof(GFC_PakIndexRecord) * entryCount) +
+        (sizeof(Uint32) * gfc_pak_index_get_table_size(entryCount)) +
+        namePoolSize;
+}
+
+void gfc_pak_index_setup_pointers(GFC_PakIndex *index)
+{
+    Uint8 *data;
+    if (!index)return;
+    data = index->data;
+    index->header = (GFC_PakIndexHeader *)data;
+    data += sizeof(GFC_PakIndexHeader);
+    index->records = (GFC_PakIndexRecord *)data;
+    data += sizeof(GFC_PakIndexRecord) * index->header->entryCount;
+    index->table = (Uint32 *)data;
+    data += sizeof(Uint32) * index->header->tableSize;
+    index->names = (char *)data;
+}
+
+GFC_PakIndex *gfc_pak_index_new(Uint32 entryCount,Uint32 namePoolSize)
+{
+    GFC_PakIndex *index;
+    index = gfc_allocate_array(sizeof(GFC_PakIndex),1);
+    if (!index)return NULL;
+    index->size = gfc_pak_index_get_data_size(entryCount,namePoolSize);
+    index->data = gfc_allocate_array(index->size,1);
+    if (!index->data)
+    {
+        free(index);
+        return NULL;
+    }
+    index->header = (GFC_PakIndexHeader *)index->data;
+    index->header->magic = GFC_PAK_INDEX_MAGIC;
+    index->header->version = GFC_PAK_INDEX_VERSION;
+    index->header->entryCount = entryCount;
+    index->header->tableSize = gfc_pak_index_get_table_size(entryCount);
+    index->header->namePoolSize = namePoolSize;
+    gfc_pak_index_setup_pointers(index);
+    return index;
+}
+
+void gfc_pak_index_free(GFC_PakIndex *index)
+{
+    if (!index)return;
+    if (index->data)free(index->data);
+    free(index);
+}
+
+GFC_PakIndexRecord *gfc_pak_index_add(GFC_PakIndex *index,const char *name,GFC_PakIndexRecord *record)
+{
+    GFC_PakIndexRecord *added;
+    size_t length;
+    if ((!index)||(!name)||(!record))return NULL;
+    length = strlen(name);
+    if (index->count >= index->header->entryCount)
+    {
+        slog("pak index is full, cannot add %s",name);
+        return NULL;
+    }
+    if ((length > 0xFFFF)||(index->nameUsed + length + 1 > index->header->namePoolSize))
+    {
+        slog("pak index name pool is full, cannot add %s",name);
+        return NULL;
+    }
+    added = &index->records[index->count++];
+    memcpy(added,record,sizeof(GFC_PakIndexRecord));
+    added->hash = gfc_pak_index_hash(name);
+    added->nameOffset = index->nameUsed;
+    added->nameLength = (Uint16)length;
+    memcpy(&index->names[index->nameUsed],name,length + 1);
+    index->nameUsed += length + 1;
+    return added;
+}
+
+void gfc_pak_index_sort(GFC_PakIndex *index)
+{
+    GFC_PakIndexRecord *scratch,*from,*to,*swap;
+    Uint32 width,left,mid,right,i,j,k,count;
+    count = index->count;
+    if (count < 2)return;
+    scratch = gfc_allocate_array(sizeof(GFC_PakIndexRecord),count);
+    if (!scratch)return;
+    //bottom up merge sort, keeps equal names in the order they were added
+    from = index->records;
+    to = scratch;
+    for (width = 1; width < count; width *= 2)
+    {
+        for (left = 0; left < count; left += 2 * width)
+        {
+            mid = MIN(left + width,count);
+            right = MIN(left + 2 * width,count);
+            i = left;
+            j = mid;
+            for (k = left; k < right; k++)
+            {
+                if ((i < mid)&&((j >= right)||
+                    (gfc_pak_index_name_cmp(&index->names[from[i].nameOffset],&index->names[from[j].nameOffset]) <= 0)))
+                {
+                    to[k] = from[i++];
+                }
+                else to[k] = from[j++];
+            }
+        }
+        swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != index->records)
+    {
+        memcpy(index->records,from,sizeof(GFC_PakIndexRecord) * count);
+    }
+    free(scratch);
+}
+
+/**
+ * @brief shrink an index to the records and names actually added, so the data size matches its header
+ */
+void gfc_pak_index_compact(GFC_PakIndex *index)
+{
+    void *data;
+    char *names;
+    if ((index->count == index->header->entryCount)&&(index->nameUsed == index->header->namePoolSize))return;
+    index->header->entryCount = index->count;
+    index->header->tableSize = gfc_pak_index_get_table_size(index->count);
+    index->header->namePoolSize = index->nameUsed;
+    //the new table is never bigger than the old one, so the names only ever move down
+    names = index->names;
+    gfc_pak_index_setup_pointers(index);
+    memmove(index->names,names,index->nameUsed);
+    index->size = gfc_pak_index_get_data_size(index->count,index->nameUsed);
+    data = realloc(index->data,index->size);
+    if (data)
+    {
+        index->data = data;
+        gfc_pak_index_setup_pointers(index);
+    }
+}
+
+void gfc_pak_index_finalize(GFC_PakIndex *index)
+{
+    Uint32 i,slot,mask;
+    if (!index)return;
+    gfc_pak_index_compact(index);
+    gfc_pak_index_sort(index);
+    mask = index->header->tableSize - 1;
+    memset(index->table,0,sizeof(Uint32) * index->header->tableSize);
+    for (i = 0; i < index->count; i++)
+    {
+        slot = index->records[i].hash & mask;
+        while (index->table[slot])slot = (slot + 1) & mask;
+        index->table[slot] = i + 1;
+    }
+}
+
+/**
+ * @brief check an index loaded from disk is internally consistent, once, so lookups can trust it
+ */
+Bool gfc_pak_index_validate(GFC_PakIndex *index)
+{
+    GFC_PakIndexRecord *record;
+    Uint32 i,entryCount,namePoolSize;
+    entryCount = index->header->entryCount;
+    namePoolSize = index->header->namePoolSize;
+    if ((namePoolSize)&&(index->names[namePoolSize - 1] != 0))return false;
+    for (i = 0; i < index->header->tableSize; i++)
+    {
+        if (index->table[i] > entryCount)return false;
+    }
+    for (i = 0; i < entryCount; i++)
+    {
+        record = &index->records[i];
+        if (((Uint64)record->nameOffset + record->nameLength) >= namePoolSize)return false;
+        if (index->names[record->nameOffset + record->nameLength] != 0)return false;
+    }
+    return true;
+}
+
+GFC_PakIndex *gfc_pak_index_from_data(void *data,size_t size)
+{
+    GFC_PakIndex *index;
+    GFC_PakIndexHeader *header;
+    if (!data)return NULL;
+    if (size < sizeof(GFC_PakIndexHeader))return NULL;
+    header = (GFC_PakIndexHeader *)data;
+    if (header->magic == GFC_PAK_INDEX_MAGIC_SWAPPED)
+    {
+        slog("pak index was built on a machine of the other byte order");
+        return NULL;
+    }
+    if ((header->magic != GFC_PAK_INDEX_MAGIC)||(header->version != GFC_PAK_INDEX_VERSION))
+    {
+        return NULL;
+    }
+    if ((!header->tableSize)||(header->tableSize & (header->tableSize - 1))||
+        (header->tableSize < header->entryCount))
+    {
+        slog("pak index has a bad hash table size");
+        return NULL;
+    }
+    if ((Uint64)size != sizeof(GFC_PakIndexHeader) + ((Uint64)sizeof(GFC_PakIndexRecord) * header->entryCount) +
+        ((Uint64)sizeof(Uint32) * header->tableSize) + header->namePoolSize)
+    {
+        slog("pak index data is the wrong size");
+        return NULL;
+    }
+    index = gfc_allocate_array(sizeof(GFC_PakIndex),1);
+    if (!index)return NULL;
+    index->data = data;
+    index->size = size;
+    gfc_pak_index_setup_pointers(index);
+    index->count = header->entryCount;
+    index->nameUsed = header->namePoolSize;
+    if (!gfc_pak_index_validate(index))
+    {
+        slog("pak index data is corrupt");
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+Bool gfc_pak_index_check_bounds(GFC_PakIndex *index,Uint64 pakSize)
+{
+    GFC_PakIndexRecord *record;
+    Uint32 i;
+    if ((!index)||(!index->header))return false;
+    for (i = 0; i < index->header->entryCount; i++)
+    {
+        record = &index->records[i];
+        if ((record->dataOffset > pakSize)||(record->compSize > pakSize - record->dataOffset))return false;
+        //stored data is read straight into the caller's buffer
+        if ((!record->method)&&(record->uncompSize != record->compSize))return false;
+    }
+    return true;
+}
+
+GFC_PakIndexRecord *gfc_pak_index_find(GFC_PakIndex *index,const char *name)
+{
+    GFC_PakIndexRecord *record;
+    Uint32 hash,slot,mask,probes;
+    if ((!index)||(!index->header)||(!name))return NULL;
+    hash = gfc_pak_index_hash(name);
+    mask = index->header->tableSize - 1;
+    slot = hash & mask;
+    for (probes = 0; probes < index->header->tableSize; probes++)
+    {
+        if (!index->table[slot])return NULL;
+        record = &index->records[index->table[slot] - 1];
+        if ((record->hash == hash)&&(gfc_pak_index_name_cmp(&index->names[record->nameOffset],name) == 0))
+        {
+            return record;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
+}
+
+int gfc_pak_index_prefix_cmp(const char *name,const char *prefix)
+{
+    int ca,cb;
+    for (;*prefix != 0;name++,prefix++)
+    {
+        ca = tolower((Uint8)*name);
+        cb = tolower((Uint8)*prefix);
+        if (ca != cb)return ca - cb;
+    }
+    return 0;
+}
+
+GFC_PakIndexRecord *gfc_pak_index_find_prefix(GFC_PakIndex *index,const char *prefix,Uint32 *count)
+{
+    Uint32 low,high,mid,first;
+    if (count)*count = 0;
+    if ((!index)||(!index->header)||(!prefix))return NULL;
+    //the records are sorted by name, so everything sharing the prefix is one run
+    low = 0;
+    high = index->header->entryCount;
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (gfc_pak_index_prefix_cmp(&index->names[index->records[mid].nameOffset],prefix) < 0)low = mid + 1;
+        else high = mid;
+    }
+    first = low;
+    high = index->header->entryCount;
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (gfc_pak_index_prefix_cmp(&index->names[index->records[mid].nameOffset],prefix) <= 0)low = mid + 1;
+        else high = mid;
+    }
+    if (low == first)return NULL;
+    if (count)*count = low - first;
+    return &index->records[first];
+}
+
+const char *gfc_pak_index_get_name(GFC_PakIndex *index,GFC_PakIndexRecord *record)
+{
+    if ((!index)||(!record))return NULL;
+    if (record->nameOffset >= index->header->namePoolSize)return NULL;
+    return &index->names[record->nameOffset];
+}
+
+/*eol@eof*/
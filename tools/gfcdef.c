@@ -0,0 +1,102 @@
+/**
+ * gfcdef
+ * @purpose compile config def json files ahead of time so gfc_config_def_load() can skip parsing them at startup.
+ * Run it from the directory the game runs from, with the def files named exactly as the game loads them,
+ * and point the game at the same cache directory with gfc_config_def_set_cache_dir().
+ * Files are read through gfc_pak, so only loose files are seen unless paks are given with -p.
+ * usage: gfcdef [-p pak]... <cache directory> <def file>...
+ *        gfcdef [-p pak]... -b <def file>...   times loading the files one at a time against gfc_config_def_load_many()
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_pak.h"
+#include "gfc_config_def.h"
+
+#define GFCDEF_BENCH_PASSES 5
+
+double gfcdef_bench_pass(const char **filenames,Uint32 count,Bool many)
+{
+    Uint64 start,ticks;
+    Uint32 i;
+    gfc_config_def_init();
+    start = SDL_GetPerformanceCounter();
+    if (many)gfc_config_def_load_many(filenames,count);
+    else
+    {
+        for (i = 0; i < count; i++)
+        {
+            gfc_config_def_load(filenames[i]);
+        }
+    }
+    ticks = SDL_GetPerformanceCounter() - start;
+    gfc_config_def_close();
+    return ((double)ticks / SDL_GetPerformanceFrequency()) * 1000.0;
+}
+
+int gfcdef_bench(const char **filenames,Uint32 count)
+{
+    const char *names[2] = {"load","load_many"};
+    double ms,best[2] = {0},total[2] = {0};
+    int pass,many;
+    //the first pass of each only warms the file cache
+    gfcdef_bench_pass(filenames,count,0);
+    gfcdef_bench_pass(filenames,count,1);
+    for (pass = 0; pass < GFCDEF_BENCH_PASSES; pass++)
+    {
+        for (many = 0; many < 2; many++)
+        {
+            ms = gfcdef_bench_pass(filenames,count,many);
+            total[many] += ms;
+            if ((!pass)||(ms < best[many]))best[many] = ms;
+        }
+    }
+    printf("%u files, %i passes, no cache\n",count,GFCDEF_BENCH_PASSES);
+    printf("%-10s %10s %10s\n","method","best ms","mean ms");
+    for (many = 0; many < 2; many++)
+    {
+        printf("%-10s %10.2f %10.2f\n",names[many],best[many],total[many] / GFCDEF_BENCH_PASSES);
+    }
+    if (best[1] > 0)printf("load_many is %.2fx as fast\n",best[0] / best[1]);
+    return 1;
+}
+
+void gfcdef_usage()
+{
+    printf("usage: gfcdef [-p pak]... <cache directory> <def file>...\n");
+    printf("       gfcdef [-p pak]... -b <def file>...\n");
+}
+
+int main(int argc,char *argv[])
+{
+    const char *cacheDir = NULL;
+    int i,failed = 0,compiled = 0;
+    gfc_pak_manager_init();
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i],"-p") == 0)&&(i + 1 < argc))gfc_pak_manager_add(argv[++i]);
+        else if ((!cacheDir)&&(strcmp(argv[i],"-b") == 0)&&(i + 1 < argc))
+        {
+            return gfcdef_bench((const char **)&argv[i + 1],argc - i - 1)?0:1;
+        }
+        else if (!cacheDir)
+        {
+            cacheDir = argv[i];
+            gfc_config_def_set_cache_dir(cacheDir);
+        }
+        else if (gfc_config_def_compile(argv[i]))compiled++;
+        else failed++;
+    }
+    if ((!cacheDir)||(!(compiled + failed)))
+    {
+        gfcdef_usage();
+        return 1;
+    }
+    printf("compiled %i def files into %s, %i failed\n",compiled,cacheDir,failed);
+    return failed?1:0;
+}
+
+/*eol@eof*/
@@ -0,0 +1,987 @@
+/**
+ * gfcpak
+ * @purpose pack a directory into a pak file laid out for fast loading with gfc_pak.
+ * The output is an ordinary zip file, but:
+ *  - the first entry is a pre-sorted, hashed index of every other entry (see gfc_pak_index.h)
+ *  - stored (uncompressed) entries of at least a page have their data aligned so they can be memory mapped
+ *  - each file is only compressed if it compresses well enough to be worth decoding at load time
+ *    deflate is used by default, or the faster to decode lz4 (a custom zip method, see GFC_PAK_METHOD_LZ4) with -c lz4
+ *  - files are written in load order, grouped by an optional json manifest:
+ *  {
+ *      "groups":[
+ *          {"name":"boot","files":["config/","images/ui/cursor.png"]},
+ *          {"name":"level1","files":["levels/level1/"]}
+ *      ]
+ *  }
+ *  file rules ending in '/' match everything under that directory.  Files not matched by any group are written last.
+ * usage: gfcpak [-m manifest.json] [-r ratio] [-a alignment] [-c deflate|lz4] <input directory> <output pak>
+ *        gfcpak -b <pak>   reports decode speed and load time of every entry in a pak
+ *        gfcpak -t <pak> <threads>   extracts and streams every entry from several threads while a copy of the pak is rewritten
+ *                                    with different content and reloaded, checking each crc
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "simple_logger.h"
+#include "simple_json.h"
+
+#include "miniz.h"
+
+#include "gfc_types.h"
+#include "gfc_text.h"
+#include "gfc_list.h"
+#include "gfc_lz4.h"
+#include "gfc_pak.h"
+#include "gfc_pak_index.h"
+
+#define GFCPAK_LOCAL_HEADER_SIZE    30
+#define GFCPAK_CENTRAL_HEADER_SIZE  46
+#define GFCPAK_END_RECORD_SIZE      22
+#define GFCPAK_ALIGN_EXTRA_ID       0xD935  /**<same extra field zipalign uses for padding*/
+#define GFCPAK_NO_RULE              0xFFFFFFFF
+#define GFCPAK_BENCH_PASSES         5
+#define GFCPAK_STRESS_ROUNDS        10      /**<times each thread goes through every entry*/
+#define GFCPAK_STRESS_MAX_THREADS   64
+#define GFCPAK_STRESS_CHUNK         4093    /**<an odd size so stream reads do not line up with the pak's own buffers*/
+
+typedef enum
+{
+    PBC_Deflate = 0,    /**<deflate or store*/
+    PBC_LZ4             /**<lz4 if it compresses well enough, otherwise deflate or store*/
+}PakBuildCodec;
+
+typedef struct
+{
+    TextBlock path;             /**<path relative to the input directory, as stored in the pak*/
+    Uint32 group;               /**<manifest group, or the group count if not in the manifest*/
+    Uint32 rule;                /**<which manifest rule matched, for ordering within a group*/
+    Uint16 method;
+    Uint32 crc32;
+    Uint64 compSize;
+    Uint64 uncompSize;
+    Uint64 headerOffset;
+    Uint64 dataOffset;
+}PakBuildEntry;
+
+typedef struct
+{
+    TextBlock rule;
+    Uint32 group;
+}PakBuildRule;
+
+typedef struct
+{
+    List   *entries;
+    List   *rules;
+    Uint32  groupCount;
+    float   ratio;              /**<deflate is only used if compressed size <= ratio * uncompressed size*/
+    Uint32  alignment;          /**<alignment of stored entry data*/
+    PakBuildCodec codec;        /**<preferred compression for entries*/
+    FILE   *file;
+    Uint64  offset;             /**<current write position*/
+}PakBuilder;
+
+static PakBuilder builder = {0};
+
+void gfcpak_put_u16(Uint8 *buffer,Uint16 value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+}
+
+void gfcpak_put_u32(Uint8 *buffer,Uint32 value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+    buffer[2] = (value >> 16) & 0xFF;
+    buffer[3] = (value >> 24) & 0xFF;
+}
+
+int gfcpak_write(const void *data,size_t size)
+{
+    if (!size)return 1;
+    if (fwrite(data,size,1,builder.file) != 1)
+    {
+        slog("failed to write to output pak");
+        return 0;
+    }
+    builder.offset += size;
+    return 1;
+}
+
+void *gfcpak_read_file(const char *filename,size_t *fileSize)
+{
+    FILE *file;
+    long size;
+    void *data;
+    file = fopen(filename,"rb");
+    if (!file)
+    {
+        slog("failed to open %s",filename);
+        return NULL;
+    }
+    fseek(file,0,SEEK_END);
+    size = ftell(file);
+    rewind(file);
+    if (size < 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+    data = malloc(size + 1);
+    if (!data)
+    {
+        fclose(file);
+        return NULL;
+    }
+    if ((size)&&(fread(data,size,1,file) != 1))
+    {
+        slog("failed to read %s",filename);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *fileSize = size;
+    return data;
+}
+
+void gfcpak_collect(const char *root,const char *relative)
+{
+    DIR *dir;
+    struct dirent *item;
+    struct stat fileStat;
+    TextBlock fullPath,itemPath;
+    PakBuildEntry *entry;
+    if (strlen(relative))snprintf(fullPath,GFCTEXTLEN,"%s/%s",root,relative);
+    else gfc_block_cpy(fullPath,root);
+    dir = opendir(fullPath);
+    if (!dir)
+    {
+        slog("failed to open directory %s",fullPath);
+        return;
+    }
+    while ((item = readdir(dir)) != NULL)
+    {
+        if ((strcmp(item->d_name,".") == 0)||(strcmp(item->d_name,"..") == 0))continue;
+        if (strlen(relative))snprintf(itemPath,GFCTEXTLEN,"%s/%s",relative,item->d_name);
+        else gfc_block_cpy(itemPath,item->d_name);
+        snprintf(fullPath,GFCTEXTLEN,"%s/%s",root,itemPath);
+        if (stat(fullPath,&fileStat) != 0)continue;
+        if (S_ISDIR(fileStat.st_mode))
+        {
+            gfcpak_collect(root,itemPath);
+            continue;
+        }
+        if (!S_ISREG(fileStat.st_mode))continue;
+        if (strcmp(itemPath,GFC_PAK_INDEX_NAME) == 0)continue;
+        entry = gfc_allocate_array(sizeof(PakBuildEntry),1);
+        if (!entry)continue;
+        gfc_block_cpy(entry->path,itemPath);
+        builder.entries = gfc_list_append(builder.entries,entry);
+    }
+    closedir(dir);
+}
+
+void gfcpak_load_manifest(const char *filename)
+{
+    SJson *json,*groups,*group,*files;
+    PakBuildRule *rule;
+    const char *text;
+    int i,c,j,d;
+    json = sj_load(filename);
+    if (!json)
+    {
+        slog("failed to load manifest %s",filename);
+        return;
+    }
+    groups = sj_object_get_value(json,"groups");
+    c = sj_array_get_count(groups);
+    for (i = 0; i < c; i++)
+    {
+        group = sj_array_get_nth(groups,i);
+        if (!group)continue;
+        files = sj_object_get_value(group,"files");
+        d = sj_array_get_count(files);
+        for (j = 0; j < d; j++)
+        {
+            text = sj_get_string_value(sj_array_get_nth(files,j));
+            if (!text)continue;
+            rule = gfc_allocate_array(sizeof(PakBuildRule),1);
+            if (!rule)continue;
+            gfc_block_cpy(rule->rule,text);
+            rule->group = builder.groupCount;
+            builder.rules = gfc_list_append(builder.rules,rule);
+        }
+        builder.groupCount++;
+    }
+    sj_free(json);
+}
+
+void gfcpak_assign_group(PakBuildEntry *entry)
+{
+    PakBuildRule *rule;
+    size_t length;
+    int i,c;
+    entry->group = builder.groupCount;
+    entry->rule = GFCPAK_NO_RULE;
+    c = gfc_list_get_count(builder.rules);
+    for (i = 0; i < c; i++)
+    {
+        rule = gfc_list_get_nth(builder.rules,i);
+        if (!rule)continue;
+        length = strlen(rule->rule);
+        if (!length)continue;
+        if (rule->rule[length - 1] == '/')
+        {
+            if (strncmp(entry->path,rule->rule,length) != 0)continue;
+        }
+        else if (strcmp(entry->path,rule->rule) != 0)continue;
+        entry->group = rule->group;
+        entry->rule = i;
+        return;
+    }
+}
+
+int gfcpak_entry_compare(const void *a,const void *b)
+{
+    const PakBuildEntry *A = *(const PakBuildEntry **)a;
+    const PakBuildEntry *B = *(const PakBuildEntry **)b;
+    if (A->group != B->group)return (A->group < B->group)?-1:1;
+    if (A->rule != B->rule)return (A->rule < B->rule)?-1:1;
+    return gfc_pak_index_name_cmp(A->path,B->path);
+}
+
+int gfcpak_write_local_header(
+    const char *name,
+    Uint16 method,
+    Uint32 crc,
+    Uint64 compSize,
+    Uint64 uncompSize,
+    Uint32 padding)
+{
+    Uint8 header[GFCPAK_LOCAL_HEADER_SIZE];
+    Uint8 extra[6] = {0};
+    Uint8 zero[256] = {0};
+    Uint32 nameLength = strlen(name);
+    Uint32 remaining,chunk;
+    gfcpak_put_u32(&header[0],0x04034b50);
+    gfcpak_put_u16(&header[4],20);          //version needed
+    gfcpak_put_u16(&header[6],0);           //flags
+    gfcpak_put_u16(&header[8],method);
+    gfcpak_put_u16(&header[10],0);          //time
+    gfcpak_put_u16(&header[12],0x21);       //date: 1980-01-01 so builds are reproducible
+    gfcpak_put_u32(&header[14],crc);
+    gfcpak_put_u32(&header[18],(Uint32)compSize);
+    gfcpak_put_u32(&header[22],(Uint32)uncompSize);
+    gfcpak_put_u16(&header[26],nameLength);
+    gfcpak_put_u16(&header[28],padding);
+    if (!gfcpak_write(header,GFCPAK_LOCAL_HEADER_SIZE))return 0;
+    if (!gfcpak_write(name,nameLength))return 0;
+    if (!padding)return 1;
+    gfcpak_put_u16(&extra[0],GFCPAK_ALIGN_EXTRA_ID);
+    gfcpak_put_u16(&extra[2],padding - 4);
+    gfcpak_put_u16(&extra[4],builder.alignment);
+    if (!gfcpak_write(extra,6))return 0;
+    for (remaining = padding - 6; remaining > 0; remaining -= chunk)
+    {
+        chunk = MIN(remaining,sizeof(zero));
+        if (!gfcpak_write(zero,chunk))return 0;
+    }
+    return 1;
+}
+
+int gfcpak_write_central_header(
+    const char *name,
+    Uint16 method,
+    Uint32 crc,
+    Uint64 compSize,
+    Uint64 uncompSize,
+    Uint64 headerOffset)
+{
+    Uint8 header[GFCPAK_CENTRAL_HEADER_SIZE] = {0};
+    Uint32 nameLength = strlen(name);
+    gfcpak_put_u32(&header[0],0x02014b50);
+    gfcpak_put_u16(&header[4],20);          //version made by
+    gfcpak_put_u16(&header[6],20);          //version needed
+    gfcpak_put_u16(&header[10],method);
+    gfcpak_put_u16(&header[14],0x21);
+    gfcpak_put_u32(&header[16],crc);
+    gfcpak_put_u32(&header[20],(Uint32)compSize);
+    gfcpak_put_u32(&header[24],(Uint32)uncompSize);
+    gfcpak_put_u16(&header[28],nameLength);
+    gfcpak_put_u32(&header[42],(Uint32)headerOffset);
+    if (!gfcpak_write(header,GFCPAK_CENTRAL_HEADER_SIZE))return 0;
+    return gfcpak_write(name,nameLength);
+}
+
+Uint32 gfcpak_get_padding(Uint64 headerOffset,const char *name)
+{
+    Uint64 dataOffset;
+    Uint32 padding;
+    if (builder.alignment <= 1)return 0;
+    dataOffset = headerOffset + GFCPAK_LOCAL_HEADER_SIZE + strlen(name);
+    padding = (builder.alignment - (dataOffset % builder.alignment)) % builder.alignment;
+    if ((padding)&&(padding < 6))padding += builder.alignment;// need room for the extra field header
+    return padding;
+}
+
+void *gfcpak_compress(const void *data,size_t size,Uint16 *method,size_t *compSize)
+{
+    void *compressed = NULL;
+    size_t capacity,limit;
+    limit = (size_t)(size * builder.ratio);
+    if (builder.codec == PBC_LZ4)
+    {
+        capacity = gfc_lz4_compress_bound(size);
+        compressed = malloc(capacity);
+        if (compressed)
+        {
+            *compSize = gfc_lz4_compress(data,size,compressed,capacity);
+            if ((*compSize)&&(*compSize <= limit))
+            {
+                *method = GFC_PAK_METHOD_LZ4;
+                return compressed;
+            }
+            free(compressed);
+        }
+    }
+    //deflate compresses better than lz4, so it is the fallback when lz4 does not pay off
+    compressed = tdefl_compress_mem_to_heap(data,size,compSize,TDEFL_DEFAULT_MAX_PROBES);
+    if (!compressed)return NULL;
+    if (*compSize <= limit)
+    {
+        *method = MZ_DEFLATED;
+        return compressed;
+    }
+    mz_free(compressed);
+    return NULL;
+}
+
+int gfcpak_write_entry(const char *root,PakBuildEntry *entry)
+{
+    TextBlock fullPath;
+    void *data,*compressed = NULL;
+    const void *output;
+    size_t size,compSize = 0;
+    Uint32 padding = 0;
+    snprintf(fullPath,GFCTEXTLEN,"%s/%s",root,entry->path);
+    data = gfcpak_read_file(fullPath,&size);
+    if (!data)return 0;
+    entry->uncompSize = size;
+    entry->crc32 = (Uint32)mz_crc32(MZ_CRC32_INIT,data,size);
+    entry->method = 0;
+    if (size)
+    {
+        compressed = gfcpak_compress(data,size,&entry->method,&compSize);
+    }
+    if (compressed)
+    {
+        entry->compSize = compSize;
+        output = compressed;
+    }
+    else
+    {
+        entry->compSize = size;
+        output = data;
+        if (size >= builder.alignment)
+        {
+            //anything smaller than a page gains nothing from alignment
+            padding = gfcpak_get_padding(builder.offset,entry->path);
+        }
+    }
+    entry->headerOffset = builder.offset;
+    if (gfcpak_write_local_header(entry->path,entry->method,entry->crc32,entry->compSize,entry->uncompSize,padding))
+    {
+        entry->dataOffset = builder.offset;
+        if (!gfcpak_write(output,entry->compSize))entry->dataOffset = 0;
+    }
+    if (compressed)free(compressed);// both codecs allocate with malloc
+    free(data);
+    return entry->dataOffset != 0;
+}
+
+int gfcpak_build(const char *root,const char *output)
+{
+    GFC_PakIndex *index;
+    GFC_PakIndexRecord record;
+    PakBuildEntry *entry;
+    TextBlock temp;
+    Uint8 end[GFCPAK_END_RECORD_SIZE] = {0};
+    Uint32 namePoolSize = 0,indexCrc;
+    Uint64 centralOffset,indexDataOffset;
+    Uint64 totalSize = 0,totalComp = 0;
+    int i,c,compressed = 0;
+
+    gfcpak_collect(root,"");
+    c = gfc_list_get_count(builder.entries);
+    if (!c)
+    {
+        slog("no files found in %s",root);
+        return 0;
+    }
+    if (c + 1 > 0xFFFF)
+    {
+        slog("too many files for a pak: %i",c);
+        return 0;
+    }
+    for (i = 0; i < c; i++)
+    {
+        entry = gfc_list_get_nth(builder.entries,i);
+        gfcpak_assign_group(entry);
+        namePoolSize += strlen(entry->path) + 1;
+    }
+    qsort(builder.entries->elements,c,sizeof(ListElementData),gfcpak_entry_compare);
+
+    index = gfc_pak_index_new(c,namePoolSize);
+    if (!index)return 0;
+    //written beside the output and renamed over it, so a game reading the old pak never sees a half written one
+    gfc_block_sprintf(temp,"%s.tmp",output);
+    builder.file = fopen(temp,"wb");
+    if (!builder.file)
+    {
+        slog("failed to open %s for writing",temp);
+        gfc_pak_index_free(index);
+        return 0;
+    }
+    //reserve the index entry at the front, it is filled in once the entry offsets are known
+    if (!gfcpak_write_local_header(GFC_PAK_INDEX_NAME,0,0,index->size,index->size,0))goto fail;
+    indexDataOffset = builder.offset;
+    if (!gfcpak_write(index->data,index->size))goto fail;
+
+    for (i = 0; i < c; i++)
+    {
+        entry = gfc_list_get_nth(builder.entries,i);
+        if (!gfcpak_write_entry(root,entry))goto fail;
+        if (builder.offset > 0xFFFFFFFF)
+        {
+            slog("pak is larger than 4GB, which is not supported");
+            goto fail;
+        }
+        memset(&record,0,sizeof(GFC_PakIndexRecord));
+        record.method = entry->method;
+        record.crc32 = entry->crc32;
+        record.group = entry->group;
+        record.fileIndex = i + 1;   //the index entry is first in the central directory
+        record.dataOffset = entry->dataOffset;
+        record.compSize = entry->compSize;
+        record.uncompSize = entry->uncompSize;
+        gfc_pak_index_add(index,entry->path,&record);
+        totalSize += entry->uncompSize;
+        totalComp += entry->compSize;
+        if (entry->method)compressed++;
+    }
+    gfc_pak_index_finalize(index);
+    indexCrc = (Uint32)mz_crc32(MZ_CRC32_INIT,index->data,index->size);
+
+    centralOffset = builder.offset;
+    if (!gfcpak_write_central_header(GFC_PAK_INDEX_NAME,0,indexCrc,index->size,index->size,0))goto fail;
+    for (i = 0; i < c; i++)
+    {
+        entry = gfc_list_get_nth(builder.entries,i);
+        if (!gfcpak_write_central_header(entry->path,entry->method,entry->crc32,entry->compSize,entry->uncompSize,entry->headerOffset))goto fail;
+    }
+    gfcpak_put_u32(&end[0],0x06054b50);
+    gfcpak_put_u16(&end[8],c + 1);
+    gfcpak_put_u16(&end[10],c + 1);
+    gfcpak_put_u32(&end[12],(Uint32)(builder.offset - centralOffset));
+    gfcpak_put_u32(&end[16],(Uint32)centralOffset);
+    if (!gfcpak_write(end,GFCPAK_END_RECORD_SIZE))goto fail;
+
+    //now go back and fill in the index
+    fseek(builder.file,0,SEEK_SET);
+    builder.offset = 0;
+    if (!gfcpak_write_local_header(GFC_PAK_INDEX_NAME,0,indexCrc,index->size,index->size,0))goto fail;
+    fseek(builder.file,indexDataOffset,SEEK_SET);
+    if (!gfcpak_write(index->data,index->size))goto fail;
+    if (fclose(builder.file) != 0)
+    {
+        builder.file = NULL;
+        slog("failed to write %s",temp);
+        goto fail;
+    }
+    builder.file = NULL;
+    if (rename(temp,output) != 0)
+    {
+        slog("failed to replace %s",output);
+        goto fail;
+    }
+    gfc_pak_index_free(index);
+    printf("packed %i files (%i compressed) into %s: %lu bytes -> %lu bytes\n",
+        c,compressed,output,(unsigned long)totalSize,(unsigned long)totalComp);
+    return 1;
+fail:
+    if (builder.file)fclose(builder.file);
+    builder.file = NULL;
+    gfc_pak_index_free(index);
+    remove(temp);
+    return 0;
+}
+
+typedef struct
+{
+    const char *name;
+    Uint32 files;
+    Uint64 compBytes;
+    Uint64 uncompBytes;
+    Uint64 decodeTicks;     /**<time spent decoding, over all passes*/
+    Uint64 loadTicks;       /**<time spent reading and decoding each entry once*/
+}PakBenchMethod;
+
+int gfcpak_bench(const char *filename)
+{
+    mz_zip_archive zip;
+    mz_zip_archive_file_stat stat;
+    PakBenchMethod methods[3] = {{"stored"},{"deflate"},{"lz4"}};
+    PakBenchMethod *method;
+    void *raw,*data;
+    Uint64 start,frequency;
+    Uint32 i,c,pass;
+    double seconds,loadSeconds = 0;
+    mz_zip_zero_struct(&zip);
+    if (!mz_zip_reader_init_file(&zip,filename,0))
+    {
+        slog("failed to open pak %s",filename);
+        return 0;
+    }
+    frequency = SDL_GetPerformanceFrequency();
+    c = mz_zip_reader_get_num_files(&zip);
+    for (i = 0; i < c; i++)
+    {
+        if (!mz_zip_reader_file_stat(&zip,i,&stat))continue;
+        if ((stat.m_is_directory)||(!stat.m_uncomp_size))continue;
+        if (strcmp(stat.m_filename,GFC_PAK_INDEX_NAME) == 0)continue;
+        if (stat.m_method == 0)method = &methods[0];
+        else if (stat.m_method == MZ_DEFLATED)method = &methods[1];
+        else if (stat.m_method == GFC_PAK_METHOD_LZ4)method = &methods[2];
+        else continue;
+        raw = malloc(stat.m_comp_size);
+        data = malloc(stat.m_uncomp_size);
+        if ((!raw)||(!data))
+        {
+            if (raw)free(raw);
+            if (data)free(data);
+            continue;
+        }
+        start = SDL_GetPerformanceCounter();
+        if ((!mz_zip_reader_extract_to_mem(&zip,i,raw,stat.m_comp_size,MZ_ZIP_FLAG_COMPRESSED_DATA))||
+            (gfc_pak_decode_data(stat.m_method,raw,stat.m_comp_size,data,stat.m_uncomp_size) != stat.m_uncomp_size))
+        {
+            slog("failed to decode %s",stat.m_filename);
+            free(raw);
+            free(data);
+            continue;
+        }
+        method->loadTicks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+        for (pass = 0; pass < GFCPAK_BENCH_PASSES; pass++)
+        {
+            gfc_pak_decode_data(stat.m_method,raw,stat.m_comp_size,data,stat.m_uncomp_size);
+        }
+        method->decodeTicks += SDL_GetPerformanceCounter() - start;
+        method->files++;
+        method->compBytes += stat.m_comp_size;
+        method->uncompBytes += stat.m_uncomp_size;
+        free(raw);
+        free(data);
+    }
+    mz_zip_reader_end(&zip);
+    printf("%-8s %8s %12s %12s %12s %10s\n","method","files","packed MB","loaded MB","decode MB/s","load ms");
+    for (i = 0; i < 3; i++)
+    {
+        method = &methods[i];
+        if (!method->files)continue;
+        seconds = (double)method->decodeTicks / frequency / GFCPAK_BENCH_PASSES;
+        loadSeconds += (double)method->loadTicks / frequency;
+        printf("%-8s %8u %12.2f %12.2f %12.1f %10.2f\n",
+            method->name,
+            method->files,
+            method->compBytes / 1048576.0,
+            method->uncompBytes / 1048576.0,
+            (seconds > 0)?(method->uncompBytes / 1048576.0) / seconds:0,
+            ((double)method->loadTicks / frequency) * 1000.0);
+    }
+    printf("total load time: %.2f ms\n",loadSeconds * 1000.0);
+    return 1;
+}
+
+typedef struct
+{
+    TextBlock name;
+    Uint32 crc[2];              /**<crc32 of the entry in each version of the pak*/
+    size_t size[2];             /**<extracted size of the entry in each version of the pak*/
+}PakStressEntry;
+
+typedef struct
+{
+    List *entries;              /**<PakStressEntry for every file in the pak*/
+    size_t largest;             /**<largest entry in either version*/
+    SDL_atomic_t running;       /**<workers that have not finished yet*/
+    SDL_atomic_t checks;
+    SDL_atomic_t failures;
+}PakStressJob;
+
+/**
+ * @brief check extracted data matches one version of an entry exactly
+ * whichever pak is mounted when the read starts, it must come back whole from that one version
+ */
+int gfcpak_stress_match(PakStressEntry *entry,size_t size,Uint32 crc)
+{
+    if ((size == entry->size[0])&&(crc == entry->crc[0]))return 1;
+    if ((size == entry->size[1])&&(crc == entry->crc[1]))return 1;
+    return 0;
+}
+
+Uint32 gfcpak_stress_entry(PakStressEntry *entry,Uint8 *buffer,size_t capacity)
+{
+    GFC_PakStream *stream;
+    Uint8 *data;
+    Uint32 crc,failures = 0;
+    size_t size,total,read;
+    data = gfc_pak_file_extract(entry->name,&size);
+    if ((!data)||(!gfcpak_stress_match(entry,size,(Uint32)mz_crc32(MZ_CRC32_INIT,data,size))))
+    {
+        slog("extract of %s returned bad data",entry->name);
+        failures++;
+    }
+    if (data)free(data);
+    size = gfc_pak_file_extract_into(entry->name,buffer,capacity);
+    if ((!size)||(!gfcpak_stress_match(entry,size,(Uint32)mz_crc32(MZ_CRC32_INIT,buffer,size))))
+    {
+        slog("extract into a buffer of %s returned bad data",entry->name);
+        failures++;
+    }
+    stream = gfc_pak_stream_open(entry->name);
+    if (!stream)
+    {
+        slog("failed to open a stream of %s",entry->name);
+        return failures + 1;
+    }
+    crc = MZ_CRC32_INIT;
+    total = 0;
+    while ((read = gfc_pak_stream_read(stream,buffer,GFCPAK_STRESS_CHUNK)) > 0)
+    {
+        crc = (Uint32)mz_crc32(crc,buffer,read);
+        total += read;
+    }
+    if ((gfc_pak_stream_failed(stream))||(!gfcpak_stress_match(entry,total,crc)))
+    {
+        slog("stream of %s returned bad data",entry->name);
+        failures++;
+    }
+    gfc_pak_stream_close(stream);
+    return failures;
+}
+
+int gfcpak_stress_worker(void *data)
+{
+    PakStressJob *job = data;
+    PakStressEntry *entry;
+    Uint8 *buffer;
+    size_t capacity = job->largest;
+    Uint32 round;
+    int i,c;
+    if (capacity < GFCPAK_STRESS_CHUNK)capacity = GFCPAK_STRESS_CHUNK;
+    c = gfc_list_get_count(job->entries);
+    buffer = malloc(capacity);
+    if (!buffer)
+    {
+        slog("failed to allocate a %lu byte buffer for a stress test thread",(unsigned long)capacity);
+        SDL_AtomicAdd(&job->failures,1);
+        SDL_AtomicAdd(&job->running,-1);
+        return 0;
+    }
+    for (round = 0; round < GFCPAK_STRESS_ROUNDS; round++)
+    {
+        for (i = 0; i < c; i++)
+        {
+            entry = gfc_list_get_nth(job->entries,i);
+            if (!entry)continue;
+            SDL_AtomicAdd(&job->failures,gfcpak_stress_entry(entry,buffer,capacity));
+            SDL_AtomicAdd(&job->checks,3);
+        }
+    }
+    free(buffer);
+    SDL_AtomicAdd(&job->running,-1);
+    return 0;
+}
+
+/**
+ * @brief write a whole file out beside path and rename it over path, the way gfcpak replaces a pak
+ */
+int gfcpak_stress_replace(const char *path,const void *data,size_t size)
+{
+    TextBlock temp;
+    FILE *file;
+    int written;
+    gfc_block_sprintf(temp,"%s.tmp",path);
+    file = fopen(temp,"wb");
+    if (!file)
+    {
+        slog("failed to open %s for writing",temp);
+        return 0;
+    }
+    written = (fwrite(data,1,size,file) == size);
+    if (fclose(file) != 0)written = 0;
+    if ((!written)||(rename(temp,path) != 0))
+    {
+        slog("failed to replace %s",path);
+        remove(temp);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief read a whole file into memory
+ * @note free the result with free()
+ */
+void *gfcpak_stress_read(const char *path,size_t *size)
+{
+    FILE *file;
+    Uint8 *data;
+    long length;
+    file = fopen(path,"rb");
+    if (!file)
+    {
+        slog("failed to open %s",path);
+        return NULL;
+    }
+    fseek(file,0,SEEK_END);
+    length = ftell(file);
+    fseek(file,0,SEEK_SET);
+    data = (length > 0)?malloc(length):NULL;
+    if ((!data)||(fread(data,1,length,file) != (size_t)length))
+    {
+        slog("failed to read %s",path);
+        if (data)free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+}
+
+/**
+ * @brief build a second version of the mounted pak where every entry has one more byte, so every size and crc differs
+ * @note free the result with free()
+ */
+void *gfcpak_stress_build_changed(PakStressJob *job,size_t *size)
+{
+    mz_zip_archive zip;
+    PakStressEntry *entry;
+    Uint8 *data,*changed;
+    void *pak = NULL;
+    size_t length;
+    int i,c;
+    mz_zip_zero_struct(&zip);
+    if (!mz_zip_writer_init_heap(&zip,0,0))return NULL;
+    c = gfc_list_get_count(job->entries);
+    for (i = 0; i < c; i++)
+    {
+        entry = gfc_list_get_nth(job->entries,i);
+        if (!entry)continue;
+        data = gfc_pak_file_extract(entry->name,&length);
+        if (!data)
+        {
+            slog("failed to extract %s",entry->name);
+            goto fail;
+        }
+        changed = realloc(data,length + 1);
+        if (!changed)
+        {
+            free(data);
+            goto fail;
+        }
+        changed[length] = (Uint8)(i + 1);
+        entry->size[1] = length + 1;
+        entry->crc[1] = (Uint32)mz_crc32(MZ_CRC32_INIT,changed,length + 1);
+        if (entry->size[1] > job->largest)job->largest = entry->size[1];
+        if (!mz_zip_writer_add_mem(&zip,entry->name,changed,length + 1,MZ_BEST_SPEED))
+        {
+            slog("failed to add %s to the changed pak",entry->name);
+            free(changed);
+            goto fail;
+        }
+        free(changed);
+    }
+    if (!mz_zip_writer_finalize_heap_archive(&zip,&pak,size))pak = NULL;
+fail:
+    mz_zip_writer_end(&zip);
+    return pak;
+}
+
+int gfcpak_stress(const char *filename,int threadCount)
+{
+    SDL_Thread *threads[GFCPAK_STRESS_MAX_THREADS] = {0};
+    mz_zip_archive zip;
+    mz_zip_archive_file_stat stat;
+    PakStressJob job;
+    PakStressEntry *entry;
+    TextBlock working;
+    void *versions[2] = {NULL,NULL};
+    size_t sizes[2] = {0,0};
+    Uint64 start;
+    Uint32 i,c,reloads = 0;
+    int failures;
+    if (threadCount < 1)threadCount = 1;
+    if (threadCount > GFCPAK_STRESS_MAX_THREADS)threadCount = GFCPAK_STRESS_MAX_THREADS;
+    memset(&job,0,sizeof(PakStressJob));
+    //the expected crc of each entry comes straight from the zip, not from the pak's index
+    mz_zip_zero_struct(&zip);
+    if (!mz_zip_reader_init_file(&zip,filename,0))
+    {
+        slog("failed to open pak %s",filename);
+        return 0;
+    }
+    job.entries = gfc_list_new();
+    c = mz_zip_reader_get_num_files(&zip);
+    for (i = 0; i < c; i++)
+    {
+        if (!mz_zip_reader_file_stat(&zip,i,&stat))continue;
+        if ((stat.m_is_directory)||(!stat.m_uncomp_size))continue;
+        if (strcmp(stat.m_filename,GFC_PAK_INDEX_NAME) == 0)continue;
+        if (strlen(stat.m_filename) >= GFCTEXTLEN)continue;
+        entry = gfc_allocate_array(sizeof(PakStressEntry),1);
+        if (!entry)continue;
+        gfc_block_cpy(entry->name,stat.m_filename);
+        entry->crc[0] = stat.m_crc32;
+        entry->size[0] = stat.m_uncomp_size;
+        if (entry->size[0] > job.largest)job.largest = entry->size[0];
+        job.entries = gfc_list_append(job.entries,entry);
+    }
+    mz_zip_reader_end(&zip);
+    //the workers read a copy, which is rewritten with different content while they run
+    gfc_block_sprintf(working,"%s.stress",filename);
+    versions[0] = gfcpak_stress_read(filename,&sizes[0]);
+    if ((!versions[0])||(!gfcpak_stress_replace(working,versions[0],sizes[0])))
+    {
+        if (versions[0])free(versions[0]);
+        gfc_list_foreach(job.entries,free);
+        gfc_list_delete(job.entries);
+        return 0;
+    }
+    gfc_pak_manager_init();
+    gfc_pak_manager_set_override_policy(POP_PakOnly);//loose files with the same names would not match the crcs
+    gfc_pak_manager_add(working);
+    versions[1] = gfcpak_stress_build_changed(&job,&sizes[1]);
+    if (!versions[1])
+    {
+        slog("failed to build a changed copy of %s",filename);
+        SDL_AtomicAdd(&job.failures,1);
+        SDL_AtomicSet(&job.running,0);
+        threadCount = 0;
+    }
+    start = SDL_GetPerformanceCounter();
+    if (threadCount)SDL_AtomicSet(&job.running,threadCount);
+    for (i = 0; i < (Uint32)threadCount; i++)
+    {
+        threads[i] = SDL_CreateThread(gfcpak_stress_worker,"gfcpak_stress",&job);
+        if (threads[i])continue;
+        slog("failed to start stress test thread %i",i);
+        SDL_AtomicAdd(&job.running,-1);
+    }
+    //swap the two versions of the pak out from under the workers for as long as they run
+    while (SDL_AtomicGet(&job.running) > 0)
+    {
+        if (!gfcpak_stress_replace(working,versions[(reloads + 1) % 2],sizes[(reloads + 1) % 2]))
+        {
+            SDL_AtomicAdd(&job.failures,1);
+            break;
+        }
+        if (!gfc_pak_manager_reload(working))
+        {
+            slog("pak %s is not mounted, it cannot be reloaded",working);
+            SDL_AtomicAdd(&job.failures,1);
+            break;
+        }
+        reloads++;
+    }
+    for (i = 0; i < (Uint32)threadCount; i++)
+    {
+        if (threads[i])SDL_WaitThread(threads[i],NULL);
+    }
+    failures = SDL_AtomicGet(&job.failures);
+    printf("%i threads, %u entries, %i checks, %u reloads, %i failures in %.2f s\n",
+        threadCount,
+        gfc_list_get_count(job.entries),
+        SDL_AtomicGet(&job.checks),
+        reloads,
+        failures,
+        (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency());
+    remove(working);
+    free(versions[0]);
+    if (versions[1])free(versions[1]);
+    gfc_list_foreach(job.entries,free);
+    gfc_list_delete(job.entries);
+    return failures == 0;
+}
+
+void gfcpak_usage()
+{
+    printf("usage: gfcpak [-m manifest.json] [-r ratio] [-a alignment] [-c deflate|lz4] <input directory> <output pak>\n");
+    printf("       gfcpak -b <pak>\n");
+    printf("       gfcpak -t <pak> <threads>\n");
+    printf("  -m  json manifest listing load order groups\n");
+    printf("  -r  only deflate files that compress to this fraction of their size or less (default 0.9)\n");
+    printf("  -a  alignment of stored file data at least this large (default 4096, 1 to disable)\n");
+    printf("  -c  preferred codec.  lz4 decodes faster, deflate is used when lz4 does not meet the ratio (default deflate)\n");
+    printf("  -b  benchmark decoding every entry of an existing pak\n");
+    printf("  -t  extract and stream every entry of an existing pak from several threads while a copy of it is rewritten and reloaded, checking every crc\n");
+}
+
+int main(int argc,char *argv[])
+{
+    const char *manifest = NULL;
+    const char *input = NULL;
+    const char *output = NULL;
+    int i,result;
+    builder.ratio = 0.9;
+    builder.alignment = 4096;
+    for (i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i],"-m") == 0)&&(i + 1 < argc))manifest = argv[++i];
+        else if ((strcmp(argv[i],"-r") == 0)&&(i + 1 < argc))builder.ratio = atof(argv[++i]);
+        else if ((strcmp(argv[i],"-a") == 0)&&(i + 1 < argc))builder.alignment = atoi(argv[++i]);
+        else if ((strcmp(argv[i],"-c") == 0)&&(i + 1 < argc))
+        {
+            i++;
+            if (strcmp(argv[i],"lz4") == 0)builder.codec = PBC_LZ4;
+            else if (strcmp(argv[i],"deflate") == 0)builder.codec = PBC_Deflate;
+            else
+            {
+                gfcpak_usage();
+                return 1;
+            }
+        }
+        else if ((strcmp(argv[i],"-b") == 0)&&(i + 1 < argc))return gfcpak_bench(argv[++i])?0:1;
+        else if ((strcmp(argv[i],"-t") == 0)&&(i + 2 < argc))return gfcpak_stress(argv[i + 1],atoi(argv[i + 2]))?0:1;
+        else if (!input)input = argv[i];
+        else if (!output)output = argv[i];
+        else
+        {
+            gfcpak_usage();
+            return 1;
+        }
+    }
+    if ((!input)||(!output)||(builder.alignment > 0xFFFF))
+    {
+        gfcpak_usage();
+        return 1;
+    }
+    builder.entries = gfc_list_new();
+    builder.rules = gfc_list_new();
+    if (manifest)gfcpak_load_manifest(manifest);
+    result = gfcpak_build(input,output);
+    gfc_list_foreach(builder.entries,free);
+    gfc_list_delete(builder.entries);
+    gfc_list_foreach(builder.rules,free);
+    gfc_list_delete(builder.rules);
+    return result?0:1;
+}
+
+/*eol@eof*/